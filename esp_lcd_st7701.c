@@ -5,47 +5,235 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <stdio.h>
+#include <inttypes.h>
+#include <stdatomic.h>
+#include "sdkconfig.h"
 #include "soc/soc_caps.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "driver/gpio.h"
+#if SOC_PPA_SUPPORTED
+#include "driver/ppa.h"
+#endif
 #include "esp_check.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_cache.h"
 #include "esp_lcd_panel_commands.h"
 #include "esp_lcd_panel_interface.h"
 #include "esp_lcd_panel_io.h"
 #include "esp_lcd_mipi_dsi.h"
+#include "hal/mipi_dsi_ll.h"
+#include "hal/mipi_dsi_host_ll.h"
+#include "hal/mipi_dsi_brg_ll.h"
 #include "esp_lcd_panel_vendor.h"
 #include "esp_log.h"
+#include "nvs.h"
 #include "esp_lcd_st7701.h"
 
 #define ST7701_CMD_BGR_BIT         (1ULL << 3)
 #define ST7701_CMD_ML_BIT          (1ULL << 4)
 #define ST7701_MDCTL_VALUE_DEFAULT (0x00)
 
+#define ST7701_RDDPM_BSTON         (1 << 7) // Booster on
+#define ST7701_RDDPM_SLPOUT        (1 << 4) // Sleep out
+#define ST7701_RDDPM_DISON         (1 << 2) // Display on
+#define ST7701_READY_POLL_MS       (5)      // Interval of the ready polls, also the minimum wait after SLPOUT
+
+#define ST7701_NVS_NAMESPACE       "st7701"     // NVS namespace of the warm start signature
+#define ST7701_NVS_KEY_INIT_CRC    "init_crc"   // CRC of the last full initialization, see `panel_st7701_init_crc()`
+
+#define ST7701_CMD_CND2BKxSEL      (0xFF)   // Command2 BKx selection
+#define ST7701_CMD_PVGAMCTRL       (0xB0)   // Positive voltage gamma control, in BK0
+#define ST7701_CMD_NVGAMCTRL       (0xB1)   // Negative voltage gamma control, in BK0
+#define ST7701_CMD_SDIR            (0xC7)   // Source direction control, in BK0
+#define ST7701_CMD_LNESET          (0xC0)   // Display line setting, in BK0
+#define ST7701_CMD_PORCTRL         (0xC1)   // Porch control, in BK0
+#define ST7701_CMD_INVSET          (0xC2)   // Inversion selection and frame rate control, in BK0
+#define ST7701_SDIR_SS_BIT         (1 << 2) // Source output scan direction
+#define ST7701_BANK_REGULAR        (0x00)
+#define ST7701_BANK_CMD2_BK0       (0x10)
+#define ST7701_PORCTRL_MAX         (0xFF)   // PORCTRL takes the porches in lines, one byte each
+#define ST7701_DSI_VFP_MAX         (1023)   // width of the vertical front porch in the DSI host's DPI timing
+
+typedef struct {
+    uint8_t bank;                       // selected Command2 bank
+    uint8_t madctl;
+    uint8_t colmod;
+    bool inverted;
+    uint8_t sdir;
+    uint8_t porctrl[2];
+    uint8_t pvgamma[16];
+    uint8_t nvgamma[16];
+    struct {
+        unsigned int bank: 1;
+        unsigned int madctl: 1;
+        unsigned int colmod: 1;
+        unsigned int inversion: 1;
+        unsigned int pvgamma: 1;
+        unsigned int nvgamma: 1;
+        unsigned int sdir: 1;
+        unsigned int porctrl: 1;
+    } valid;                            // which of the above are known to match the panel
+    uint32_t writes_sent;
+    uint32_t writes_elided;
+} st7701_shadow_regs_t;
+
 typedef struct {
     esp_lcd_panel_io_handle_t io;
     int reset_gpio_num;
     uint8_t madctl_val; // save current value of LCD_CMD_MADCTL register
     uint8_t colmod_val; // save current value of LCD_CMD_COLMOD register
+    uint8_t sdir_val;   // save current value of ST7701_CMD_SDIR register
+    uint8_t lneset_val[2];  // LNESET for the vertical resolution, the line count is valid if `flags.lneset` is set
+    uint8_t bits_per_pixel;
+    uint32_t h_res;
+    uint32_t v_res;
+    uint8_t num_fbs;
+    esp_lcd_dsi_bus_handle_t dsi_bus;
+    int dsi_bus_id;     // ID `dsi_bus` was created with, to reach its host and bridge registers
+    esp_lcd_dpi_panel_config_t dpi_config;  // to create the MIPI DPI panel again with another pixel format
+    esp_lcd_dpi_panel_event_callbacks_t dpi_cbs;    // application callbacks, called from the driver's own
+    void *dpi_cbs_ctx;
     const st7701_lcd_init_cmd_t *init_cmds;
     uint16_t init_cmds_size;
+    const uint8_t *init_bytecode;
+    size_t init_bytecode_size;
+    st7701_lcd_init_cmd_t *vendor_cmds;     // vendor sequence as sent: `init_cmds`, `init_bytecode` or the default table, optimized
+    uint16_t vendor_cmds_size;
+    st7701_init_optimize_stats_t vendor_cmds_stats;
     uint8_t lane_num;
+    st7701_timing_t timing;                 // valid if `flags.timing` is set
     struct {
         unsigned int reset_level: 1;
+        unsigned int poll_ready: 1;
+        unsigned int warm_start: 1;         // skip reset and init if the panel is already configured
+        unsigned int warm: 1;               // the last reset found the panel configured
+        unsigned int dpi_started: 1;        // the MIPI DPI panel has been initialized
+        unsigned int timing: 1;             // override the timing registers of the initialization sequence
+        unsigned int lneset: 1;             // override the line count in LNESET of the default sequence
+        unsigned int default_cmds: 1;       // the vendor sequence is the default one
     } flags;
+    struct {
+        const st7701_lcd_init_cmd_t *cmds;  // command table being sent
+        uint16_t cmds_size;
+        uint16_t index;                     // index of the next command in `cmds`
+        bool source_done;                   // table has been sent, continue with `tail`
+        st7701_lcd_init_cmd_t tail[5];      // registers managed by the driver, sent before DISPON or after the vendor sequence
+        uint8_t tail_size;
+        uint8_t tail_index;
+        st7701_lcd_init_cmd_t held;         // DISPON of the vendor sequence, held back while `tail` is sent
+        bool holding;
+        uint16_t sent;                      // number of commands sent so far
+        bool done;                          // all commands have been sent
+        struct {
+            int cmd;                        // command being waited for
+            uint8_t mask;                   // RDDPM bits that signal ready, 0 if not waiting
+            int64_t start_us;
+            uint32_t timeout_ms;            // delay programmed in the table
+        } wait;
+    } seq;
+#if CONFIG_ST7701_INIT_TRACE
+    struct {
+        st7701_init_trace_entry_t entries[CONFIG_ST7701_INIT_TRACE_DEPTH];
+        size_t head;                        // index of the next entry to write
+        size_t count;                       // number of valid entries
+        int64_t last_end_us;                // time the last traced command left the bus
+    } trace;
+#endif
+    st7701_shadow_regs_t shadow;            // registers as last written to the panel
+    struct {
+        esp_timer_handle_t timer;
+        esp_lcd_panel_t *panel;
+        esp_lcd_st7701_init_done_cb_t done_cb;
+        void *user_ctx;
+        atomic_bool busy;                   // an initialization is running, also read by other tasks
+    } async;
+    struct {
+        uint32_t idle_ms;                   // time without draws before dropping the refresh rate, 0 if disabled
+        uint32_t low_vfp;                   // vertical front porch of the low refresh rate, in lines
+        uint8_t porctrl[2];                 // PORCTRL of the configured refresh rate
+        bool low;                           // running at the low refresh rate
+        bool drawn;                         // something was drawn at the low refresh rate
+        int64_t last_draw_us;
+        int64_t mode_start_us;              // time the current rate was entered, 0 if not tracked
+        uint64_t mode_us[2];                // time spent at the high and low rate before `mode_start_us`
+        uint32_t switches;
+    } refresh;
+    void *fb;                               // frame buffer of the MIPI DPI panel, fetched on first use
+    struct {
+        void *fbs[3];                       // frame buffers being swapped, fetched on first use
+        int8_t front;                       // frame buffer being scanned out
+        int8_t pending;                     // frame buffer presented, scanned out from the next refresh on, -1 if none
+        uint32_t repeats;                   // refreshes that showed the front buffer
+        st7701_swap_stats_t stats;
+        portMUX_TYPE lock;                  // also protects `pacing`
+    } swap;
+#if CONFIG_ST7701_FRAME_STATS
+    struct {
+        int64_t submit_us;                  // time of the first draw since the last refresh, 0 if none
+        uint32_t repeats;                   // refreshes since the last frame was scanned out
+        st7701_frame_stats_t stats;
+    } pacing;
+#endif
+#if SOC_PPA_SUPPORTED
+    ppa_client_handle_t srm_client;         // PPA scale-rotate-mirror client, registered on first use
+    ppa_client_handle_t fill_client;        // PPA fill client, registered on first use
+    ppa_client_handle_t blend_client;       // PPA blend client, registered on first use
+    bool swap_xy;                           // bitmaps are transposed while they are drawn
+#endif
     // To save the original functions of MIPI DPI panel
     esp_err_t (*del)(esp_lcd_panel_t *panel);
     esp_err_t (*init)(esp_lcd_panel_t *panel);
+    esp_err_t (*draw_bitmap)(esp_lcd_panel_t *panel, int x_start, int y_start, int x_end, int y_end, const void *color_data);
 } st7701_panel_t;
 
 static const char *TAG = "ST7701";
 
+static esp_err_t panel_st7701_init_seq_start(st7701_panel_t *st7701);
+static esp_err_t panel_st7701_init_seq_next(st7701_panel_t *st7701, st7701_lcd_init_cmd_t *ret_cmd);
+static esp_err_t panel_st7701_init_seq_poll(st7701_panel_t *st7701, uint32_t *ret_delay_ms);
+static esp_err_t panel_st7701_init_seq_step(st7701_panel_t *st7701, uint32_t *ret_delay_ms);
+static void panel_st7701_apply_timing(st7701_panel_t *st7701, st7701_lcd_init_cmd_t *cmd);
+static esp_err_t panel_st7701_init_crc(st7701_panel_t *st7701, uint32_t *ret_crc);
+static void panel_st7701_init_crc_store(st7701_panel_t *st7701);
 static esp_err_t panel_st7701_send_init_cmds(st7701_panel_t *st7701);
+static void panel_st7701_init_async_cb(void *arg);
+static void panel_st7701_shadow_update(st7701_panel_t *st7701, int cmd, const void *param, size_t param_size);
+static bool panel_st7701_shadow_match(st7701_panel_t *st7701, int cmd, const void *param, size_t param_size);
+static bool panel_st7701_shadow_match_bank(st7701_panel_t *st7701, uint8_t bank, int cmd, const void *param, size_t param_size);
+static esp_err_t panel_st7701_write(st7701_panel_t *st7701, int cmd, const void *param, size_t param_size);
+static esp_err_t panel_st7701_write_bank(st7701_panel_t *st7701, uint8_t bank, int cmd, const void *param, size_t param_size);
+static void panel_st7701_shadow_reset(st7701_panel_t *st7701);
+static void panel_st7701_trace_start(st7701_panel_t *st7701);
+static void panel_st7701_trace_record(st7701_panel_t *st7701, const st7701_lcd_init_cmd_t *cmd, int64_t start_us, esp_err_t ret);
+static void panel_st7701_trace_finish(st7701_panel_t *st7701);
+static void panel_st7701_pacing_submit(st7701_panel_t *st7701);
 
+static esp_err_t panel_st7701_load_vendor_cmds(st7701_panel_t *st7701);
+static esp_err_t panel_st7701_colmod(int bits_per_pixel, uint8_t *ret_colmod);
+static void panel_st7701_attach(st7701_panel_t *st7701, esp_lcd_panel_t *panel);
 static esp_err_t panel_st7701_del(esp_lcd_panel_t *panel);
 static esp_err_t panel_st7701_init(esp_lcd_panel_t *panel);
 static esp_err_t panel_st7701_reset(esp_lcd_panel_t *panel);
 static esp_err_t panel_st7701_mirror(esp_lcd_panel_t *panel, bool mirror_x, bool mirror_y);
+static esp_err_t panel_st7701_draw_bitmap(esp_lcd_panel_t *panel, int x_start, int y_start, int x_end, int y_end,
+                                          const void *color_data);
+#if SOC_PPA_SUPPORTED
+static esp_err_t panel_st7701_swap_xy(esp_lcd_panel_t *panel, bool swap_axes);
+static esp_err_t panel_st7701_draw_bitmap_swapped(esp_lcd_panel_t *panel, int x_start, int y_start, int x_end, int y_end,
+                                                  const void *color_data);
+#endif
+static esp_err_t panel_st7701_dpi_replace(st7701_panel_t *st7701, esp_lcd_panel_handle_t *panel,
+                                          const esp_lcd_dpi_panel_config_t *config);
+static esp_err_t panel_st7701_refresh_switch(st7701_panel_t *st7701, bool low);
+static esp_err_t panel_st7701_get_fb(st7701_panel_t *st7701, esp_lcd_panel_t *panel, void **ret_fb);
+static esp_err_t panel_st7701_register_dpi_cbs(st7701_panel_t *st7701, esp_lcd_panel_t *panel);
+#if SOC_PPA_SUPPORTED
+static esp_err_t panel_st7701_get_srm_client(st7701_panel_t *st7701, ppa_client_handle_t *ret_client);
+#endif
 static esp_err_t panel_st7701_invert_color(esp_lcd_panel_t *panel, bool invert_color_data);
 
 esp_err_t esp_lcd_new_panel_st7701(const esp_lcd_panel_io_handle_t io, const esp_lcd_panel_dev_config_t *panel_dev_config,
@@ -70,6 +258,7 @@ esp_err_t esp_lcd_new_panel_st7701(const esp_lcd_panel_io_handle_t io, const esp
         ESP_GOTO_ON_ERROR(gpio_config(&io_conf), err, TAG, "configure GPIO for RST line failed");
     }
 
+    st7701->madctl_val = ST7701_MDCTL_VALUE_DEFAULT;
     switch (panel_dev_config->rgb_ele_order) {
     case LCD_RGB_ELEMENT_ORDER_RGB:
         st7701->madctl_val &= ~(ST7701_CMD_BGR_BIT);
@@ -82,44 +271,75 @@ esp_err_t esp_lcd_new_panel_st7701(const esp_lcd_panel_io_handle_t io, const esp
         break;
     }
 
-    switch (panel_dev_config->bits_per_pixel) {
-    case 16: // RGB565
-        st7701->colmod_val = 0x50;
-        break;
-    case 18: // RGB666
-        st7701->colmod_val = 0x60;
-        break;
-    case 24: // RGB888
-        st7701->colmod_val = 0x70;
-        break;
-    default:
-        ESP_GOTO_ON_FALSE(false, ESP_ERR_NOT_SUPPORTED, err, TAG, "unsupported pixel width");
-        break;
-    }
+    ESP_GOTO_ON_ERROR(panel_st7701_colmod(panel_dev_config->bits_per_pixel, &st7701->colmod_val), err, TAG,
+                      "unsupported pixel width");
 
     st7701->io = io;
+    st7701->bits_per_pixel = panel_dev_config->bits_per_pixel;
+    st7701->h_res = vendor_config->mipi_config.dpi_config->video_timing.h_size;
+    st7701->v_res = vendor_config->mipi_config.dpi_config->video_timing.v_size;
+    st7701->dsi_bus = vendor_config->mipi_config.dsi_bus;
+    st7701->dsi_bus_id = vendor_config->mipi_config.dsi_bus_id;
+    ESP_GOTO_ON_FALSE(st7701->dsi_bus_id >= 0 && st7701->dsi_bus_id < MIPI_DSI_LL_NUM_BUS, ESP_ERR_INVALID_ARG, err, TAG,
+                      "invalid MIPI DSI bus id %d", st7701->dsi_bus_id);
+    st7701->dpi_config = *vendor_config->mipi_config.dpi_config;
+    if (vendor_config->mipi_config.num_fbs) {
+        ESP_GOTO_ON_FALSE(vendor_config->mipi_config.num_fbs <= 3, ESP_ERR_INVALID_ARG, err, TAG, "too many frame buffers");
+        st7701->dpi_config.num_fbs = vendor_config->mipi_config.num_fbs;
+    }
+    st7701->num_fbs = st7701->dpi_config.num_fbs;
+    st7701->swap.pending = -1;
+    st7701->swap.lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
     st7701->init_cmds = vendor_config->init_cmds;
     st7701->init_cmds_size = vendor_config->init_cmds_size;
-    st7701->lane_num = vendor_config->mipi_config.lane_num;
+    st7701->init_bytecode = vendor_config->init_bytecode;
+    st7701->init_bytecode_size = vendor_config->init_bytecode_size;
+    ESP_GOTO_ON_ERROR(panel_st7701_load_vendor_cmds(st7701), err, TAG, "load init commands failed");
+    st7701->lane_num = vendor_config->mipi_config.lane_num ? vendor_config->mipi_config.lane_num : 2;
     st7701->reset_gpio_num = panel_dev_config->reset_gpio_num;
     st7701->flags.reset_level = panel_dev_config->flags.reset_active_high;
-    st7701->madctl_val = ST7701_MDCTL_VALUE_DEFAULT;
+    st7701->flags.poll_ready = vendor_config->flags.poll_ready;
+    st7701->flags.warm_start = vendor_config->flags.warm_start;
+    if (vendor_config->timing) {
+        st7701->timing = *vendor_config->timing;
+        st7701->flags.timing = 1;
+    }
+    // The panel has to expect as many lines as the MIPI DPI panel sends. A timing sets LNESET as a whole, otherwise the
+    // default sequence, written for 800 lines, gets the line count of the configuration. A custom sequence is written
+    // for its panel and sent as it is, as is a line count LNESET can't express.
+    if (!st7701->flags.timing && st7701->flags.default_cmds) {
+        if (st7701->v_res <= ST7701_MAX_V_RES && !(st7701->v_res % ST7701_LINE_STEP)) {
+            st7701->lneset_val[0] = st7701->v_res / ST7701_LINE_STEP - 1;
+            st7701->flags.lneset = 1;
+        } else {
+            ESP_LOGW(TAG, "%"PRIu32" lines is not a multiple of %d up to %d, LNESET is left to the init sequence",
+                     st7701->v_res, ST7701_LINE_STEP, ST7701_MAX_V_RES);
+        }
+    }
+    if (st7701->h_res > ST7701_MAX_H_RES) {
+        ESP_LOGW(TAG, "%"PRIu32" pixels per line is more than the %d sources of the ST7701", st7701->h_res, ST7701_MAX_H_RES);
+    }
+
+    uint32_t lane_bit_rate_mbps = 0;
+    if (esp_lcd_st7701_get_lane_bit_rate(vendor_config->mipi_config.dpi_config, st7701->lane_num, 0,
+                                         &lane_bit_rate_mbps) == ESP_OK) {
+        ESP_LOGI(TAG, "video stream needs %"PRIu32" Mbps per lane over %d lanes", lane_bit_rate_mbps, st7701->lane_num);
+        ESP_GOTO_ON_FALSE(!vendor_config->mipi_config.lane_bit_rate_mbps ||
+                          vendor_config->mipi_config.lane_bit_rate_mbps >= lane_bit_rate_mbps, ESP_ERR_INVALID_ARG, err, TAG,
+                          "lane bit rate of %"PRIu32" Mbps is too low", vendor_config->mipi_config.lane_bit_rate_mbps);
+    }
 
     // Create MIPI DPI panel
-    ESP_GOTO_ON_ERROR(esp_lcd_new_panel_dpi(vendor_config->mipi_config.dsi_bus, vendor_config->mipi_config.dpi_config, ret_panel), err, TAG,
+    ESP_GOTO_ON_ERROR(esp_lcd_new_panel_dpi(st7701->dsi_bus, &st7701->dpi_config, ret_panel), err, TAG,
                       "create MIPI DPI panel failed");
     ESP_LOGD(TAG, "new MIPI DPI panel @%p", *ret_panel);
 
-    // Save the original functions of MIPI DPI panel
-    st7701->del = (*ret_panel)->del;
-    st7701->init = (*ret_panel)->init;
-    // Overwrite the functions of MIPI DPI panel
-    (*ret_panel)->del = panel_st7701_del;
-    (*ret_panel)->init = panel_st7701_init;
-    (*ret_panel)->reset = panel_st7701_reset;
-    (*ret_panel)->mirror = panel_st7701_mirror;
-    (*ret_panel)->invert_color = panel_st7701_invert_color;
-    (*ret_panel)->user_data = st7701;
+    panel_st7701_attach(st7701, *ret_panel);
+    ret = panel_st7701_register_dpi_cbs(st7701, *ret_panel);
+    if (ret != ESP_OK) {
+        st7701->del(*ret_panel);
+        ESP_GOTO_ON_ERROR(ret, err, TAG, "register event callbacks failed");
+    }
     ESP_LOGD(TAG, "new st7701 panel @%p", st7701);
 
     return ESP_OK;
@@ -129,90 +349,482 @@ err:
         if (panel_dev_config->reset_gpio_num >= 0) {
             gpio_reset_pin(panel_dev_config->reset_gpio_num);
         }
+        free(st7701->vendor_cmds);
         free(st7701);
     }
     return ret;
 }
 
+static esp_err_t panel_st7701_colmod(int bits_per_pixel, uint8_t *ret_colmod)
+{
+    switch (bits_per_pixel) {
+    case 16: // RGB565
+        *ret_colmod = 0x50;
+        break;
+    case 18: // RGB666
+        *ret_colmod = 0x60;
+        break;
+    case 24: // RGB888
+        *ret_colmod = 0x70;
+        break;
+    default:
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    return ESP_OK;
+}
+
+static void panel_st7701_attach(st7701_panel_t *st7701, esp_lcd_panel_t *panel)
+{
+    // Save the original functions of MIPI DPI panel
+    st7701->del = panel->del;
+    st7701->init = panel->init;
+    st7701->draw_bitmap = panel->draw_bitmap;
+    // Overwrite the functions of MIPI DPI panel
+    panel->del = panel_st7701_del;
+    panel->init = panel_st7701_init;
+    panel->reset = panel_st7701_reset;
+    panel->mirror = panel_st7701_mirror;
+    panel->draw_bitmap = panel_st7701_draw_bitmap;
+#if SOC_PPA_SUPPORTED
+    panel->swap_xy = panel_st7701_swap_xy;
+#endif
+    panel->invert_color = panel_st7701_invert_color;
+    panel->user_data = st7701;
+}
+
 static const st7701_lcd_init_cmd_t vendor_specific_init_default[] = {
-    //  {cmd, { data }, data_size, delay_ms}
-    {0xFF,           (uint8_t []){0x77, 0x01, 0x00, 0x00, 0x00}, 5, 0},                                                                    // Regular command function
-    {LCD_CMD_NORON,  (uint8_t []){0x00}, 0, 0},                                                                                            // Turn on normal display mode
-    {0xEF,           (uint8_t []){0x08}, 1, 0},                                                                                            //
-
-    {0xFF,           (uint8_t []){0x77, 0x01, 0x00, 0x00, 0x10}, 5, 0},                                                                    // Command 2 BK0 function
-    {0xC0,           (uint8_t []){0x63, 0x00}, 2, 0},                                                                                      // LNESET (Display Line Setting): (0x63+1)*8 = 800 lines
-    {0xC1,           (uint8_t []){0x10, 0x02}, 2, 0},                                                                                      // PORCTRL (Porch Control): VBP = 16, VFP = 2
-    {0xC2,           (uint8_t []){0x37, 0x08}, 2, 0},                                                                                      // INVSET (Inversion sel. & frame rate control): PCLK=512+(8*16) = 640
-    {0xCC,           (uint8_t []){0x38}, 1, 0},                                                                                            //
-    {0xB0,           (uint8_t []){0x40, 0xC9, 0x90, 0x0D, 0x0F, 0x04, 0x00, 0x07, 0x07, 0x1C, 0x04, 0x52, 0x0F, 0xDF, 0x26, 0xCF}, 16, 0}, // PVGAMCTRL
-    {0xB1,           (uint8_t []){0x40, 0xC9, 0xCF, 0x0C, 0x90, 0x04, 0x00, 0x07, 0x08, 0x1B, 0x06, 0x55, 0x13, 0x62, 0xE7, 0xCF}, 16, 0}, // NVGAMCTRL
-
-    {0xFF,           (uint8_t []){0x77, 0x01, 0x00, 0x00, 0x11}, 5, 0},                                                                    // Command 2 BK1 function
-    {0xB0,           (uint8_t []){0x5D}, 1, 0},                                                                                            // VRHS
-    {0xB1,           (uint8_t []){0x2D}, 1, 0},                                                                                            // VCOMS
-    {0xB2,           (uint8_t []){0x07}, 1, 0},                                                                                            // VGH
-    {0xB3,           (uint8_t []){0x80}, 1, 0},                                                                                            // TESTCMD
-    {0xB5,           (uint8_t []){0x08}, 1, 0},                                                                                            // VGLS
-    {0xB7,           (uint8_t []){0x85}, 1, 0},                                                                                            // PWCTRL1
-    {0xB8,           (uint8_t []){0x20}, 1, 0},                                                                                            // PWCTRL2
-    {0xB9,           (uint8_t []){0x10}, 1, 0},                                                                                            // DGMLUTR
-    {0xC1,           (uint8_t []){0x78}, 1, 0},                                                                                            // SPD1
-    {0xC2,           (uint8_t []){0x78}, 1, 0},                                                                                            // SPD2
-    {0xD0,           (uint8_t []){0x88}, 1, 100},                                                                                          // MIPISET1
-    {0xE0,           (uint8_t []){0x00, 0x19, 0x02}, 3, 0},                                                                                //
-    {0xE1,           (uint8_t []){0x05, 0xA0, 0x07, 0xA0, 0x04, 0xA0, 0x06, 0xA0, 0x00, 0x44, 0x44}, 11, 0},                               //
-    {0xE2,           (uint8_t []){0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, 13, 0},                   //
-    {0xE3,           (uint8_t []){0x00, 0x00, 0x33, 0x33}, 5, 0},                                                                          //
-    {0xE4,           (uint8_t []){0x44, 0x44}, 2, 0},                                                                                      //
-    {0xE5,           (uint8_t []){0x0D, 0x31, 0xC8, 0xAF, 0x0F, 0x33, 0xC8, 0xAF, 0x09, 0x2D, 0xC8, 0xAF, 0x0B, 0x2F, 0xC8, 0xAF}, 16, 0}, //
-    {0xE6,           (uint8_t []){0x00, 0x00, 0x33, 0x33}, 4, 0},                                                                          //
-    {0xE7,           (uint8_t []){0x44, 0x44}, 2, 0},                                                                                      //
-    {0xE8,           (uint8_t []){0x0C, 0x30, 0xC8, 0xAF, 0x0E, 0x32, 0xC8, 0xAF, 0x08, 0x2C, 0xC8, 0xAF, 0x0A, 0x2E, 0xC8, 0xAF}, 16, 0}, //
-    {0xEB,           (uint8_t []){0x02, 0x00, 0xE4, 0xE4, 0x44, 0x00, 0x40}, 7, 0},                                                        //
-    {0xEC,           (uint8_t []){0x3C, 0x00}, 2, 0},                                                                                      //
-    {0xED,           (uint8_t []){0xAB, 0x89, 0x76, 0x54, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x10, 0x45, 0x67, 0x98, 0xBA}, 16, 0}, //
-
-    {0xFF,           (uint8_t []){0x77, 0x01, 0x00, 0x00, 0x00}, 5, 0},                                                                    // Regular command function
-    {LCD_CMD_SLPOUT, (uint8_t []){0x00}, 0, 120},                                                                                          // Exit sleep mode
-    {LCD_CMD_DISPON, (uint8_t []){0x00}, 0, 50},                                                                                           // Display on (enable frame buffer output)
+    //  ST7701_INIT_CMD(cmd, delay_ms, data...)
+    ST7701_INIT_CMD(0xFF, 0, 0x77, 0x01, 0x00, 0x00, 0x00),                                                                   // Regular command function
+    ST7701_INIT_CMD_NO_PARAM(LCD_CMD_NORON, 0),                                                                               // Turn on normal display mode
+    ST7701_INIT_CMD(0xEF, 0, 0x08),                                                                                           //
+
+    ST7701_INIT_CMD(0xFF, 0, 0x77, 0x01, 0x00, 0x00, 0x10),                                                                   // Command 2 BK0 function
+    ST7701_INIT_CMD(0xC0, 0, 0x63, 0x00),                                                                                     // LNESET (Display Line Setting): (0x63+1)*8 = 800 lines
+    ST7701_INIT_CMD(0xC1, 0, 0x10, 0x02),                                                                                     // PORCTRL (Porch Control): VBP = 16, VFP = 2
+    ST7701_INIT_CMD(0xC2, 0, 0x37, 0x08),                                                                                     // INVSET (Inversion sel. & frame rate control): PCLK=512+(8*16) = 640
+    ST7701_INIT_CMD(0xCC, 0, 0x38),                                                                                           //
+    ST7701_INIT_CMD(0xB0, 0, 0x40, 0xC9, 0x90, 0x0D, 0x0F, 0x04, 0x00, 0x07, 0x07, 0x1C, 0x04, 0x52, 0x0F, 0xDF, 0x26, 0xCF), // PVGAMCTRL
+    ST7701_INIT_CMD(0xB1, 0, 0x40, 0xC9, 0xCF, 0x0C, 0x90, 0x04, 0x00, 0x07, 0x08, 0x1B, 0x06, 0x55, 0x13, 0x62, 0xE7, 0xCF), // NVGAMCTRL
+
+    ST7701_INIT_CMD(0xFF, 0, 0x77, 0x01, 0x00, 0x00, 0x11),                                                                   // Command 2 BK1 function
+    ST7701_INIT_CMD(0xB0, 0, 0x5D),                                                                                           // VRHS
+    ST7701_INIT_CMD(0xB1, 0, 0x2D),                                                                                           // VCOMS
+    ST7701_INIT_CMD(0xB2, 0, 0x07),                                                                                           // VGH
+    ST7701_INIT_CMD(0xB3, 0, 0x80),                                                                                           // TESTCMD
+    ST7701_INIT_CMD(0xB5, 0, 0x08),                                                                                           // VGLS
+    ST7701_INIT_CMD(0xB7, 0, 0x85),                                                                                           // PWCTRL1
+    ST7701_INIT_CMD(0xB8, 0, 0x20),                                                                                           // PWCTRL2
+    ST7701_INIT_CMD(0xB9, 0, 0x10),                                                                                           // DGMLUTR
+    ST7701_INIT_CMD(0xC1, 0, 0x78),                                                                                           // SPD1
+    ST7701_INIT_CMD(0xC2, 0, 0x78),                                                                                           // SPD2
+    ST7701_INIT_CMD(0xD0, 100, 0x88),                                                                                         // MIPISET1
+    ST7701_INIT_CMD(0xE0, 0, 0x00, 0x19, 0x02),                                                                               //
+    ST7701_INIT_CMD(0xE1, 0, 0x05, 0xA0, 0x07, 0xA0, 0x04, 0xA0, 0x06, 0xA0, 0x00, 0x44, 0x44),                               //
+    ST7701_INIT_CMD(0xE2, 0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00),                   //
+    ST7701_INIT_CMD(0xE3, 0, 0x00, 0x00, 0x33, 0x33),                                                                         //
+    ST7701_INIT_CMD(0xE4, 0, 0x44, 0x44),                                                                                     //
+    ST7701_INIT_CMD(0xE5, 0, 0x0D, 0x31, 0xC8, 0xAF, 0x0F, 0x33, 0xC8, 0xAF, 0x09, 0x2D, 0xC8, 0xAF, 0x0B, 0x2F, 0xC8, 0xAF), //
+    ST7701_INIT_CMD(0xE6, 0, 0x00, 0x00, 0x33, 0x33),                                                                         //
+    ST7701_INIT_CMD(0xE7, 0, 0x44, 0x44),                                                                                     //
+    ST7701_INIT_CMD(0xE8, 0, 0x0C, 0x30, 0xC8, 0xAF, 0x0E, 0x32, 0xC8, 0xAF, 0x08, 0x2C, 0xC8, 0xAF, 0x0A, 0x2E, 0xC8, 0xAF), //
+    ST7701_INIT_CMD(0xEB, 0, 0x02, 0x00, 0xE4, 0xE4, 0x44, 0x00, 0x40),                                                       //
+    ST7701_INIT_CMD(0xEC, 0, 0x3C, 0x00),                                                                                     //
+    ST7701_INIT_CMD(0xED, 0, 0xAB, 0x89, 0x76, 0x54, 0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x10, 0x45, 0x67, 0x98, 0xBA), //
+
+    ST7701_INIT_CMD(0xFF, 0, 0x77, 0x01, 0x00, 0x00, 0x00),                                                                   // Regular command function
+    ST7701_INIT_CMD_NO_PARAM(LCD_CMD_SLPOUT, 120),                                                                            // Exit sleep mode
+    ST7701_INIT_CMD_NO_PARAM(LCD_CMD_DISPON, 50),                                                                             // Display on (enable frame buffer output)
 };
 
-static esp_err_t panel_st7701_send_init_cmds(st7701_panel_t *st7701)
+// Sent instead of the vendor sequence when the panel kept its configuration, see `panel_st7701_is_configured()`
+static const st7701_lcd_init_cmd_t vendor_specific_init_warm[] = {
+    ST7701_INIT_CMD_NO_PARAM(LCD_CMD_DISPON, 0), // Display on, in case it was turned off before the restart
+};
+
+esp_err_t esp_lcd_st7701_get_default_init_cmds(const st7701_lcd_init_cmd_t **init_cmds, uint16_t *init_cmds_size)
 {
-    esp_lcd_panel_io_handle_t io = st7701->io;
-    const st7701_lcd_init_cmd_t *init_cmds = NULL;
-    uint16_t init_cmds_size = 0;
+    ESP_RETURN_ON_FALSE(init_cmds && init_cmds_size, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+
+    *init_cmds = vendor_specific_init_default;
+    *init_cmds_size = ST7701_INIT_CMDS_SIZE(vendor_specific_init_default);
+
+    return ESP_OK;
+}
+
+// Parameters of the bank selections decoded from bytecode, which has none of its own to point to
+static const uint8_t vendor_bank_select_params[][5] = {
+    {0x77, 0x01, 0x00, 0x00, ST7701_BANK_REGULAR},
+    {0x77, 0x01, 0x00, 0x00, ST7701_BANK_CMD2_BK0},
+    {0x77, 0x01, 0x00, 0x00, ST7701_BANK_CMD2_BK0 + 1},
+    {0x77, 0x01, 0x00, 0x00, ST7701_BANK_CMD2_BK0 + 2},
+    {0x77, 0x01, 0x00, 0x00, ST7701_BANK_CMD2_BK0 + 3},
+};
 
+// Build the vendor sequence the init sends, once per panel: the command table or the decoded bytecode, without
+// reselections of the selected bank and without register writes a later write in the same run replaces.
+// Parameters stay where they are, only the command descriptors are copied.
+static esp_err_t panel_st7701_load_vendor_cmds(st7701_panel_t *st7701)
+{
+    const st7701_lcd_init_cmd_t *cmds = st7701->init_cmds;
+    uint16_t cmds_size = st7701->init_cmds_size;
+
+    if (!cmds && st7701->init_bytecode) {
+        ESP_RETURN_ON_ERROR(esp_lcd_st7701_bytecode_validate(st7701->init_bytecode, st7701->init_bytecode_size, &cmds_size),
+                            TAG, "invalid bytecode");
+    } else if (!cmds) {
+        cmds = vendor_specific_init_default;
+        cmds_size = ST7701_INIT_CMDS_SIZE(vendor_specific_init_default);
+    }
+    st7701->flags.default_cmds = cmds == vendor_specific_init_default;
+    st7701->vendor_cmds = calloc(cmds_size ? cmds_size : 1, sizeof(st7701_lcd_init_cmd_t));
+    ESP_RETURN_ON_FALSE(st7701->vendor_cmds, ESP_ERR_NO_MEM, TAG, "no mem for init commands");
+    if (cmds) {
+        memcpy(st7701->vendor_cmds, cmds, cmds_size * sizeof(st7701_lcd_init_cmd_t));
+    } else {
+        st7701_bytecode_reader_t reader;
+        ESP_RETURN_ON_ERROR(esp_lcd_st7701_bytecode_reader_init(&reader, st7701->init_bytecode, st7701->init_bytecode_size),
+                            TAG, "invalid bytecode");
+        for (uint16_t i = 0; i < cmds_size; i++) {
+            st7701_lcd_init_cmd_t *cmd = &st7701->vendor_cmds[i];
+            ESP_RETURN_ON_ERROR(esp_lcd_st7701_bytecode_next(&reader, cmd), TAG, "invalid init command %d", i);
+            if (cmd->cmd == ST7701_CMD_CND2BKxSEL) {
+                // Validated, so a known bank: the regular one or BK0 to BK3
+                uint8_t bank = ((const uint8_t *)cmd->data)[4];
+                cmd->data = vendor_bank_select_params[bank ? bank - ST7701_BANK_CMD2_BK0 + 1 : 0];
+            }
+        }
+    }
+    ESP_RETURN_ON_ERROR(esp_lcd_st7701_optimize_init_cmds(st7701->vendor_cmds, cmds_size, st7701->vendor_cmds, cmds_size,
+                                                          &st7701->vendor_cmds_stats), TAG, "optimize init commands failed");
+    st7701->vendor_cmds_size = st7701->vendor_cmds_stats.num_cmds_out;
+    ESP_LOGD(TAG, "init sequence of %d commands sent as %d packets, %d bank selections dropped, %d writes merged",
+             cmds_size, st7701->vendor_cmds_size, st7701->vendor_cmds_stats.bank_selects_dropped,
+             st7701->vendor_cmds_stats.writes_merged);
+
+    return ESP_OK;
+}
+
+static esp_err_t panel_st7701_init_seq_start(st7701_panel_t *st7701)
+{
+    memset(&st7701->seq, 0, sizeof(st7701->seq));
     // vendor specific initialization, it can be different between manufacturers
     // should consult the LCD supplier for initialization sequence code
-    if (st7701->init_cmds) {
-        init_cmds = st7701->init_cmds;
-        init_cmds_size = st7701->init_cmds_size;
+    if (st7701->flags.warm) {
+        st7701->flags.warm = 0;
+        st7701->seq.cmds = vendor_specific_init_warm;
+        st7701->seq.cmds_size = ST7701_INIT_CMDS_SIZE(vendor_specific_init_warm);
     } else {
-        init_cmds = vendor_specific_init_default;
-        init_cmds_size = sizeof(vendor_specific_init_default) / sizeof(st7701_lcd_init_cmd_t);
+        st7701->seq.cmds = st7701->vendor_cmds;
+        st7701->seq.cmds_size = st7701->vendor_cmds_size;
+    }
+    if (st7701->seq.cmds != vendor_specific_init_warm) {
+        // Without a reset before, the registers may have been changed behind the driver's back (e.g. a brownout), so only
+        // elide what the sequence itself writes twice. The bank follows from the last selection sent and stays known.
+        uint8_t bank_valid = st7701->shadow.valid.bank;
+        memset(&st7701->shadow.valid, 0, sizeof(st7701->shadow.valid));
+        st7701->shadow.valid.bank = bank_valid;
+        // Bring the registers managed by the driver in line with its state, this also makes a warm start detectable
+        st7701->seq.tail[0] = (st7701_lcd_init_cmd_t){LCD_CMD_MADCTL, &st7701->madctl_val, 1, 0};
+        st7701->seq.tail[1] = (st7701_lcd_init_cmd_t){LCD_CMD_COLMOD, &st7701->colmod_val, 1, 0};
+        st7701->seq.tail_size = 2;
+        if (st7701->sdir_val) {
+            static const uint8_t bank_cmd2_bk0[] = {0x77, 0x01, 0x00, 0x00, ST7701_BANK_CMD2_BK0};
+            static const uint8_t bank_regular[] = {0x77, 0x01, 0x00, 0x00, ST7701_BANK_REGULAR};
+            st7701->seq.tail[2] = (st7701_lcd_init_cmd_t){ST7701_CMD_CND2BKxSEL, bank_cmd2_bk0, sizeof(bank_cmd2_bk0), 0};
+            st7701->seq.tail[3] = (st7701_lcd_init_cmd_t){ST7701_CMD_SDIR, &st7701->sdir_val, 1, 0};
+            st7701->seq.tail[4] = (st7701_lcd_init_cmd_t){ST7701_CMD_CND2BKxSEL, bank_regular, sizeof(bank_regular), 0};
+            st7701->seq.tail_size = 5;
+        }
+    }
+    panel_st7701_trace_start(st7701);
+
+    return ESP_OK;
+}
+
+static esp_err_t panel_st7701_init_seq_next(st7701_panel_t *st7701, st7701_lcd_init_cmd_t *ret_cmd)
+{
+    if (st7701->seq.holding) {
+        if (st7701->seq.tail_index < st7701->seq.tail_size) {
+            *ret_cmd = st7701->seq.tail[st7701->seq.tail_index++];
+        } else {
+            *ret_cmd = st7701->seq.held;
+            st7701->seq.holding = false;
+        }
+        return ESP_OK;
+    }
+    if (!st7701->seq.source_done) {
+        esp_err_t ret = ESP_ERR_NOT_FOUND;
+        if (st7701->seq.index < st7701->seq.cmds_size) {
+            *ret_cmd = st7701->seq.cmds[st7701->seq.index++];
+            ret = ESP_OK;
+        }
+        if (ret == ESP_OK && ret_cmd->cmd == LCD_CMD_DISPON && st7701->seq.tail_index < st7701->seq.tail_size) {
+            // Set the registers managed by the driver before the first frame is shown, not after
+            st7701->seq.held = *ret_cmd;
+            st7701->seq.holding = true;
+            *ret_cmd = st7701->seq.tail[st7701->seq.tail_index++];
+        }
+        if (ret != ESP_ERR_NOT_FOUND) {
+            return ret;
+        }
+        st7701->seq.source_done = true;
+    }
+    if (st7701->seq.tail_index < st7701->seq.tail_size) {
+        *ret_cmd = st7701->seq.tail[st7701->seq.tail_index++];
+        return ESP_OK;
+    }
+
+    return ESP_ERR_NOT_FOUND;
+}
+
+// Make the timing registers of the sequence match the timing the MIPI DPI panel runs with
+static void panel_st7701_apply_timing(st7701_panel_t *st7701, st7701_lcd_init_cmd_t *cmd)
+{
+    const st7701_shadow_regs_t *shadow = &st7701->shadow;
+
+    // The bank is known from the bank selections sent before
+    if (!shadow->valid.bank || shadow->bank != ST7701_BANK_CMD2_BK0) {
+        return;
+    }
+    switch (cmd->cmd) {
+    case ST7701_CMD_LNESET:
+        if (st7701->flags.timing) {
+            cmd->data = st7701->timing.lneset;
+            cmd->data_bytes = sizeof(st7701->timing.lneset);
+        } else if (st7701->flags.lneset && cmd->data_bytes == sizeof(st7701->lneset_val)) {
+            // Only the line count, the extra lines of the second parameter stay as the sequence sets them
+            st7701->lneset_val[1] = ((const uint8_t *)cmd->data)[1];
+            cmd->data = st7701->lneset_val;
+        }
+        break;
+    case ST7701_CMD_PORCTRL:
+        if (st7701->flags.timing) {
+            cmd->data = st7701->timing.porctrl;
+            cmd->data_bytes = sizeof(st7701->timing.porctrl);
+        }
+        break;
+    case ST7701_CMD_INVSET:
+        if (st7701->flags.timing) {
+            cmd->data = st7701->timing.invset;
+            cmd->data_bytes = sizeof(st7701->timing.invset);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// Power mode bits that tell the delay after `cmd` can be cut short, 0 if the delay must be waited out
+static uint8_t panel_st7701_ready_mask(int cmd)
+{
+    switch (cmd) {
+    case LCD_CMD_SLPOUT:
+        return ST7701_RDDPM_BSTON | ST7701_RDDPM_SLPOUT;
+    case LCD_CMD_DISPON:
+        return ST7701_RDDPM_DISON;
+    default:
+        return 0;
+    }
+}
+
+// Check whether the panel reports ready for the command being waited for, otherwise return the time until the next poll
+static esp_err_t panel_st7701_init_seq_poll(st7701_panel_t *st7701, uint32_t *ret_delay_ms)
+{
+    uint8_t power_mode = 0;
+    int64_t elapsed_us = esp_timer_get_time() - st7701->seq.wait.start_us;
+    // A failed read counts as not ready, so the table delay is the worst case
+    bool ready = esp_lcd_panel_io_rx_param(st7701->io, LCD_CMD_RDDPM, &power_mode, 1) == ESP_OK &&
+                 (power_mode & st7701->seq.wait.mask) == st7701->seq.wait.mask;
+
+    if (ready || elapsed_us >= (int64_t)st7701->seq.wait.timeout_ms * 1000) {
+        ESP_LOGI(TAG, "command 0x%02X %s after %"PRId64" us (table delay %"PRIu32" ms)", st7701->seq.wait.cmd,
+                 ready ? "ready" : "timed out", elapsed_us, st7701->seq.wait.timeout_ms);
+        st7701->seq.wait.mask = 0;
+        *ret_delay_ms = 0;
+        return ESP_OK;
+    }
+    uint32_t remain_ms = st7701->seq.wait.timeout_ms - elapsed_us / 1000;
+    *ret_delay_ms = remain_ms < ST7701_READY_POLL_MS ? remain_ms : ST7701_READY_POLL_MS;
+
+    return ESP_OK;
+}
+
+// Send commands up to and including the next one that requests a delay, which is returned in `ret_delay_ms`.
+// The sequence is complete once `seq.done` is set and the returned delay has elapsed.
+static esp_err_t panel_st7701_init_seq_step(st7701_panel_t *st7701, uint32_t *ret_delay_ms)
+{
+    esp_lcd_panel_io_handle_t io = st7701->io;
+    st7701_lcd_init_cmd_t cmd;
+
+    if (st7701->seq.wait.mask) {
+        ESP_RETURN_ON_ERROR(panel_st7701_init_seq_poll(st7701, ret_delay_ms), TAG, "poll panel failed");
+        if (*ret_delay_ms) {
+            return ESP_OK;
+        }
+    }
+
+    // Each DCS command is its own DSI packet and the DBI panel IO submits one packet per call, so the best we can do is
+    // to issue a run of commands back-to-back, without giving up the CPU in between. Fewer transactions wouldn't gain
+    // much anyway: at 1 Gbps the default table spends about 0.4 ms on the link and 270 ms in its delays.
+    *ret_delay_ms = 0;
+    while (!*ret_delay_ms) {
+        esp_err_t ret = panel_st7701_init_seq_next(st7701, &cmd);
+        if (ret == ESP_ERR_NOT_FOUND) {
+            st7701->seq.done = true;
+            panel_st7701_trace_finish(st7701);
+            break;
+        }
+        ESP_RETURN_ON_ERROR(ret, TAG, "invalid init command %d", st7701->seq.sent);
+        panel_st7701_apply_timing(st7701, &cmd);
+        if (panel_st7701_shadow_match(st7701, cmd.cmd, cmd.data, cmd.data_bytes)) {
+            // Selecting the bank that is selected already, or a register the sequence has set to this value already (e.g.
+            // COLMOD in the vendor table), only the delay is left to do
+            st7701->shadow.writes_elided++;
+            *ret_delay_ms = cmd.delay_ms;
+            continue;
+        }
+#if CONFIG_ST7701_INIT_TRACE
+        int64_t cmd_start_us = esp_timer_get_time();
+        ret = esp_lcd_panel_io_tx_param(io, cmd.cmd, cmd.data, cmd.data_bytes);
+        panel_st7701_trace_record(st7701, &cmd, cmd_start_us, ret);
+#else
+        ret = esp_lcd_panel_io_tx_param(io, cmd.cmd, cmd.data, cmd.data_bytes);
+#endif
+        ESP_RETURN_ON_ERROR(ret, TAG, "send command failed");
+        panel_st7701_shadow_update(st7701, cmd.cmd, cmd.data, cmd.data_bytes);
+        st7701->seq.sent++;
+        *ret_delay_ms = cmd.delay_ms;
+        if (st7701->flags.poll_ready && cmd.delay_ms > ST7701_READY_POLL_MS && panel_st7701_ready_mask(cmd.cmd)) {
+            // The table delay becomes the timeout of polling the power mode
+            st7701->seq.wait.cmd = cmd.cmd;
+            st7701->seq.wait.mask = panel_st7701_ready_mask(cmd.cmd);
+            st7701->seq.wait.start_us = esp_timer_get_time();
+            st7701->seq.wait.timeout_ms = cmd.delay_ms;
+            *ret_delay_ms = ST7701_READY_POLL_MS;
+        }
     }
 
-    for (int i = 0; i < init_cmds_size; i++) {
-        ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_param(io, init_cmds[i].cmd, init_cmds[i].data, init_cmds[i].data_bytes), TAG, "send command failed");
-        vTaskDelay(pdMS_TO_TICKS(init_cmds[i].delay_ms));
+    return ESP_OK;
+}
+
+static esp_err_t panel_st7701_send_init_cmds(st7701_panel_t *st7701)
+{
+    uint32_t delay_ms = 0;
+
+    ESP_RETURN_ON_ERROR(panel_st7701_init_seq_start(st7701), TAG, "start init sequence failed");
+    while (!st7701->seq.done) {
+        ESP_RETURN_ON_ERROR(panel_st7701_init_seq_step(st7701, &delay_ms), TAG, "send init commands failed");
+        // Sleep at least one tick, delays shorter than a tick (e.g. ready polls) would otherwise busy-loop
+        TickType_t ticks = pdMS_TO_TICKS(delay_ms);
+        vTaskDelay(delay_ms && !ticks ? 1 : ticks);
     }
+    panel_st7701_init_crc_store(st7701);
 
     ESP_LOGD(TAG, "send init commands success");
 
     return ESP_OK;
 }
 
+// Take the initialization sequencer, false if an initialization is running already
+static bool panel_st7701_busy_claim(st7701_panel_t *st7701)
+{
+    bool busy = false;
+
+    return atomic_compare_exchange_strong(&st7701->async.busy, &busy, true);
+}
+
+static void panel_st7701_init_async_cb(void *arg)
+{
+    st7701_panel_t *st7701 = (st7701_panel_t *)arg;
+    esp_lcd_panel_t *panel = st7701->async.panel;
+    uint32_t delay_ms = 0;
+    esp_err_t ret = ESP_OK;
+
+    if (!st7701->seq.done) {
+        ret = panel_st7701_init_seq_step(st7701, &delay_ms);
+        if (ret == ESP_OK && delay_ms) {
+            // Come back once the panel has settled, the sequence may have completed already
+            ret = esp_timer_start_once(st7701->async.timer, (uint64_t)delay_ms * 1000);
+            if (ret == ESP_OK) {
+                return;
+            }
+        }
+    }
+
+    if (ret == ESP_OK) {
+        panel_st7701_init_crc_store(st7701);
+        ESP_LOGD(TAG, "send init commands success");
+        ret = st7701->init(panel);
+        st7701->flags.dpi_started = ret == ESP_OK;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "async init failed: %s", esp_err_to_name(ret));
+    }
+
+    atomic_store(&st7701->async.busy, false);
+    if (st7701->async.done_cb) {
+        st7701->async.done_cb(panel, ret, st7701->async.user_ctx);
+    }
+}
+
+esp_err_t esp_lcd_st7701_init_async(esp_lcd_panel_handle_t panel, esp_lcd_st7701_init_done_cb_t done_cb, void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+    esp_err_t ret = ESP_OK;
+
+    // Claimed before the sequencer is touched, a concurrent caller finds it busy
+    ESP_RETURN_ON_FALSE(panel_st7701_busy_claim(st7701), ESP_ERR_INVALID_STATE, TAG, "init already in progress");
+    if (!st7701->async.timer) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = panel_st7701_init_async_cb,
+            .arg = st7701,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "st7701_init",
+        };
+        ESP_GOTO_ON_ERROR(esp_timer_create(&timer_args, &st7701->async.timer), err, TAG, "create init timer failed");
+    }
+
+    st7701->async.panel = panel;
+    st7701->async.done_cb = done_cb;
+    st7701->async.user_ctx = user_ctx;
+    ESP_GOTO_ON_ERROR(panel_st7701_init_seq_start(st7701), err, TAG, "start init sequence failed");
+    // Even the first commands are sent from the timer task, so this call never touches the bus
+    ESP_GOTO_ON_ERROR(esp_timer_start_once(st7701->async.timer, 0), err, TAG, "start init timer failed");
+
+    return ESP_OK;
+
+err:
+    atomic_store(&st7701->async.busy, false);
+    return ret;
+}
+
 static esp_err_t panel_st7701_del(esp_lcd_panel_t *panel)
 {
     st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
 
+    if (st7701->async.timer) {
+        esp_timer_stop(st7701->async.timer);
+        esp_timer_delete(st7701->async.timer);
+    }
+#if SOC_PPA_SUPPORTED
+    if (st7701->srm_client) {
+        ppa_unregister_client(st7701->srm_client);
+    }
+    if (st7701->fill_client) {
+        ppa_unregister_client(st7701->fill_client);
+    }
+    if (st7701->blend_client) {
+        ppa_unregister_client(st7701->blend_client);
+    }
+#endif
     if (st7701->reset_gpio_num >= 0) {
         gpio_reset_pin(st7701->reset_gpio_num);
     }
     // Delete MIPI DPI panel
     st7701->del(panel);
+    free(st7701->vendor_cmds);
     free(st7701);
     ESP_LOGD(TAG, "del st7701 panel @%p", st7701);
 
@@ -222,18 +834,157 @@ static esp_err_t panel_st7701_del(esp_lcd_panel_t *panel)
 static esp_err_t panel_st7701_init(esp_lcd_panel_t *panel)
 {
     st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+    esp_err_t ret = ESP_OK;
+
+    // Held for the whole sequence, an asynchronous initialization can't start in between
+    ESP_RETURN_ON_FALSE(panel_st7701_busy_claim(st7701), ESP_ERR_INVALID_STATE, TAG, "init already in progress");
+    ESP_GOTO_ON_ERROR(panel_st7701_send_init_cmds(st7701), out, TAG, "send init commands failed");
+    ESP_GOTO_ON_ERROR(st7701->init(panel), out, TAG, "init MIPI DPI panel failed");
+    st7701->flags.dpi_started = 1;
+
+out:
+    atomic_store(&st7701->async.busy, false);
+    return ret;
+}
+
+// Checksum of the state a full initialization leaves behind: the vendor sequence, the timing registers that replace
+// its own and the registers managed by the driver. Delays are left out, they don't change the state.
+static esp_err_t panel_st7701_init_crc(st7701_panel_t *st7701, uint32_t *ret_crc)
+{
+    const st7701_lcd_init_cmd_t *cmds = st7701->init_cmds;
+    uint16_t cmds_size = st7701->init_cmds_size;
+    st7701_bytecode_reader_t reader;
+    st7701_lcd_init_cmd_t cmd;
+    uint32_t crc = 0;
 
-    ESP_RETURN_ON_ERROR(panel_st7701_send_init_cmds(st7701), TAG, "send init commands failed");
-    ESP_RETURN_ON_ERROR(st7701->init(panel), TAG, "init MIPI DPI panel failed");
+    if (!cmds && st7701->init_bytecode) {
+        ESP_RETURN_ON_ERROR(esp_lcd_st7701_bytecode_reader_init(&reader, st7701->init_bytecode, st7701->init_bytecode_size),
+                            TAG, "invalid bytecode");
+    } else if (!cmds) {
+        cmds = vendor_specific_init_default;
+        cmds_size = ST7701_INIT_CMDS_SIZE(vendor_specific_init_default);
+    }
+    for (uint16_t i = 0; !cmds || i < cmds_size; i++) {
+        if (cmds) {
+            cmd = cmds[i];
+        } else {
+            esp_err_t ret = esp_lcd_st7701_bytecode_next(&reader, &cmd);
+            if (ret == ESP_ERR_NOT_FOUND) {
+                break;
+            }
+            ESP_RETURN_ON_ERROR(ret, TAG, "invalid init command %d", i);
+        }
+        uint8_t header[2] = {cmd.cmd, cmd.data_bytes};
+        crc = esp_lcd_st7701_crc32(crc, header, sizeof(header));
+        crc = esp_lcd_st7701_crc32(crc, cmd.data, cmd.data_bytes);
+    }
+    if (st7701->flags.lneset) {
+        crc = esp_lcd_st7701_crc32(crc, st7701->lneset_val, 1);
+    }
+    if (st7701->flags.timing) {
+        crc = esp_lcd_st7701_crc32(crc, st7701->timing.lneset, sizeof(st7701->timing.lneset));
+        crc = esp_lcd_st7701_crc32(crc, st7701->timing.porctrl, sizeof(st7701->timing.porctrl));
+        crc = esp_lcd_st7701_crc32(crc, st7701->timing.invset, sizeof(st7701->timing.invset));
+    }
+    const uint8_t managed[] = {st7701->madctl_val, st7701->colmod_val, st7701->sdir_val};
+    *ret_crc = esp_lcd_st7701_crc32(crc, managed, sizeof(managed));
 
     return ESP_OK;
 }
 
+// Remember the checksum of a full initialization for the next warm start, flash is only written if it changed
+static void panel_st7701_init_crc_store(st7701_panel_t *st7701)
+{
+    uint32_t crc = 0;
+    uint32_t stored_crc = 0;
+    nvs_handle_t nvs;
+    esp_err_t ret;
+
+    if (!st7701->flags.warm_start || st7701->seq.cmds == vendor_specific_init_warm ||
+            panel_st7701_init_crc(st7701, &crc) != ESP_OK) {
+        return;
+    }
+    ret = nvs_open(ST7701_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "warm start needs NVS: %s", esp_err_to_name(ret));
+        return;
+    }
+    if (nvs_get_u32(nvs, ST7701_NVS_KEY_INIT_CRC, &stored_crc) != ESP_OK || stored_crc != crc) {
+        ret = nvs_set_u32(nvs, ST7701_NVS_KEY_INIT_CRC, crc);
+        if (ret == ESP_OK) {
+            ret = nvs_commit(nvs);
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "store init checksum failed: %s", esp_err_to_name(ret));
+        }
+    }
+    nvs_close(nvs);
+}
+
+// Check whether the panel still holds the configuration of a previous initialization, e.g. after a soft restart
+static bool panel_st7701_is_configured(st7701_panel_t *st7701)
+{
+    esp_lcd_panel_io_handle_t io = st7701->io;
+    uint8_t id[3] = {0};
+    uint8_t madctl = 0;
+    uint8_t colmod = 0;
+    uint8_t power_mode = 0;
+
+    if (esp_lcd_panel_io_rx_param(io, LCD_CMD_RDDID, id, sizeof(id)) != ESP_OK ||
+            esp_lcd_panel_io_rx_param(io, LCD_CMD_RDDMADCTL, &madctl, 1) != ESP_OK ||
+            esp_lcd_panel_io_rx_param(io, LCD_CMD_RDDCOLMOD, &colmod, 1) != ESP_OK ||
+            esp_lcd_panel_io_rx_param(io, LCD_CMD_RDDPM, &power_mode, 1) != ESP_OK) {
+        return false;
+    }
+    ESP_LOGD(TAG, "id %02X%02X%02X, madctl 0x%02X, colmod 0x%02X, power mode 0x%02X", id[0], id[1], id[2], madctl, colmod,
+             power_mode);
+
+    // A floating or stuck bus reads as all zeros or all ones
+    bool id_valid = (id[0] | id[1] | id[2]) != 0x00 && (id[0] & id[1] & id[2]) != 0xFF;
+    // Mirroring is left to the application, which applies it again after the restart
+    bool madctl_match = (madctl & ST7701_CMD_BGR_BIT) == (st7701->madctl_val & ST7701_CMD_BGR_BIT);
+    // The booster only runs after sleep out, a panel that went through a power cycle or a reset is still sleeping
+    bool awake = (power_mode & (ST7701_RDDPM_BSTON | ST7701_RDDPM_SLPOUT)) == (ST7701_RDDPM_BSTON | ST7701_RDDPM_SLPOUT);
+
+    if (!id_valid || !madctl_match || colmod != st7701->colmod_val || !awake) {
+        return false;
+    }
+    // The readable registers can't tell a different vendor sequence or timing apart, the checksum of the last full
+    // initialization can
+    uint32_t crc = 0;
+    uint32_t stored_crc = 0;
+    nvs_handle_t nvs;
+    if (panel_st7701_init_crc(st7701, &crc) != ESP_OK || nvs_open(ST7701_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return false;
+    }
+    esp_err_t ret = nvs_get_u32(nvs, ST7701_NVS_KEY_INIT_CRC, &stored_crc);
+    nvs_close(nvs);
+    if (ret != ESP_OK || stored_crc != crc) {
+        ESP_LOGD(TAG, "init checksum 0x%08"PRIX32" doesn't match 0x%08"PRIX32, crc, stored_crc);
+        return false;
+    }
+    // Seed the shadow registers with what has just been read back, the standard reads imply the regular bank
+    panel_st7701_shadow_reset(st7701);
+    st7701->shadow.madctl = madctl;
+    st7701->shadow.valid.madctl = 1;
+    st7701->shadow.colmod = colmod;
+    st7701->shadow.valid.colmod = 1;
+
+    return true;
+}
+
 static esp_err_t panel_st7701_reset(esp_lcd_panel_t *panel)
 {
     st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
     esp_lcd_panel_io_handle_t io = st7701->io;
 
+    st7701->flags.warm = 0;
+    if (st7701->flags.warm_start && panel_st7701_is_configured(st7701)) {
+        ESP_LOGI(TAG, "panel already configured, skip reset and initialization");
+        st7701->flags.warm = 1;
+        return ESP_OK;
+    }
+
     // Perform hardware reset
     if (st7701->reset_gpio_num >= 0) {
         gpio_set_level(st7701->reset_gpio_num, st7701->flags.reset_level);
@@ -244,30 +995,44 @@ static esp_err_t panel_st7701_reset(esp_lcd_panel_t *panel)
         ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_param(io, LCD_CMD_SWRESET, NULL, 0), TAG, "send command failed");
         vTaskDelay(pdMS_TO_TICKS(20));
     }
+    panel_st7701_shadow_reset(st7701);
 
     return ESP_OK;
 }
 
 static esp_err_t panel_st7701_mirror(esp_lcd_panel_t *panel, bool mirror_x, bool mirror_y)
 {
-    (void)mirror_y;
     st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
     esp_lcd_panel_io_handle_t io = st7701->io;
     uint8_t madctl_val = st7701->madctl_val;
+    uint8_t sdir_val = st7701->sdir_val;
 
     ESP_RETURN_ON_FALSE(io, ESP_ERR_INVALID_STATE, TAG, "invalid panel IO");
+    ESP_RETURN_ON_FALSE(!atomic_load(&st7701->async.busy), ESP_ERR_INVALID_STATE, TAG, "init in progress");
 
-    // Control mirror through LCD command
+    // Horizontal mirroring reverses the source scan direction, in Command2 BK0
     if (mirror_x) {
+        sdir_val |= ST7701_SDIR_SS_BIT;
+    } else {
+        sdir_val &= ~ST7701_SDIR_SS_BIT;
+    }
+    // Vertical mirroring reverses the line order, through LCD command
+    if (mirror_y) {
         madctl_val |= ST7701_CMD_ML_BIT;
     } else {
         madctl_val &= ~ST7701_CMD_ML_BIT;
     }
 
-    ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_param(io, LCD_CMD_MADCTL, (uint8_t []) {
+    ESP_RETURN_ON_ERROR(panel_st7701_write(st7701, LCD_CMD_MADCTL, (uint8_t []) {
         madctl_val
     }, 1), TAG, "send command failed");
+    ESP_RETURN_ON_ERROR(panel_st7701_write_bank(st7701, ST7701_BANK_CMD2_BK0, ST7701_CMD_SDIR, (uint8_t []) {
+        sdir_val
+    }, 1), TAG, "send command failed");
+    // Only a complete mirroring becomes the configuration the next initialization restores. After a failure, the shadow
+    // registers still tell what the panel got.
     st7701->madctl_val = madctl_val;
+    st7701->sdir_val = sdir_val;
 
     return ESP_OK;
 }
@@ -279,13 +1044,1449 @@ static esp_err_t panel_st7701_invert_color(esp_lcd_panel_t *panel, bool invert_c
     uint8_t command = 0;
 
     ESP_RETURN_ON_FALSE(io, ESP_ERR_INVALID_STATE, TAG, "invalid panel IO");
+    ESP_RETURN_ON_FALSE(!atomic_load(&st7701->async.busy), ESP_ERR_INVALID_STATE, TAG, "init in progress");
 
     if (invert_color_data) {
         command = LCD_CMD_INVON;
     } else {
         command = LCD_CMD_INVOFF;
     }
-    ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_param(io, command, NULL, 0), TAG, "send command failed");
+    ESP_RETURN_ON_ERROR(panel_st7701_write(st7701, command, NULL, 0), TAG, "send command failed");
+
+    return ESP_OK;
+}
+
+static esp_err_t panel_st7701_get_fb(st7701_panel_t *st7701, esp_lcd_panel_t *panel, void **ret_fb)
+{
+    if (!st7701->fb) {
+        ESP_RETURN_ON_ERROR(esp_lcd_dpi_panel_get_frame_buffer(panel, 1, &st7701->fb), TAG, "get frame buffer failed");
+    }
+    *ret_fb = st7701->fb;
+
+    return ESP_OK;
+}
+
+#if SOC_PPA_SUPPORTED
+static esp_err_t panel_st7701_get_ppa_client(ppa_operation_t oper_type, ppa_client_handle_t *client)
+{
+    if (!*client) {
+        ppa_client_config_t client_config = {
+            .oper_type = oper_type,
+            .max_pending_trans_num = 1,
+        };
+        ESP_RETURN_ON_ERROR(ppa_register_client(&client_config, client), TAG, "register PPA client failed");
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t panel_st7701_get_srm_client(st7701_panel_t *st7701, ppa_client_handle_t *ret_client)
+{
+    ESP_RETURN_ON_ERROR(panel_st7701_get_ppa_client(PPA_OPERATION_SRM, &st7701->srm_client), TAG, "register PPA client failed");
+    if (ret_client) {
+        *ret_client = st7701->srm_client;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t panel_st7701_swap_xy(esp_lcd_panel_t *panel, bool swap_axes)
+{
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+
+    // The panel can't swap axes, the bitmaps are transposed by the PPA while they are drawn into the frame buffer
+    if (swap_axes) {
+        ESP_RETURN_ON_FALSE(st7701->bits_per_pixel == 16 || st7701->bits_per_pixel == 24, ESP_ERR_NOT_SUPPORTED, TAG,
+                            "unsupported pixel width for swapped axes");
+        ESP_RETURN_ON_FALSE(st7701->num_fbs <= 1, ESP_ERR_NOT_SUPPORTED, TAG, "swapped axes need a single frame buffer");
+        ESP_RETURN_ON_ERROR(panel_st7701_get_srm_client(st7701, NULL), TAG, "register PPA client failed");
+    }
+    st7701->swap_xy = swap_axes;
+
+    return ESP_OK;
+}
+
+static esp_err_t panel_st7701_draw_bitmap_swapped(esp_lcd_panel_t *panel, int x_start, int y_start, int x_end, int y_end,
+                                                  const void *color_data)
+{
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+
+    ESP_RETURN_ON_FALSE(color_data && x_start >= 0 && y_start >= 0 && x_start < x_end && y_start < y_end,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    // With swapped axes x runs along the panel's v_res and y along its h_res
+    ESP_RETURN_ON_FALSE((uint32_t)x_end <= st7701->v_res && (uint32_t)y_end <= st7701->h_res, ESP_ERR_INVALID_ARG, TAG, "bitmap out of range");
+    void *fb = NULL;
+    ESP_RETURN_ON_ERROR(panel_st7701_get_fb(st7701, panel, &fb), TAG, "get frame buffer failed");
+
+    ppa_srm_color_mode_t color_mode = st7701->bits_per_pixel == 16 ? PPA_SRM_COLOR_MODE_RGB565 : PPA_SRM_COLOR_MODE_RGB888;
+    uint32_t width = x_end - x_start;
+    uint32_t height = y_end - y_start;
+    ppa_srm_oper_config_t srm_config = {
+        .in = {
+            .buffer = color_data,
+            .pic_w = width,
+            .pic_h = height,
+            .block_w = width,
+            .block_h = height,
+            .srm_cm = color_mode,
+        },
+        .out = {
+            .buffer = fb,
+            .buffer_size = st7701->h_res * st7701->v_res * st7701->bits_per_pixel / 8,
+            .pic_w = st7701->h_res,
+            .pic_h = st7701->v_res,
+            .block_offset_x = y_start,
+            .block_offset_y = x_start,
+            .srm_cm = color_mode,
+        },
+        // Transpose, i.e. pixel (x, y) of the bitmap lands in column y and line x of the frame buffer: rotate
+        // counter-clockwise, then mirror the rotated block vertically. Mirroring on the glass is left to the panel.
+        .rotation_angle = PPA_SRM_ROTATION_ANGLE_90,
+        .scale_x = 1.0f,
+        .scale_y = 1.0f,
+        .mirror_y = true,
+        .mode = PPA_TRANS_MODE_BLOCKING,
+    };
+    ESP_RETURN_ON_ERROR(ppa_do_scale_rotate_mirror(st7701->srm_client, &srm_config), TAG, "rotate bitmap failed");
+
+    return ESP_OK;
+}
+#endif
+
+static esp_err_t panel_st7701_draw_bitmap(esp_lcd_panel_t *panel, int x_start, int y_start, int x_end, int y_end,
+                                          const void *color_data)
+{
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+
+    if (st7701->refresh.idle_ms) {
+        st7701->refresh.last_draw_us = esp_timer_get_time();
+        st7701->refresh.drawn = true;
+    }
+#if SOC_PPA_SUPPORTED
+    if (st7701->swap_xy) {
+        ESP_RETURN_ON_ERROR(panel_st7701_draw_bitmap_swapped(panel, x_start, y_start, x_end, y_end, color_data), TAG,
+                            "draw bitmap failed");
+        panel_st7701_pacing_submit(st7701);
+        return ESP_OK;
+    }
+#endif
+
+    ESP_RETURN_ON_ERROR(st7701->draw_bitmap(panel, x_start, y_start, x_end, y_end, color_data), TAG, "draw bitmap failed");
+    panel_st7701_pacing_submit(st7701);
 
     return ESP_OK;
 }
+
+esp_err_t esp_lcd_st7701_draw_bitmap_convert(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                             const void *color_data, st7701_color_format_t format, st7701_dither_t dither)
+{
+    ESP_RETURN_ON_FALSE(panel && color_data, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+    ESP_RETURN_ON_FALSE(x_start >= 0 && y_start >= 0 && x_start < x_end && y_start < y_end && x_end <= (int)st7701->h_res &&
+                        y_end <= (int)st7701->v_res, ESP_ERR_INVALID_ARG, TAG, "invalid area");
+    ESP_RETURN_ON_FALSE(format == ST7701_COLOR_FORMAT_RGB888 || format == ST7701_COLOR_FORMAT_ARGB8888, ESP_ERR_NOT_SUPPORTED,
+                        TAG, "unsupported source format");
+    // Packed RGB666 pixels don't start on byte boundaries
+    ESP_RETURN_ON_FALSE(st7701->bits_per_pixel != 18, ESP_ERR_NOT_SUPPORTED, TAG, "unsupported pixel width");
+#if SOC_PPA_SUPPORTED
+    ESP_RETURN_ON_FALSE(!st7701->swap_xy, ESP_ERR_INVALID_STATE, TAG, "axes are swapped");
+#endif
+    uint8_t bytes_per_pixel = st7701->bits_per_pixel / 8;
+    size_t stride = st7701->h_res * bytes_per_pixel;
+    uint16_t width = x_end - x_start;
+    uint16_t height = y_end - y_start;
+    st7701_color_format_t fb_format = st7701->bits_per_pixel == 16 ? ST7701_COLOR_FORMAT_RGB565 : ST7701_COLOR_FORMAT_RGB888;
+    void *fb = NULL;
+
+    // An 18-bit interface drops the low bits of a 24 bpp frame buffer, dither to what the panel shows
+    if (fb_format == ST7701_COLOR_FORMAT_RGB888 && st7701->shadow.valid.colmod && (st7701->shadow.colmod & 0x70) == 0x60) {
+        fb_format = ST7701_COLOR_FORMAT_RGB666;
+    }
+    ESP_RETURN_ON_ERROR(panel_st7701_get_fb(st7701, panel, &fb), TAG, "get frame buffer failed");
+    if (st7701->refresh.idle_ms) {
+        st7701->refresh.last_draw_us = esp_timer_get_time();
+        st7701->refresh.drawn = true;
+    }
+
+#if SOC_PPA_SUPPORTED
+    // The PPA truncates, which only matches undithered output. Truncating to RGB888 leaves RGB666 to the panel.
+    if (dither == ST7701_DITHER_NONE || fb_format == ST7701_COLOR_FORMAT_RGB888) {
+        ppa_client_handle_t srm_client = NULL;
+        ESP_RETURN_ON_ERROR(panel_st7701_get_srm_client(st7701, &srm_client), TAG, "register PPA client failed");
+        ppa_srm_oper_config_t srm_config = {
+            .in = {
+                .buffer = color_data,
+                .pic_w = width,
+                .pic_h = height,
+                .block_w = width,
+                .block_h = height,
+                .srm_cm = format == ST7701_COLOR_FORMAT_ARGB8888 ? PPA_SRM_COLOR_MODE_ARGB8888 : PPA_SRM_COLOR_MODE_RGB888,
+            },
+            .out = {
+                .buffer = fb,
+                .buffer_size = stride * st7701->v_res,
+                .pic_w = st7701->h_res,
+                .pic_h = st7701->v_res,
+                .block_offset_x = x_start,
+                .block_offset_y = y_start,
+                .srm_cm = st7701->bits_per_pixel == 16 ? PPA_SRM_COLOR_MODE_RGB565 : PPA_SRM_COLOR_MODE_RGB888,
+            },
+            .rotation_angle = PPA_SRM_ROTATION_ANGLE_0,
+            .scale_x = 1.0f,
+            .scale_y = 1.0f,
+            .mode = PPA_TRANS_MODE_BLOCKING,
+        };
+        ESP_RETURN_ON_ERROR(ppa_do_scale_rotate_mirror(srm_client, &srm_config), TAG, "convert bitmap failed");
+        panel_st7701_pacing_submit(st7701);
+        return ESP_OK;
+    }
+#endif
+
+    uint8_t *dst = (uint8_t *)fb + y_start * stride + x_start * bytes_per_pixel;
+    st7701_color_conv_config_t conv_config = {
+        .src_format = format,
+        .dst_format = fb_format,
+        .dither = dither,
+        .width = width,
+        .height = height,
+        .dst_stride = stride,
+        .x = x_start,
+        .y = y_start,
+    };
+    ESP_RETURN_ON_ERROR(esp_lcd_st7701_convert_color(&conv_config, color_data, dst), TAG, "convert bitmap failed");
+    esp_cache_msync(dst, (height - 1) * stride + width * bytes_per_pixel, ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_UNALIGNED);
+    panel_st7701_pacing_submit(st7701);
+
+    return ESP_OK;
+}
+
+// The 2D operations work on the first frame buffer in place
+static esp_err_t panel_st7701_get_fb_view(st7701_panel_t *st7701, esp_lcd_panel_t *panel, st7701_fb_t *ret_fb)
+{
+    // Packed RGB666 pixels don't start on byte boundaries
+    ESP_RETURN_ON_FALSE(st7701->bits_per_pixel != 18, ESP_ERR_NOT_SUPPORTED, TAG, "unsupported pixel width");
+#if SOC_PPA_SUPPORTED
+    ESP_RETURN_ON_FALSE(!st7701->swap_xy, ESP_ERR_INVALID_STATE, TAG, "axes are swapped");
+#endif
+    ESP_RETURN_ON_ERROR(panel_st7701_get_fb(st7701, panel, &ret_fb->buffer), TAG, "get frame buffer failed");
+    ret_fb->width = st7701->h_res;
+    ret_fb->height = st7701->v_res;
+    ret_fb->format = st7701->bits_per_pixel == 16 ? ST7701_COLOR_FORMAT_RGB565 : ST7701_COLOR_FORMAT_RGB888;
+
+    return ESP_OK;
+}
+
+// Write back what the CPU changed in the frame buffer and account for the draw
+static void panel_st7701_fb_written(st7701_panel_t *st7701, const st7701_fb_t *fb, int x_start, int y_start, int x_end, int y_end)
+{
+    uint8_t bytes_per_pixel = esp_lcd_st7701_color_bytes(fb->format);
+    size_t stride = (size_t)fb->width * bytes_per_pixel;
+    size_t start = y_start * stride + (size_t)x_start * bytes_per_pixel;
+    size_t end = (y_end - 1) * stride + (size_t)x_end * bytes_per_pixel;
+
+    esp_cache_msync((uint8_t *)fb->buffer + start, end - start, ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_UNALIGNED);
+    if (st7701->refresh.idle_ms) {
+        st7701->refresh.last_draw_us = esp_timer_get_time();
+        st7701->refresh.drawn = true;
+    }
+    panel_st7701_pacing_submit(st7701);
+}
+
+#if SOC_PPA_SUPPORTED
+// Same as the written variant, minus the cache: the PPA writes memory, its driver invalidates the cache lines
+static void panel_st7701_fb_ppa_written(st7701_panel_t *st7701)
+{
+    if (st7701->refresh.idle_ms) {
+        st7701->refresh.last_draw_us = esp_timer_get_time();
+        st7701->refresh.drawn = true;
+    }
+    panel_st7701_pacing_submit(st7701);
+}
+#endif
+
+esp_err_t esp_lcd_st7701_fill_rect(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end, uint32_t color)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+    st7701_fb_t fb = {0};
+
+    ESP_RETURN_ON_ERROR(panel_st7701_get_fb_view(st7701, panel, &fb), TAG, "get frame buffer failed");
+    ESP_RETURN_ON_FALSE(x_start >= 0 && y_start >= 0 && x_start < x_end && y_start < y_end && x_end <= fb.width &&
+                        y_end <= fb.height, ESP_ERR_INVALID_ARG, TAG, "invalid area");
+#if SOC_PPA_SUPPORTED
+    ESP_RETURN_ON_ERROR(panel_st7701_get_ppa_client(PPA_OPERATION_FILL, &st7701->fill_client), TAG, "register PPA client failed");
+    ppa_fill_oper_config_t fill_config = {
+        .out = {
+            .buffer = fb.buffer,
+            .buffer_size = (size_t)fb.width * fb.height * esp_lcd_st7701_color_bytes(fb.format),
+            .pic_w = fb.width,
+            .pic_h = fb.height,
+            .block_offset_x = x_start,
+            .block_offset_y = y_start,
+            .fill_cm = fb.format == ST7701_COLOR_FORMAT_RGB565 ? PPA_FILL_COLOR_MODE_RGB565 : PPA_FILL_COLOR_MODE_RGB888,
+        },
+        .fill_block_w = x_end - x_start,
+        .fill_block_h = y_end - y_start,
+        .fill_argb_color.val = color | 0xFF000000,
+        .mode = PPA_TRANS_MODE_BLOCKING,
+    };
+    ESP_RETURN_ON_ERROR(ppa_do_fill(st7701->fill_client, &fill_config), TAG, "fill rectangle failed");
+    panel_st7701_fb_ppa_written(st7701);
+#else
+    ESP_RETURN_ON_ERROR(esp_lcd_st7701_fb_fill(&fb, x_start, y_start, x_end, y_end, color), TAG, "fill rectangle failed");
+    panel_st7701_fb_written(st7701, &fb, x_start, y_start, x_end, y_end);
+#endif
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_copy_rect(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end, int x_dst,
+                                   int y_dst)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+    int x_dst_end = x_dst + x_end - x_start;
+    int y_dst_end = y_dst + y_end - y_start;
+    st7701_fb_t fb = {0};
+
+    ESP_RETURN_ON_ERROR(panel_st7701_get_fb_view(st7701, panel, &fb), TAG, "get frame buffer failed");
+#if SOC_PPA_SUPPORTED
+    // The PPA reads and writes in bursts, only rectangles that don't overlap are safe to hand over
+    bool overlap = x_start < x_dst_end && x_dst < x_end && y_start < y_dst_end && y_dst < y_end;
+    if (!overlap && x_start >= 0 && y_start >= 0 && x_start < x_end && y_start < y_end && x_end <= fb.width &&
+            y_end <= fb.height && x_dst >= 0 && y_dst >= 0 && x_dst_end <= fb.width && y_dst_end <= fb.height) {
+        ppa_client_handle_t srm_client = NULL;
+        ppa_srm_color_mode_t color_mode = fb.format == ST7701_COLOR_FORMAT_RGB565 ? PPA_SRM_COLOR_MODE_RGB565 :
+                                          PPA_SRM_COLOR_MODE_RGB888;
+        ESP_RETURN_ON_ERROR(panel_st7701_get_srm_client(st7701, &srm_client), TAG, "register PPA client failed");
+        ppa_srm_oper_config_t srm_config = {
+            .in = {
+                .buffer = fb.buffer,
+                .pic_w = fb.width,
+                .pic_h = fb.height,
+                .block_w = x_end - x_start,
+                .block_h = y_end - y_start,
+                .block_offset_x = x_start,
+                .block_offset_y = y_start,
+                .srm_cm = color_mode,
+            },
+            .out = {
+                .buffer = fb.buffer,
+                .buffer_size = (size_t)fb.width * fb.height * esp_lcd_st7701_color_bytes(fb.format),
+                .pic_w = fb.width,
+                .pic_h = fb.height,
+                .block_offset_x = x_dst,
+                .block_offset_y = y_dst,
+                .srm_cm = color_mode,
+            },
+            .rotation_angle = PPA_SRM_ROTATION_ANGLE_0,
+            .scale_x = 1.0f,
+            .scale_y = 1.0f,
+            .mode = PPA_TRANS_MODE_BLOCKING,
+        };
+        ESP_RETURN_ON_ERROR(ppa_do_scale_rotate_mirror(srm_client, &srm_config), TAG, "copy rectangle failed");
+        panel_st7701_fb_ppa_written(st7701);
+        return ESP_OK;
+    }
+#endif
+    ESP_RETURN_ON_ERROR(esp_lcd_st7701_fb_copy(&fb, x_start, y_start, x_end, y_end, x_dst, y_dst), TAG, "copy rectangle failed");
+    panel_st7701_fb_written(st7701, &fb, x_dst, y_dst, x_dst_end, y_dst_end);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_blend_rect(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end, const void *argb)
+{
+    ESP_RETURN_ON_FALSE(panel && argb, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+    st7701_fb_t fb = {0};
+
+    ESP_RETURN_ON_ERROR(panel_st7701_get_fb_view(st7701, panel, &fb), TAG, "get frame buffer failed");
+    ESP_RETURN_ON_FALSE(x_start >= 0 && y_start >= 0 && x_start < x_end && y_start < y_end && x_end <= fb.width &&
+                        y_end <= fb.height, ESP_ERR_INVALID_ARG, TAG, "invalid area");
+#if SOC_PPA_SUPPORTED
+    ppa_blend_color_mode_t color_mode = fb.format == ST7701_COLOR_FORMAT_RGB565 ? PPA_BLEND_COLOR_MODE_RGB565 :
+                                        PPA_BLEND_COLOR_MODE_RGB888;
+    ESP_RETURN_ON_ERROR(panel_st7701_get_ppa_client(PPA_OPERATION_BLEND, &st7701->blend_client), TAG, "register PPA client failed");
+    // The frame buffer is both background and output
+    ppa_blend_oper_config_t blend_config = {
+        .in_bg = {
+            .buffer = fb.buffer,
+            .pic_w = fb.width,
+            .pic_h = fb.height,
+            .block_w = x_end - x_start,
+            .block_h = y_end - y_start,
+            .block_offset_x = x_start,
+            .block_offset_y = y_start,
+            .blend_cm = color_mode,
+        },
+        .in_fg = {
+            .buffer = argb,
+            .pic_w = x_end - x_start,
+            .pic_h = y_end - y_start,
+            .block_w = x_end - x_start,
+            .block_h = y_end - y_start,
+            .blend_cm = PPA_BLEND_COLOR_MODE_ARGB8888,
+        },
+        .out = {
+            .buffer = fb.buffer,
+            .buffer_size = (size_t)fb.width * fb.height * esp_lcd_st7701_color_bytes(fb.format),
+            .pic_w = fb.width,
+            .pic_h = fb.height,
+            .block_offset_x = x_start,
+            .block_offset_y = y_start,
+            .blend_cm = color_mode,
+        },
+        .bg_alpha_update_mode = PPA_ALPHA_NO_CHANGE,
+        .fg_alpha_update_mode = PPA_ALPHA_NO_CHANGE,
+        .mode = PPA_TRANS_MODE_BLOCKING,
+    };
+    ESP_RETURN_ON_ERROR(ppa_do_blend(st7701->blend_client, &blend_config), TAG, "blend rectangle failed");
+    panel_st7701_fb_ppa_written(st7701);
+#else
+    ESP_RETURN_ON_ERROR(esp_lcd_st7701_fb_blend(&fb, x_start, y_start, x_end, y_end, argb), TAG, "blend rectangle failed");
+    panel_st7701_fb_written(st7701, &fb, x_start, y_start, x_end, y_end);
+#endif
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_flush_dirty(esp_lcd_panel_handle_t panel, const void *src, const st7701_dirty_region_t *region,
+                                     size_t *ret_bytes)
+{
+    ESP_RETURN_ON_FALSE(panel && src && region, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+    uint8_t bytes_per_pixel = st7701->bits_per_pixel / 8;
+    size_t stride = st7701->h_res * bytes_per_pixel;
+    size_t copied = 0;
+    void *fb = NULL;
+
+    // Packed RGB666 pixels don't start on byte boundaries
+    ESP_RETURN_ON_FALSE(st7701->bits_per_pixel != 18, ESP_ERR_NOT_SUPPORTED, TAG, "unsupported pixel width");
+    ESP_RETURN_ON_FALSE(region->config.width == st7701->h_res && region->config.height == st7701->v_res, ESP_ERR_INVALID_ARG,
+                        TAG, "region doesn't match the frame buffer");
+    ESP_RETURN_ON_ERROR(panel_st7701_get_fb(st7701, panel, &fb), TAG, "get frame buffer failed");
+    if (region->num_rects && st7701->refresh.idle_ms) {
+        st7701->refresh.last_draw_us = esp_timer_get_time();
+        st7701->refresh.drawn = true;
+    }
+
+#if SOC_PPA_SUPPORTED
+    ppa_client_handle_t srm_client = NULL;
+    ESP_RETURN_ON_ERROR(panel_st7701_get_srm_client(st7701, &srm_client), TAG, "register PPA client failed");
+    ppa_srm_color_mode_t color_mode = st7701->bits_per_pixel == 16 ? PPA_SRM_COLOR_MODE_RGB565 : PPA_SRM_COLOR_MODE_RGB888;
+    for (int i = 0; i < region->num_rects; i++) {
+        const st7701_rect_t *rect = &region->rects[i];
+        ppa_srm_oper_config_t srm_config = {
+            .in = {
+                .buffer = src,
+                .pic_w = st7701->h_res,
+                .pic_h = st7701->v_res,
+                .block_w = rect->x_end - rect->x_start,
+                .block_h = rect->y_end - rect->y_start,
+                .block_offset_x = rect->x_start,
+                .block_offset_y = rect->y_start,
+                .srm_cm = color_mode,
+            },
+            .out = {
+                .buffer = fb,
+                .buffer_size = stride * st7701->v_res,
+                .pic_w = st7701->h_res,
+                .pic_h = st7701->v_res,
+                .block_offset_x = rect->x_start,
+                .block_offset_y = rect->y_start,
+                .srm_cm = color_mode,
+            },
+            .rotation_angle = PPA_SRM_ROTATION_ANGLE_0,
+            .scale_x = 1.0f,
+            .scale_y = 1.0f,
+            .mode = PPA_TRANS_MODE_BLOCKING,
+        };
+        ESP_RETURN_ON_ERROR(ppa_do_scale_rotate_mirror(srm_client, &srm_config), TAG, "copy rectangle failed");
+        copied += (size_t)srm_config.in.block_w * srm_config.in.block_h * bytes_per_pixel;
+    }
+#else
+    copied = esp_lcd_st7701_dirty_copy(fb, src, bytes_per_pixel, region);
+    for (int i = 0; i < region->num_rects; i++) {
+        const st7701_rect_t *rect = &region->rects[i];
+        size_t start = rect->y_start * stride + rect->x_start * bytes_per_pixel;
+        size_t end = (rect->y_end - 1) * stride + rect->x_end * bytes_per_pixel;
+        esp_cache_msync((uint8_t *)fb + start, end - start, ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_UNALIGNED);
+    }
+#endif
+    if (copied) {
+        panel_st7701_pacing_submit(st7701);
+    }
+    if (ret_bytes) {
+        *ret_bytes = copied;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_timing_to_config(const st7701_timing_t *timing, esp_lcd_dsi_bus_config_t *ret_bus_config,
+                                          esp_lcd_dpi_panel_config_t *ret_dpi_config)
+{
+    ESP_RETURN_ON_FALSE(timing, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+
+    if (ret_bus_config) {
+        *ret_bus_config = (esp_lcd_dsi_bus_config_t) {
+            .bus_id = 0,
+            .num_data_lanes = timing->lane_num,
+            .phy_clk_src = MIPI_DSI_PHY_CLK_SRC_DEFAULT,
+            .lane_bit_rate_mbps = timing->lane_bit_rate_mbps,
+        };
+    }
+    if (ret_dpi_config) {
+        *ret_dpi_config = (esp_lcd_dpi_panel_config_t) {
+            .dpi_clk_src = MIPI_DSI_DPI_CLK_SRC_DEFAULT,
+            .dpi_clock_freq_mhz = timing->dpi_clock_freq_mhz,
+            .virtual_channel = 0,
+            .pixel_format = timing->bits_per_pixel == 16 ? LCD_COLOR_PIXEL_FORMAT_RGB565 :
+                            timing->bits_per_pixel == 18 ? LCD_COLOR_PIXEL_FORMAT_RGB666 : LCD_COLOR_PIXEL_FORMAT_RGB888,
+            .num_fbs = 1,
+            .video_timing = {
+                .h_size = timing->h_res,
+                .v_size = timing->v_res,
+                .hsync_back_porch = timing->hsync_back_porch,
+                .hsync_pulse_width = timing->hsync_pulse_width,
+                .hsync_front_porch = timing->hsync_front_porch,
+                .vsync_back_porch = timing->vsync_back_porch,
+                .vsync_pulse_width = timing->vsync_pulse_width,
+                .vsync_front_porch = timing->vsync_front_porch,
+            },
+            .flags.use_dma2d = true,
+        };
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_get_lane_bit_rate(const esp_lcd_dpi_panel_config_t *dpi_config, uint8_t lane_num,
+                                           uint8_t headroom_percent, uint32_t *ret_lane_bit_rate_mbps)
+{
+    ESP_RETURN_ON_FALSE(dpi_config && ret_lane_bit_rate_mbps, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+
+    st7701_timing_t timing = {
+        .h_res = dpi_config->video_timing.h_size,
+        .v_res = dpi_config->video_timing.v_size,
+        .hsync_pulse_width = dpi_config->video_timing.hsync_pulse_width,
+        .hsync_back_porch = dpi_config->video_timing.hsync_back_porch,
+        .hsync_front_porch = dpi_config->video_timing.hsync_front_porch,
+        .vsync_pulse_width = dpi_config->video_timing.vsync_pulse_width,
+        .vsync_back_porch = dpi_config->video_timing.vsync_back_porch,
+        .vsync_front_porch = dpi_config->video_timing.vsync_front_porch,
+        .dpi_clock_freq_mhz = dpi_config->dpi_clock_freq_mhz,
+        .bits_per_pixel = dpi_config->pixel_format == LCD_COLOR_PIXEL_FORMAT_RGB565 ? 16 :
+                          dpi_config->pixel_format == LCD_COLOR_PIXEL_FORMAT_RGB666 ? 18 : 24,
+        .lane_num = lane_num,
+    };
+
+    return esp_lcd_st7701_calc_lane_bit_rate(&timing, headroom_percent, ret_lane_bit_rate_mbps);
+}
+
+esp_err_t esp_lcd_st7701_set_lane_bit_rate(esp_lcd_dsi_bus_config_t *bus_config, const esp_lcd_dpi_panel_config_t *dpi_config,
+                                           uint8_t headroom_percent)
+{
+    ESP_RETURN_ON_FALSE(bus_config && dpi_config, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    uint32_t lane_bit_rate_mbps = 0;
+
+    ESP_RETURN_ON_ERROR(esp_lcd_st7701_get_lane_bit_rate(dpi_config, bus_config->num_data_lanes,
+                                                         bus_config->lane_bit_rate_mbps ? 0 : headroom_percent,
+                                                         &lane_bit_rate_mbps), TAG, "video stream too fast for the link");
+    if (!bus_config->lane_bit_rate_mbps) {
+        bus_config->lane_bit_rate_mbps = lane_bit_rate_mbps;
+    }
+    ESP_RETURN_ON_FALSE(bus_config->lane_bit_rate_mbps >= lane_bit_rate_mbps, ESP_ERR_INVALID_ARG, TAG,
+                        "video stream needs %"PRIu32" Mbps per lane, link has %"PRIu32, lane_bit_rate_mbps,
+                        bus_config->lane_bit_rate_mbps);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_set_rotation(esp_lcd_panel_handle_t panel, st7701_rotation_t rotation)
+{
+    // Clockwise rotation as a transpose followed by mirroring, the mirroring is free as the panel does it while scanning.
+    // Transposed, the bitmap's top edge runs down the glass' left edge: mirrored horizontally (SS) it runs down the right
+    // edge for 90°, mirrored vertically (ML) its left edge runs along the bottom for 270°.
+    static const struct {
+        bool swap_xy;
+        bool mirror_x;
+        bool mirror_y;
+    } transforms[] = {
+        [ST7701_ROTATION_0] = {false, false, false},
+        [ST7701_ROTATION_90] = {true, true, false},
+        [ST7701_ROTATION_180] = {false, true, true},
+        [ST7701_ROTATION_270] = {true, false, true},
+    };
+
+    ESP_RETURN_ON_FALSE(panel && rotation >= ST7701_ROTATION_0 && rotation <= ST7701_ROTATION_270, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+    // Checked before the axes change, so the rotation isn't applied halfway
+    ESP_RETURN_ON_FALSE(!atomic_load(&st7701->async.busy), ESP_ERR_INVALID_STATE, TAG, "init in progress");
+#if SOC_PPA_SUPPORTED
+    ESP_RETURN_ON_ERROR(panel_st7701_swap_xy(panel, transforms[rotation].swap_xy), TAG, "swap axes failed");
+#else
+    ESP_RETURN_ON_FALSE(!transforms[rotation].swap_xy, ESP_ERR_NOT_SUPPORTED, TAG, "rotation needs the PPA");
+#endif
+    ESP_RETURN_ON_ERROR(panel_st7701_mirror(panel, transforms[rotation].mirror_x, transforms[rotation].mirror_y), TAG,
+                        "mirror failed");
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_set_gamma(esp_lcd_panel_handle_t panel, const uint8_t positive[ST7701_GAMMA_SIZE],
+                                   const uint8_t negative[ST7701_GAMMA_SIZE])
+{
+    ESP_RETURN_ON_FALSE(panel && positive && negative, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+    ESP_RETURN_ON_FALSE(st7701->io, ESP_ERR_INVALID_STATE, TAG, "invalid panel IO");
+    ESP_RETURN_ON_FALSE(!atomic_load(&st7701->async.busy), ESP_ERR_INVALID_STATE, TAG, "init in progress");
+    bool positive_match = panel_st7701_shadow_match_bank(st7701, ST7701_BANK_CMD2_BK0, ST7701_CMD_PVGAMCTRL, positive,
+                                                         ST7701_GAMMA_SIZE);
+    bool negative_match = panel_st7701_shadow_match_bank(st7701, ST7701_BANK_CMD2_BK0, ST7701_CMD_NVGAMCTRL, negative,
+                                                         ST7701_GAMMA_SIZE);
+
+    if (positive_match && negative_match) {
+        st7701->shadow.writes_elided += 2;
+        return ESP_OK;
+    }
+    // Both curves in one visit of BK0, rather than a bank round trip per register as `panel_st7701_write_bank()` does
+    ESP_RETURN_ON_ERROR(panel_st7701_write(st7701, ST7701_CMD_CND2BKxSEL, (uint8_t []) {
+        0x77, 0x01, 0x00, 0x00, ST7701_BANK_CMD2_BK0
+    }, 5), TAG, "select bank failed");
+    if (!positive_match) {
+        ESP_RETURN_ON_ERROR(panel_st7701_write(st7701, ST7701_CMD_PVGAMCTRL, positive, ST7701_GAMMA_SIZE), TAG,
+                            "send command failed");
+    } else {
+        st7701->shadow.writes_elided++;
+    }
+    if (!negative_match) {
+        ESP_RETURN_ON_ERROR(panel_st7701_write(st7701, ST7701_CMD_NVGAMCTRL, negative, ST7701_GAMMA_SIZE), TAG,
+                            "send command failed");
+    } else {
+        st7701->shadow.writes_elided++;
+    }
+    ESP_RETURN_ON_ERROR(panel_st7701_write(st7701, ST7701_CMD_CND2BKxSEL, (uint8_t []) {
+        0x77, 0x01, 0x00, 0x00, ST7701_BANK_REGULAR
+    }, 5), TAG, "select bank failed");
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_set_pixel_format(esp_lcd_panel_handle_t *panel, int bits_per_pixel)
+{
+    ESP_RETURN_ON_FALSE(panel && *panel, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)(*panel)->user_data;
+    lcd_color_rgb_pixel_format_t pixel_format;
+    uint8_t colmod_val = 0;
+
+    ESP_RETURN_ON_FALSE(!atomic_load(&st7701->async.busy), ESP_ERR_INVALID_STATE, TAG, "init in progress");
+    ESP_RETURN_ON_ERROR(panel_st7701_colmod(bits_per_pixel, &colmod_val), TAG, "unsupported pixel width");
+    switch (bits_per_pixel) {
+    case 16:
+        pixel_format = LCD_COLOR_PIXEL_FORMAT_RGB565;
+        break;
+    case 18:
+        pixel_format = LCD_COLOR_PIXEL_FORMAT_RGB666;
+        break;
+    default:
+        pixel_format = LCD_COLOR_PIXEL_FORMAT_RGB888;
+        break;
+    }
+#if SOC_PPA_SUPPORTED
+    ESP_RETURN_ON_FALSE(!st7701->swap_xy || bits_per_pixel != 18, ESP_ERR_NOT_SUPPORTED, TAG,
+                        "unsupported pixel width for swapped axes");
+#endif
+    if (bits_per_pixel == st7701->bits_per_pixel) {
+        return ESP_OK;
+    }
+
+    // The MIPI DPI panel fixes its pixel format and frame buffers on creation, switch the panel first so a failure to
+    // create the new MIPI DPI panel can be undone. The driver's state only changes once both have been switched.
+    esp_lcd_dpi_panel_config_t dpi_config = st7701->dpi_config;
+    uint8_t old_colmod_val = st7701->colmod_val;
+    dpi_config.pixel_format = pixel_format;
+    // The new MIPI DPI panel starts with the configured timing
+    if (st7701->refresh.low) {
+        ESP_RETURN_ON_ERROR(panel_st7701_refresh_switch(st7701, false), TAG, "restore refresh rate failed");
+    }
+    ESP_RETURN_ON_ERROR(panel_st7701_write(st7701, LCD_CMD_COLMOD, (uint8_t []) {
+        colmod_val
+    }, 1), TAG, "send command failed");
+    esp_err_t ret = panel_st7701_dpi_replace(st7701, panel, &dpi_config);
+    if (ret != ESP_OK) {
+        if (*panel && panel_st7701_write(st7701, LCD_CMD_COLMOD, &old_colmod_val, 1) != ESP_OK) {
+            ESP_LOGW(TAG, "restore pixel format failed");
+        }
+        ESP_LOGE(TAG, "replace MIPI DPI panel failed");
+        return ret;
+    }
+    st7701->colmod_val = colmod_val;
+    st7701->bits_per_pixel = bits_per_pixel;
+
+    return ESP_OK;
+}
+
+// Create a MIPI DPI panel from `config` and make it the one driven by `st7701`, started if the old one was
+static esp_err_t panel_st7701_dpi_create(st7701_panel_t *st7701, const esp_lcd_dpi_panel_config_t *config,
+                                         esp_lcd_panel_handle_t *ret_panel)
+{
+    esp_lcd_panel_handle_t panel = NULL;
+
+    ESP_RETURN_ON_ERROR(esp_lcd_new_panel_dpi(st7701->dsi_bus, config, &panel), TAG, "create MIPI DPI panel failed");
+    ESP_LOGD(TAG, "new MIPI DPI panel @%p", panel);
+    panel_st7701_attach(st7701, panel);
+    *ret_panel = panel;
+
+    esp_err_t ret = panel_st7701_register_dpi_cbs(st7701, panel);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "register event callbacks failed: %s", esp_err_to_name(ret));
+    }
+    if (st7701->flags.dpi_started) {
+        ESP_RETURN_ON_ERROR(st7701->init(panel), TAG, "init MIPI DPI panel failed");
+    }
+
+    return ESP_OK;
+}
+
+// Replace the MIPI DPI panel by one created from `config`, which changes the panel handle. If the new panel can't be
+// created, one with the previous configuration takes its place and `*panel` is still updated. Only if that fails too,
+// the whole panel is gone and `*panel` is NULL.
+static esp_err_t panel_st7701_dpi_replace(st7701_panel_t *st7701, esp_lcd_panel_handle_t *panel,
+                                          const esp_lcd_dpi_panel_config_t *config)
+{
+    esp_err_t ret = ESP_OK;
+    esp_lcd_panel_handle_t new_panel = NULL;
+
+    ESP_RETURN_ON_ERROR(st7701->del(*panel), TAG, "delete MIPI DPI panel failed");
+    *panel = NULL;
+    st7701->fb = NULL;
+    memset(st7701->swap.fbs, 0, sizeof(st7701->swap.fbs));
+    st7701->swap.front = 0;
+    st7701->swap.pending = -1;
+
+    ret = panel_st7701_dpi_create(st7701, config, &new_panel);
+    if (ret == ESP_OK) {
+        st7701->dpi_config = *config;
+    } else {
+        // Fall back to the previous configuration, which did work
+        if (new_panel) {
+            st7701->del(new_panel);
+            new_panel = NULL;
+        }
+        ESP_GOTO_ON_FALSE(panel_st7701_dpi_create(st7701, &st7701->dpi_config, &new_panel) == ESP_OK, ret, err, TAG,
+                          "restore MIPI DPI panel failed");
+    }
+    *panel = new_panel;
+
+    return ret;
+
+err:
+    if (new_panel) {
+        st7701->del(new_panel);
+    }
+    // Without a MIPI DPI panel there is nothing left to hand back, release what `panel_st7701_del()` would have
+    if (st7701->async.timer) {
+        esp_timer_delete(st7701->async.timer);
+    }
+#if SOC_PPA_SUPPORTED
+    if (st7701->srm_client) {
+        ppa_unregister_client(st7701->srm_client);
+    }
+    if (st7701->fill_client) {
+        ppa_unregister_client(st7701->fill_client);
+    }
+    if (st7701->blend_client) {
+        ppa_unregister_client(st7701->blend_client);
+    }
+#endif
+    if (st7701->reset_gpio_num >= 0) {
+        gpio_reset_pin(st7701->reset_gpio_num);
+    }
+    free(st7701->vendor_cmds);
+    free(st7701);
+    return ret;
+}
+
+esp_err_t esp_lcd_st7701_register_event_callbacks(esp_lcd_panel_handle_t panel, const esp_lcd_dpi_panel_event_callbacks_t *cbs,
+                                                  void *user_ctx)
+{
+    ESP_RETURN_ON_FALSE(panel && cbs, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+
+    st7701->dpi_cbs = *cbs;
+    st7701->dpi_cbs_ctx = user_ctx;
+    ESP_RETURN_ON_ERROR(panel_st7701_register_dpi_cbs(st7701, panel), TAG, "register event callbacks failed");
+
+    return ESP_OK;
+}
+
+IRAM_ATTR static bool panel_st7701_on_color_trans_done(esp_lcd_panel_handle_t panel, esp_lcd_dpi_panel_event_data_t *edata,
+                                                       void *user_ctx)
+{
+    st7701_panel_t *st7701 = (st7701_panel_t *)user_ctx;
+
+    return st7701->dpi_cbs.on_color_trans_done(panel, edata, st7701->dpi_cbs_ctx);
+}
+
+#if CONFIG_ST7701_FRAME_STATS
+// Called with the swap lock held, keep it short
+IRAM_ATTR static void panel_st7701_pacing_refresh(st7701_panel_t *st7701)
+{
+    st7701_frame_stats_t *stats = &st7701->pacing.stats;
+
+    stats->refreshes++;
+    st7701->pacing.repeats++;
+    if (!st7701->pacing.submit_us) {
+        return;
+    }
+
+    // Whatever was drawn since the last refresh is scanned out from now on
+    uint32_t latency_us = esp_timer_get_time() - st7701->pacing.submit_us;
+    uint32_t ms = latency_us >> 10;
+    int bucket = ms ? 32 - __builtin_clz(ms) : 0;
+
+    if (bucket >= ST7701_FRAME_LATENCY_BUCKETS) {
+        bucket = ST7701_FRAME_LATENCY_BUCKETS - 1;
+    }
+    stats->latency_hist[bucket]++;
+    stats->latency_sum_us += latency_us;
+    if (latency_us > stats->latency_max_us) {
+        stats->latency_max_us = latency_us;
+    }
+    if (st7701->pacing.repeats > CONFIG_ST7701_FRAME_STATS_INTERVAL && stats->frames_scanned_out) {
+        stats->deadlines_missed++;
+    }
+    stats->frames_scanned_out++;
+    st7701->pacing.repeats = 0;
+    st7701->pacing.submit_us = 0;
+}
+#endif
+
+IRAM_ATTR static bool panel_st7701_on_refresh_done(esp_lcd_panel_handle_t panel, esp_lcd_dpi_panel_event_data_t *edata,
+                                                   void *user_ctx)
+{
+    st7701_panel_t *st7701 = (st7701_panel_t *)user_ctx;
+
+    portENTER_CRITICAL_ISR(&st7701->swap.lock);
+#if CONFIG_ST7701_FRAME_STATS
+    panel_st7701_pacing_refresh(st7701);
+#endif
+    st7701->swap.stats.refreshes++;
+    st7701->swap.repeats++;
+    // The DMA has moved on to the presented frame buffer, the previous one is free from now on
+    if (st7701->swap.pending >= 0) {
+        if (st7701->swap.repeats > 1 && st7701->swap.stats.frames_shown) {
+            st7701->swap.stats.frames_late++;
+        }
+        st7701->swap.front = st7701->swap.pending;
+        st7701->swap.pending = -1;
+        st7701->swap.repeats = 0;
+        st7701->swap.stats.frames_shown++;
+    }
+    portEXIT_CRITICAL_ISR(&st7701->swap.lock);
+
+    if (st7701->dpi_cbs.on_refresh_done) {
+        return st7701->dpi_cbs.on_refresh_done(panel, edata, st7701->dpi_cbs_ctx);
+    }
+    return false;
+}
+
+// The MIPI DPI panel takes one set of callbacks, the driver's own forward to the application's
+static esp_err_t panel_st7701_register_dpi_cbs(st7701_panel_t *st7701, esp_lcd_panel_t *panel)
+{
+    esp_lcd_dpi_panel_event_callbacks_t cbs = {
+        .on_color_trans_done = st7701->dpi_cbs.on_color_trans_done ? panel_st7701_on_color_trans_done : NULL,
+        .on_refresh_done = st7701->dpi_cbs.on_refresh_done || st7701->num_fbs > 1 ? panel_st7701_on_refresh_done : NULL,
+    };
+
+#if CONFIG_ST7701_FRAME_STATS
+    cbs.on_refresh_done = panel_st7701_on_refresh_done;
+#endif
+
+    if (!cbs.on_color_trans_done && !cbs.on_refresh_done) {
+        return ESP_OK;
+    }
+    return esp_lcd_dpi_panel_register_event_callbacks(panel, &cbs, st7701);
+}
+
+static esp_err_t panel_st7701_get_swap_fbs(st7701_panel_t *st7701, esp_lcd_panel_t *panel)
+{
+    ESP_RETURN_ON_FALSE(st7701->num_fbs > 1, ESP_ERR_INVALID_STATE, TAG, "buffer swapping needs 2 or 3 frame buffers");
+    if (!st7701->swap.fbs[0]) {
+        ESP_RETURN_ON_ERROR(esp_lcd_dpi_panel_get_frame_buffer(panel, st7701->num_fbs, &st7701->swap.fbs[0], &st7701->swap.fbs[1],
+                                                               &st7701->swap.fbs[2]), TAG, "get frame buffer failed");
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_get_back_buffer(esp_lcd_panel_handle_t panel, void **ret_fb)
+{
+    ESP_RETURN_ON_FALSE(panel && ret_fb, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+    int index = -1;
+
+    ESP_RETURN_ON_ERROR(panel_st7701_get_swap_fbs(st7701, panel), TAG, "get frame buffers failed");
+    portENTER_CRITICAL(&st7701->swap.lock);
+    for (int i = 0; i < st7701->num_fbs; i++) {
+        if (i != st7701->swap.front && i != st7701->swap.pending) {
+            index = i;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&st7701->swap.lock);
+    // Double buffering with a frame still waiting for the next refresh
+    if (index < 0) {
+        return ESP_ERR_NOT_FINISHED;
+    }
+    *ret_fb = st7701->swap.fbs[index];
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_present(esp_lcd_panel_handle_t panel, void *fb)
+{
+    ESP_RETURN_ON_FALSE(panel && fb, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+    int index = -1;
+
+    ESP_RETURN_ON_ERROR(panel_st7701_get_swap_fbs(st7701, panel), TAG, "get frame buffers failed");
+    for (int i = 0; i < st7701->num_fbs; i++) {
+        if (fb == st7701->swap.fbs[i]) {
+            index = i;
+        }
+    }
+    ESP_RETURN_ON_FALSE(index >= 0, ESP_ERR_INVALID_ARG, TAG, "not a frame buffer of the panel");
+    ESP_RETURN_ON_FALSE(index != st7701->swap.front, ESP_ERR_INVALID_STATE, TAG, "frame buffer is being scanned out");
+
+    // Drawing one of its own frame buffers makes the MIPI DPI panel write back the cache and switch to it at the end of
+    // the current refresh. Only mark it pending afterwards, so a refresh in between can't free the front buffer early.
+    ESP_RETURN_ON_ERROR(panel_st7701_draw_bitmap(panel, 0, 0, st7701->h_res, st7701->v_res, fb), TAG, "switch frame buffer failed");
+    portENTER_CRITICAL(&st7701->swap.lock);
+    if (st7701->swap.pending >= 0 && st7701->swap.pending != index) {
+        st7701->swap.stats.frames_dropped++;
+    }
+    st7701->swap.pending = index;
+    st7701->swap.stats.frames_presented++;
+    portEXIT_CRITICAL(&st7701->swap.lock);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_get_swap_stats(esp_lcd_panel_handle_t panel, st7701_swap_stats_t *ret_stats)
+{
+    ESP_RETURN_ON_FALSE(panel && ret_stats, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+
+    portENTER_CRITICAL(&st7701->swap.lock);
+    *ret_stats = st7701->swap.stats;
+    portEXIT_CRITICAL(&st7701->swap.lock);
+
+    return ESP_OK;
+}
+
+// Add the time since the current refresh rate was entered to its total
+static void panel_st7701_refresh_account(st7701_panel_t *st7701, int64_t now_us)
+{
+    if (st7701->refresh.mode_start_us) {
+        st7701->refresh.mode_us[st7701->refresh.low] += now_us - st7701->refresh.mode_start_us;
+        st7701->refresh.mode_start_us = now_us;
+    }
+}
+
+// Change the refresh rate through the vertical front porch, so the pixel clock and the frame buffers, and with them the
+// MIPI DPI panel, stay as they are. The panel's porch is sent first, outside the swap lock as the transfers block; only
+// the host's timing is changed under it, so the refresh ISR never sees the host and the bridge disagree.
+static esp_err_t panel_st7701_refresh_switch(st7701_panel_t *st7701, bool low)
+{
+    const esp_lcd_video_timing_t *video_timing = &st7701->dpi_config.video_timing;
+    dsi_host_dev_t *host = MIPI_DSI_LL_GET_HOST(st7701->dsi_bus_id);
+    dsi_brg_dev_t *brg = MIPI_DSI_LL_GET_BRG(st7701->dsi_bus_id);
+    uint32_t vfp = low ? st7701->refresh.low_vfp : video_timing->vsync_front_porch;
+    uint8_t porctrl[2] = {
+        st7701->refresh.porctrl[0],
+        low ? (vfp < ST7701_PORCTRL_MAX ? vfp : ST7701_PORCTRL_MAX) : st7701->refresh.porctrl[1],
+    };
+
+    if (panel_st7701_write_bank(st7701, ST7701_BANK_CMD2_BK0, ST7701_CMD_PORCTRL, porctrl, sizeof(porctrl)) != ESP_OK) {
+        // Which of the commands made it is unknown
+        st7701->shadow.valid.bank = 0;
+        st7701->shadow.valid.porctrl = 0;
+        ESP_LOGE(TAG, "send command failed");
+        return ESP_FAIL;
+    }
+
+    portENTER_CRITICAL(&st7701->swap.lock);
+    mipi_dsi_host_ll_dpi_set_vertical_timing(host, video_timing->vsync_pulse_width, video_timing->vsync_back_porch,
+                                             video_timing->v_size, vfp);
+    mipi_dsi_brg_ll_set_vertical_timing(brg, video_timing->vsync_pulse_width, video_timing->vsync_back_porch,
+                                        video_timing->v_size, vfp);
+    mipi_dsi_brg_ll_update_dpi_config(brg);
+    portEXIT_CRITICAL(&st7701->swap.lock);
+
+    panel_st7701_refresh_account(st7701, esp_timer_get_time());
+    st7701->refresh.low = low;
+    st7701->refresh.drawn = false;
+    st7701->refresh.switches++;
+    ESP_LOGD(TAG, "vertical front porch %"PRIu32" lines", vfp);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_set_refresh_scaling(esp_lcd_panel_handle_t panel, const st7701_refresh_scaling_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+
+    ESP_RETURN_ON_FALSE(!atomic_load(&st7701->async.busy), ESP_ERR_INVALID_STATE, TAG, "init in progress");
+    if (st7701->refresh.low) {
+        ESP_RETURN_ON_ERROR(panel_st7701_refresh_switch(st7701, false), TAG, "restore refresh rate failed");
+    }
+    if (!config) {
+        panel_st7701_refresh_account(st7701, esp_timer_get_time());
+        st7701->refresh.mode_start_us = 0;
+        st7701->refresh.idle_ms = 0;
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_FALSE(config->idle_ms && config->low_refresh_hz, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    const esp_lcd_video_timing_t *video_timing = &st7701->dpi_config.video_timing;
+    uint32_t h_total = video_timing->h_size + video_timing->hsync_pulse_width + video_timing->hsync_back_porch +
+                       video_timing->hsync_front_porch;
+    uint32_t v_lines = video_timing->v_size + video_timing->vsync_pulse_width + video_timing->vsync_back_porch;
+    // refresh_rate = dpi_clock_freq_mhz * 1000000 / (h_total * v_total), the front porch takes up the extra lines
+    uint64_t v_total = (uint64_t)st7701->dpi_config.dpi_clock_freq_mhz * 1000000 / ((uint64_t)h_total * config->low_refresh_hz);
+    ESP_RETURN_ON_FALSE(v_total > v_lines + video_timing->vsync_front_porch, ESP_ERR_INVALID_ARG, TAG,
+                        "low refresh rate must be below the configured one");
+    uint32_t low_vfp = v_total - v_lines;
+    if (low_vfp > ST7701_DSI_VFP_MAX) {
+        low_vfp = ST7701_DSI_VFP_MAX;
+        ESP_LOGW(TAG, "low refresh rate limited to %"PRIu32" Hz by the vertical front porch",
+                 (uint32_t)((uint64_t)st7701->dpi_config.dpi_clock_freq_mhz * 1000000 / ((uint64_t)h_total * (v_lines + low_vfp))));
+    }
+    // Only the front porch changes, keep the back porch the initialization sequence set
+    if (st7701->shadow.valid.porctrl) {
+        memcpy(st7701->refresh.porctrl, st7701->shadow.porctrl, sizeof(st7701->refresh.porctrl));
+    } else {
+        uint32_t vbp = video_timing->vsync_pulse_width + video_timing->vsync_back_porch;
+        st7701->refresh.porctrl[0] = vbp < ST7701_PORCTRL_MAX ? vbp : ST7701_PORCTRL_MAX;
+        st7701->refresh.porctrl[1] = video_timing->vsync_front_porch < ST7701_PORCTRL_MAX ? video_timing->vsync_front_porch :
+                                     ST7701_PORCTRL_MAX;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    panel_st7701_refresh_account(st7701, now_us);
+    st7701->refresh.idle_ms = config->idle_ms;
+    st7701->refresh.low_vfp = low_vfp;
+    st7701->refresh.last_draw_us = now_us;
+    st7701->refresh.mode_start_us = now_us;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_refresh_scaling_update(esp_lcd_panel_handle_t panel)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+
+    if (!st7701->refresh.idle_ms || atomic_load(&st7701->async.busy) || !st7701->flags.dpi_started) {
+        return ESP_OK;
+    }
+    if (st7701->refresh.low) {
+        if (st7701->refresh.drawn) {
+            ESP_RETURN_ON_ERROR(panel_st7701_refresh_switch(st7701, false), TAG, "raise refresh rate failed");
+        }
+    } else if (esp_timer_get_time() - st7701->refresh.last_draw_us >= (int64_t)st7701->refresh.idle_ms * 1000) {
+        ESP_RETURN_ON_ERROR(panel_st7701_refresh_switch(st7701, true), TAG, "lower refresh rate failed");
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_get_refresh_stats(esp_lcd_panel_handle_t panel, st7701_refresh_stats_t *ret_stats)
+{
+    ESP_RETURN_ON_FALSE(panel && ret_stats, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+
+    panel_st7701_refresh_account(st7701, esp_timer_get_time());
+    ret_stats->low = st7701->refresh.low;
+    ret_stats->switches = st7701->refresh.switches;
+    ret_stats->high_us = st7701->refresh.mode_us[0];
+    ret_stats->low_us = st7701->refresh.mode_us[1];
+
+    return ESP_OK;
+}
+
+// Keep track of the registers managed by the driver after `cmd` has been sent to the panel
+static void panel_st7701_shadow_update(st7701_panel_t *st7701, int cmd, const void *param, size_t param_size)
+{
+    const uint8_t *data = (const uint8_t *)param;
+    st7701_shadow_regs_t *shadow = &st7701->shadow;
+
+    shadow->writes_sent++;
+    if (cmd == ST7701_CMD_CND2BKxSEL) {
+        shadow->valid.bank = param_size == 5 && data[0] == 0x77 && data[1] == 0x01 && data[2] == 0x00 && data[3] == 0x00;
+        shadow->bank = shadow->valid.bank ? data[4] : 0;
+        return;
+    }
+    if (!shadow->valid.bank) {
+        return;
+    }
+    if (shadow->bank == ST7701_BANK_REGULAR) {
+        switch (cmd) {
+        case LCD_CMD_SWRESET:
+            memset(&shadow->valid, 0, sizeof(shadow->valid));
+            shadow->valid.bank = 1;
+            break;
+        case LCD_CMD_MADCTL:
+            shadow->valid.madctl = param_size == 1;
+            shadow->madctl = param_size == 1 ? data[0] : 0;
+            break;
+        case LCD_CMD_COLMOD:
+            shadow->valid.colmod = param_size == 1;
+            shadow->colmod = param_size == 1 ? data[0] : 0;
+            break;
+        case LCD_CMD_INVON:
+        case LCD_CMD_INVOFF:
+            shadow->valid.inversion = 1;
+            shadow->inverted = cmd == LCD_CMD_INVON;
+            break;
+        default:
+            break;
+        }
+    } else if (shadow->bank == ST7701_BANK_CMD2_BK0) {
+        if (cmd == ST7701_CMD_PVGAMCTRL) {
+            shadow->valid.pvgamma = param_size == sizeof(shadow->pvgamma);
+            memcpy(shadow->pvgamma, data, shadow->valid.pvgamma ? param_size : 0);
+        } else if (cmd == ST7701_CMD_NVGAMCTRL) {
+            shadow->valid.nvgamma = param_size == sizeof(shadow->nvgamma);
+            memcpy(shadow->nvgamma, data, shadow->valid.nvgamma ? param_size : 0);
+        } else if (cmd == ST7701_CMD_SDIR) {
+            shadow->valid.sdir = param_size == 1;
+            shadow->sdir = param_size == 1 ? data[0] : 0;
+        } else if (cmd == ST7701_CMD_PORCTRL) {
+            shadow->valid.porctrl = param_size == sizeof(shadow->porctrl);
+            memcpy(shadow->porctrl, data, shadow->valid.porctrl ? param_size : 0);
+        }
+    }
+}
+
+// Check whether sending `cmd` would leave the registers managed by the driver unchanged
+static bool panel_st7701_shadow_match(st7701_panel_t *st7701, int cmd, const void *param, size_t param_size)
+{
+    const uint8_t *data = (const uint8_t *)param;
+    st7701_shadow_regs_t *shadow = &st7701->shadow;
+
+    if (!shadow->valid.bank) {
+        return false;
+    }
+    if (cmd == ST7701_CMD_CND2BKxSEL) {
+        return param_size == 5 && data[0] == 0x77 && data[1] == 0x01 && data[2] == 0x00 && data[3] == 0x00 &&
+               data[4] == shadow->bank;
+    }
+
+    return panel_st7701_shadow_match_bank(st7701, shadow->bank, cmd, param, param_size);
+}
+
+// Check whether writing `cmd` in `bank` would leave the registers managed by the driver unchanged
+static bool panel_st7701_shadow_match_bank(st7701_panel_t *st7701, uint8_t bank, int cmd, const void *param, size_t param_size)
+{
+    const uint8_t *data = (const uint8_t *)param;
+    st7701_shadow_regs_t *shadow = &st7701->shadow;
+
+    if (bank == ST7701_BANK_REGULAR) {
+        switch (cmd) {
+        case LCD_CMD_MADCTL:
+            return shadow->valid.madctl && param_size == 1 && data[0] == shadow->madctl;
+        case LCD_CMD_COLMOD:
+            return shadow->valid.colmod && param_size == 1 && data[0] == shadow->colmod;
+        case LCD_CMD_INVON:
+        case LCD_CMD_INVOFF:
+            return shadow->valid.inversion && shadow->inverted == (cmd == LCD_CMD_INVON);
+        default:
+            return false;
+        }
+    }
+    if (bank == ST7701_BANK_CMD2_BK0) {
+        if (cmd == ST7701_CMD_PVGAMCTRL) {
+            return shadow->valid.pvgamma && param_size == sizeof(shadow->pvgamma) && !memcmp(data, shadow->pvgamma, param_size);
+        }
+        if (cmd == ST7701_CMD_NVGAMCTRL) {
+            return shadow->valid.nvgamma && param_size == sizeof(shadow->nvgamma) && !memcmp(data, shadow->nvgamma, param_size);
+        }
+        if (cmd == ST7701_CMD_SDIR) {
+            return shadow->valid.sdir && param_size == 1 && data[0] == shadow->sdir;
+        }
+        if (cmd == ST7701_CMD_PORCTRL) {
+            return shadow->valid.porctrl && param_size == sizeof(shadow->porctrl) && !memcmp(data, shadow->porctrl, param_size);
+        }
+    }
+
+    return false;
+}
+
+// Send a command unless the panel is known to be in the requested state already
+static esp_err_t panel_st7701_write(st7701_panel_t *st7701, int cmd, const void *param, size_t param_size)
+{
+    if (panel_st7701_shadow_match(st7701, cmd, param, param_size)) {
+        st7701->shadow.writes_elided++;
+        return ESP_OK;
+    }
+    ESP_RETURN_ON_ERROR(esp_lcd_panel_io_tx_param(st7701->io, cmd, param, param_size), TAG, "send command failed");
+    panel_st7701_shadow_update(st7701, cmd, param, param_size);
+
+    return ESP_OK;
+}
+
+// Write a register of a Command2 bank and select the regular bank again, unless the register holds the value already
+static esp_err_t panel_st7701_write_bank(st7701_panel_t *st7701, uint8_t bank, int cmd, const void *param, size_t param_size)
+{
+    if (panel_st7701_shadow_match_bank(st7701, bank, cmd, param, param_size)) {
+        st7701->shadow.writes_elided++;
+        return ESP_OK;
+    }
+    ESP_RETURN_ON_ERROR(panel_st7701_write(st7701, ST7701_CMD_CND2BKxSEL, (uint8_t []) {
+        0x77, 0x01, 0x00, 0x00, bank
+    }, 5), TAG, "select bank failed");
+    ESP_RETURN_ON_ERROR(panel_st7701_write(st7701, cmd, param, param_size), TAG, "send command failed");
+    ESP_RETURN_ON_ERROR(panel_st7701_write(st7701, ST7701_CMD_CND2BKxSEL, (uint8_t []) {
+        0x77, 0x01, 0x00, 0x00, ST7701_BANK_REGULAR
+    }, 5), TAG, "select bank failed");
+
+    return ESP_OK;
+}
+
+// The panel is back in its default state after a reset, only the selected bank is known
+static void panel_st7701_shadow_reset(st7701_panel_t *st7701)
+{
+    memset(&st7701->shadow.valid, 0, sizeof(st7701->shadow.valid));
+    st7701->shadow.bank = ST7701_BANK_REGULAR;
+    st7701->shadow.valid.bank = 1;
+}
+
+esp_err_t esp_lcd_st7701_get_shadow_stats(esp_lcd_panel_handle_t panel, st7701_shadow_stats_t *ret_stats)
+{
+    ESP_RETURN_ON_FALSE(panel && ret_stats, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+
+    ret_stats->writes_sent = st7701->shadow.writes_sent;
+    ret_stats->writes_elided = st7701->shadow.writes_elided;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_get_init_optimize_stats(esp_lcd_panel_handle_t panel, st7701_init_optimize_stats_t *ret_stats)
+{
+    ESP_RETURN_ON_FALSE(panel && ret_stats, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+
+    *ret_stats = st7701->vendor_cmds_stats;
+
+    return ESP_OK;
+}
+
+#if CONFIG_ST7701_INIT_TRACE
+static void panel_st7701_trace_start(st7701_panel_t *st7701)
+{
+    st7701->trace.head = 0;
+    st7701->trace.count = 0;
+}
+
+static st7701_init_trace_entry_t *panel_st7701_trace_last(st7701_panel_t *st7701)
+{
+    if (!st7701->trace.count) {
+        return NULL;
+    }
+    return &st7701->trace.entries[(st7701->trace.head + CONFIG_ST7701_INIT_TRACE_DEPTH - 1) % CONFIG_ST7701_INIT_TRACE_DEPTH];
+}
+
+static void panel_st7701_trace_record(st7701_panel_t *st7701, const st7701_lcd_init_cmd_t *cmd, int64_t start_us, esp_err_t ret)
+{
+    int64_t end_us = esp_timer_get_time();
+    st7701_init_trace_entry_t *entry = panel_st7701_trace_last(st7701);
+
+    // The previous command slept until this one started
+    if (entry) {
+        entry->sleep_us = start_us - st7701->trace.last_end_us;
+    }
+    entry = &st7701->trace.entries[st7701->trace.head];
+    entry->start_us = start_us;
+    entry->bus_us = end_us - start_us;
+    entry->sleep_us = 0;
+    entry->cmd = cmd->cmd;
+    entry->data_bytes = cmd->data_bytes;
+    entry->ret = ret;
+    st7701->trace.head = (st7701->trace.head + 1) % CONFIG_ST7701_INIT_TRACE_DEPTH;
+    if (st7701->trace.count < CONFIG_ST7701_INIT_TRACE_DEPTH) {
+        st7701->trace.count++;
+    }
+    st7701->trace.last_end_us = end_us;
+}
+
+static void panel_st7701_trace_finish(st7701_panel_t *st7701)
+{
+    st7701_init_trace_entry_t *entry = panel_st7701_trace_last(st7701);
+
+    if (entry) {
+        entry->sleep_us = esp_timer_get_time() - st7701->trace.last_end_us;
+    }
+}
+
+esp_err_t esp_lcd_st7701_get_init_trace(esp_lcd_panel_handle_t panel, st7701_init_trace_entry_t *entries, size_t max_entries,
+                                        size_t *ret_num_entries)
+{
+    ESP_RETURN_ON_FALSE(panel && (entries || !max_entries) && ret_num_entries, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+    size_t count = st7701->trace.count < max_entries ? st7701->trace.count : max_entries;
+    size_t first = (st7701->trace.head + CONFIG_ST7701_INIT_TRACE_DEPTH - st7701->trace.count) % CONFIG_ST7701_INIT_TRACE_DEPTH;
+
+    for (size_t i = 0; i < count; i++) {
+        entries[i] = st7701->trace.entries[(first + i) % CONFIG_ST7701_INIT_TRACE_DEPTH];
+    }
+    *ret_num_entries = count;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_dump_init_trace(esp_lcd_panel_handle_t panel, FILE *stream)
+{
+    ESP_RETURN_ON_FALSE(panel && stream, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+    size_t first = (st7701->trace.head + CONFIG_ST7701_INIT_TRACE_DEPTH - st7701->trace.count) % CONFIG_ST7701_INIT_TRACE_DEPTH;
+
+    // Chrome trace event format, every command is a complete event followed by its sleep
+    fprintf(stream, "{\"traceEvents\":[");
+    for (size_t i = 0; i < st7701->trace.count; i++) {
+        const st7701_init_trace_entry_t *entry = &st7701->trace.entries[(first + i) % CONFIG_ST7701_INIT_TRACE_DEPTH];
+        fprintf(stream, "%s\n{\"name\":\"0x%02X\",\"cat\":\"dcs\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%"PRId64",\"dur\":%"PRIu32","
+                "\"args\":{\"bytes\":%u,\"ret\":\"%s\"}}", i ? "," : "", entry->cmd, entry->start_us, entry->bus_us,
+                entry->data_bytes, esp_err_to_name(entry->ret));
+        if (entry->sleep_us) {
+            fprintf(stream, ",\n{\"name\":\"sleep\",\"cat\":\"delay\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%"PRId64",\"dur\":%"PRIu32"}",
+                    entry->start_us + entry->bus_us, entry->sleep_us);
+        }
+    }
+    fprintf(stream, "\n]}\n");
+
+    return ESP_OK;
+}
+#else
+static void panel_st7701_trace_start(st7701_panel_t *st7701)
+{
+}
+
+static void panel_st7701_trace_record(st7701_panel_t *st7701, const st7701_lcd_init_cmd_t *cmd, int64_t start_us, esp_err_t ret)
+{
+}
+
+static void panel_st7701_trace_finish(st7701_panel_t *st7701)
+{
+}
+
+esp_err_t esp_lcd_st7701_get_init_trace(esp_lcd_panel_handle_t panel, st7701_init_trace_entry_t *entries, size_t max_entries,
+                                        size_t *ret_num_entries)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_st7701_dump_init_trace(esp_lcd_panel_handle_t panel, FILE *stream)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+#endif
+
+#if CONFIG_ST7701_FRAME_STATS
+static void panel_st7701_pacing_submit(st7701_panel_t *st7701)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    // All draws until the next refresh make up one frame
+    portENTER_CRITICAL(&st7701->swap.lock);
+    if (!st7701->pacing.submit_us) {
+        st7701->pacing.submit_us = now_us;
+        st7701->pacing.stats.frames_submitted++;
+    }
+    portEXIT_CRITICAL(&st7701->swap.lock);
+}
+
+esp_err_t esp_lcd_st7701_get_frame_stats(esp_lcd_panel_handle_t panel, st7701_frame_stats_t *ret_stats)
+{
+    ESP_RETURN_ON_FALSE(panel && ret_stats, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+
+    portENTER_CRITICAL(&st7701->swap.lock);
+    *ret_stats = st7701->pacing.stats;
+    portEXIT_CRITICAL(&st7701->swap.lock);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_reset_frame_stats(esp_lcd_panel_handle_t panel)
+{
+    ESP_RETURN_ON_FALSE(panel, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_panel_t *st7701 = (st7701_panel_t *)panel->user_data;
+
+    portENTER_CRITICAL(&st7701->swap.lock);
+    memset(&st7701->pacing, 0, sizeof(st7701->pacing));
+    portEXIT_CRITICAL(&st7701->swap.lock);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_dump_frame_stats(esp_lcd_panel_handle_t panel, FILE *stream)
+{
+    ESP_RETURN_ON_FALSE(panel && stream, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    st7701_frame_stats_t stats;
+    uint32_t peak = 1;
+
+    ESP_RETURN_ON_ERROR(esp_lcd_st7701_get_frame_stats(panel, &stats), TAG, "get frame stats failed");
+    fprintf(stream, "refreshes %"PRIu32", frames submitted %"PRIu32", scanned out %"PRIu32", deadlines missed %"PRIu32"\n",
+            stats.refreshes, stats.frames_submitted, stats.frames_scanned_out, stats.deadlines_missed);
+    if (!stats.frames_scanned_out) {
+        return ESP_OK;
+    }
+    fprintf(stream, "submit to scan out latency: avg %"PRIu64" us, max %"PRIu32" us\n",
+            stats.latency_sum_us / stats.frames_scanned_out, stats.latency_max_us);
+    for (int i = 0; i < ST7701_FRAME_LATENCY_BUCKETS; i++) {
+        if (stats.latency_hist[i] > peak) {
+            peak = stats.latency_hist[i];
+        }
+    }
+    for (int i = 0; i < ST7701_FRAME_LATENCY_BUCKETS; i++) {
+        char bar[41];
+        int len = (uint64_t)stats.latency_hist[i] * (sizeof(bar) - 1) / peak;
+
+        memset(bar, '#', len);
+        bar[len] = '\0';
+        if (i < ST7701_FRAME_LATENCY_BUCKETS - 1) {
+            fprintf(stream, "  < %7"PRIu32" us %10"PRIu32" %s\n", (uint32_t)1024 << i, stats.latency_hist[i], bar);
+        } else {
+            fprintf(stream, " >= %7"PRIu32" us %10"PRIu32" %s\n", (uint32_t)1024 << (i - 1), stats.latency_hist[i], bar);
+        }
+    }
+
+    return ESP_OK;
+}
+#else
+static void panel_st7701_pacing_submit(st7701_panel_t *st7701)
+{
+}
+
+esp_err_t esp_lcd_st7701_get_frame_stats(esp_lcd_panel_handle_t panel, st7701_frame_stats_t *ret_stats)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_st7701_reset_frame_stats(esp_lcd_panel_handle_t panel)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_st7701_dump_frame_stats(esp_lcd_panel_handle_t panel, FILE *stream)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+#endif
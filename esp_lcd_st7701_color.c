@@ -0,0 +1,168 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdbool.h>
+#include "esp_check.h"
+#include "esp_lcd_st7701_color.h"
+
+static const char *TAG = "ST7701";
+
+// 4x4 Bayer matrix, thresholds 0..15
+static const uint8_t s_bayer[4][4] = {
+    { 0,  8,  2, 10},
+    {12,  4, 14,  6},
+    { 3, 11,  1,  9},
+    {15,  7, 13,  5},
+};
+
+typedef void (*st7701_color_row_t)(const uint8_t *src, uint8_t *dst, uint16_t width, const uint8_t *thresholds);
+
+// Add up to one quantization step before truncating to `bits`, on average half a step, i.e. rounding
+static inline uint8_t st7701_dither(uint8_t value, uint8_t threshold, int bits)
+{
+    uint32_t dithered = value + ((threshold << (8 - bits)) >> 4);
+
+    return dithered > 0xFF ? 0xFF : dithered;
+}
+
+// The row kernels are kept branch free per pixel with the source width and dithering as compile time constants, so the
+// compiler can unroll and vectorize each specialization
+static inline void st7701_row_to_rgb565(const uint8_t *src, int src_bytes, uint8_t *dst, uint16_t width, const uint8_t *thresholds,
+                                        bool dither)
+{
+    for (uint16_t i = 0; i < width; i++, src += src_bytes, dst += 2) {
+        uint8_t b = src[0];
+        uint8_t g = src[1];
+        uint8_t r = src[2];
+        if (dither) {
+            uint8_t threshold = thresholds[i & 3];
+            b = st7701_dither(b, threshold, 5);
+            g = st7701_dither(g, threshold, 6);
+            r = st7701_dither(r, threshold, 5);
+        }
+        uint16_t pixel = (r & 0xF8) << 8 | (g & 0xFC) << 3 | b >> 3;
+        dst[0] = pixel;
+        dst[1] = pixel >> 8;
+    }
+}
+
+static inline void st7701_row_to_rgb666(const uint8_t *src, int src_bytes, uint8_t *dst, uint16_t width, const uint8_t *thresholds,
+                                        bool dither)
+{
+    for (uint16_t i = 0; i < width; i++, src += src_bytes, dst += 3) {
+        uint8_t b = src[0];
+        uint8_t g = src[1];
+        uint8_t r = src[2];
+        if (dither) {
+            uint8_t threshold = thresholds[i & 3];
+            b = st7701_dither(b, threshold, 6);
+            g = st7701_dither(g, threshold, 6);
+            r = st7701_dither(r, threshold, 6);
+        }
+        dst[0] = b & 0xFC;
+        dst[1] = g & 0xFC;
+        dst[2] = r & 0xFC;
+    }
+}
+
+static inline void st7701_row_to_rgb888(const uint8_t *src, int src_bytes, uint8_t *dst, uint16_t width)
+{
+    for (uint16_t i = 0; i < width; i++, src += src_bytes, dst += 3) {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+    }
+}
+
+#define ST7701_COLOR_ROWS(name, src_bytes)                                                                              \
+    static void st7701_row_##name##_to_rgb565(const uint8_t *src, uint8_t *dst, uint16_t width, const uint8_t *t)      \
+    {                                                                                                                   \
+        st7701_row_to_rgb565(src, src_bytes, dst, width, t, false);                                                     \
+    }                                                                                                                   \
+    static void st7701_row_##name##_to_rgb565_dither(const uint8_t *src, uint8_t *dst, uint16_t width, const uint8_t *t)\
+    {                                                                                                                   \
+        st7701_row_to_rgb565(src, src_bytes, dst, width, t, true);                                                      \
+    }                                                                                                                   \
+    static void st7701_row_##name##_to_rgb666(const uint8_t *src, uint8_t *dst, uint16_t width, const uint8_t *t)      \
+    {                                                                                                                   \
+        st7701_row_to_rgb666(src, src_bytes, dst, width, t, false);                                                     \
+    }                                                                                                                   \
+    static void st7701_row_##name##_to_rgb666_dither(const uint8_t *src, uint8_t *dst, uint16_t width, const uint8_t *t)\
+    {                                                                                                                   \
+        st7701_row_to_rgb666(src, src_bytes, dst, width, t, true);                                                      \
+    }                                                                                                                   \
+    static void st7701_row_##name##_to_rgb888(const uint8_t *src, uint8_t *dst, uint16_t width, const uint8_t *t)      \
+    {                                                                                                                   \
+        (void)t;                                                                                                        \
+        st7701_row_to_rgb888(src, src_bytes, dst, width);                                                               \
+    }
+
+ST7701_COLOR_ROWS(rgb888, 3)
+ST7701_COLOR_ROWS(argb8888, 4)
+
+// Indexed by destination format (RGB565, RGB666, RGB888) and dithering
+static const st7701_color_row_t s_rows_rgb888[3][2] = {
+    {st7701_row_rgb888_to_rgb565, st7701_row_rgb888_to_rgb565_dither},
+    {st7701_row_rgb888_to_rgb666, st7701_row_rgb888_to_rgb666_dither},
+    {st7701_row_rgb888_to_rgb888, st7701_row_rgb888_to_rgb888},
+};
+
+static const st7701_color_row_t s_rows_argb8888[3][2] = {
+    {st7701_row_argb8888_to_rgb565, st7701_row_argb8888_to_rgb565_dither},
+    {st7701_row_argb8888_to_rgb666, st7701_row_argb8888_to_rgb666_dither},
+    {st7701_row_argb8888_to_rgb888, st7701_row_argb8888_to_rgb888},
+};
+
+uint8_t esp_lcd_st7701_color_bytes(st7701_color_format_t format)
+{
+    switch (format) {
+    case ST7701_COLOR_FORMAT_RGB565:
+        return 2;
+    case ST7701_COLOR_FORMAT_ARGB8888:
+        return 4;
+    default:
+        return 3;
+    }
+}
+
+esp_err_t esp_lcd_st7701_convert_color(const st7701_color_conv_config_t *config, const void *src, void *dst)
+{
+    ESP_RETURN_ON_FALSE(config && src && dst, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    ESP_RETURN_ON_FALSE(config->dst_format <= ST7701_COLOR_FORMAT_RGB888, ESP_ERR_NOT_SUPPORTED, TAG, "unsupported destination format");
+    const st7701_color_row_t (*rows)[2] = NULL;
+
+    switch (config->src_format) {
+    case ST7701_COLOR_FORMAT_RGB888:
+        rows = s_rows_rgb888;
+        break;
+    case ST7701_COLOR_FORMAT_ARGB8888:
+        rows = s_rows_argb8888;
+        break;
+    default:
+        ESP_LOGE(TAG, "unsupported source format");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    st7701_color_row_t row = rows[config->dst_format][config->dither == ST7701_DITHER_ORDERED];
+    size_t src_stride = config->src_stride ? config->src_stride :
+                        (size_t)config->width * esp_lcd_st7701_color_bytes(config->src_format);
+    size_t dst_stride = config->dst_stride ? config->dst_stride :
+                        (size_t)config->width * esp_lcd_st7701_color_bytes(config->dst_format);
+    const uint8_t *from = src;
+    uint8_t *to = dst;
+
+    for (uint16_t y = 0; y < config->height; y++, from += src_stride, to += dst_stride) {
+        // Rotate the matrix row so that index 0 lines up with the first pixel of the block
+        const uint8_t *bayer = s_bayer[(config->y + y) & 3];
+        uint8_t thresholds[4];
+        for (int i = 0; i < 4; i++) {
+            thresholds[i] = bayer[(config->x + i) & 3];
+        }
+        row(from, to, config->width, thresholds);
+    }
+
+    return ESP_OK;
+}
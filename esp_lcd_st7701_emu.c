@@ -0,0 +1,266 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_check.h"
+#include "esp_lcd_st7701_emu.h"
+
+#define ST7701_CMD_SWRESET          (0x01)
+#define ST7701_CMD_SLPIN            (0x10)
+#define ST7701_CMD_SLPOUT           (0x11)
+#define ST7701_CMD_DISPOFF          (0x28)
+#define ST7701_CMD_DISPON           (0x29)
+#define ST7701_CMD_CND2BKxSEL       (0xFF)  // Command2 BKx selection
+#define ST7701_BANK_REGULAR         (0x00)
+#define ST7701_BANK_CMD2_BK0        (0x10)
+#define ST7701_BANK_CMD2_BK1        (0x11)
+#define ST7701_BANK_CMD2_BK3        (0x13)
+
+#define ST7701_SWRESET_WAIT_US      (5000)
+#define ST7701_SWRESET_SLPOUT_US    (120000)
+#define ST7701_SLEEP_WAIT_US        (5000)
+#define ST7701_SLEEP_TOGGLE_US      (120000)
+
+static const char *TAG = "ST7701";
+
+// Writable registers and their payload lengths, from the datasheet and the default initialization sequence
+static const st7701_emu_reg_t s_regs[] = {
+    {ST7701_BANK_REGULAR, 0x00, 0, 0},      // NOP
+    {ST7701_BANK_REGULAR, 0x01, 0, 0},      // SWRESET
+    {ST7701_BANK_REGULAR, 0x10, 0, 0},      // SLPIN
+    {ST7701_BANK_REGULAR, 0x11, 0, 0},      // SLPOUT
+    {ST7701_BANK_REGULAR, 0x12, 0, 0},      // PTLON
+    {ST7701_BANK_REGULAR, 0x13, 0, 0},      // NORON
+    {ST7701_BANK_REGULAR, 0x20, 0, 0},      // INVOFF
+    {ST7701_BANK_REGULAR, 0x21, 0, 0},      // INVON
+    {ST7701_BANK_REGULAR, 0x28, 0, 0},      // DISPOFF
+    {ST7701_BANK_REGULAR, 0x29, 0, 0},      // DISPON
+    {ST7701_BANK_REGULAR, 0x30, 4, 4},      // PTLAR
+    {ST7701_BANK_REGULAR, 0x34, 0, 0},      // TEOFF
+    {ST7701_BANK_REGULAR, 0x35, 1, 1},      // TEON
+    {ST7701_BANK_REGULAR, 0x36, 1, 1},      // MADCTL
+    {ST7701_BANK_REGULAR, 0x38, 0, 0},      // IDMOFF
+    {ST7701_BANK_REGULAR, 0x39, 0, 0},      // IDMON
+    {ST7701_BANK_REGULAR, 0x3A, 1, 1},      // COLMOD
+    {ST7701_BANK_REGULAR, 0x51, 1, 1},      // WRDISBV
+    {ST7701_BANK_REGULAR, 0x53, 1, 1},      // WRCTRLD
+    {ST7701_BANK_REGULAR, 0x55, 1, 1},      // WRCACE
+    {ST7701_BANK_REGULAR, 0x5E, 1, 1},      // WRCABCMB
+    {ST7701_BANK_REGULAR, 0xEF, 1, 1},      // Undocumented, in the vendor sequences
+    {ST7701_BANK_CMD2_BK0, 0xB0, 16, 16},   // PVGAMCTRL
+    {ST7701_BANK_CMD2_BK0, 0xB1, 16, 16},   // NVGAMCTRL
+    {ST7701_BANK_CMD2_BK0, 0xC0, 2, 2},     // LNESET
+    {ST7701_BANK_CMD2_BK0, 0xC1, 2, 2},     // PORCTRL
+    {ST7701_BANK_CMD2_BK0, 0xC2, 2, 2},     // INVSET
+    {ST7701_BANK_CMD2_BK0, 0xC3, 3, 3},     // RGBCTRL
+    {ST7701_BANK_CMD2_BK0, 0xC7, 1, 1},     // SDIR
+    {ST7701_BANK_CMD2_BK0, 0xCC, 1, 1},     // Undocumented, in the vendor sequences
+    {ST7701_BANK_CMD2_BK0, 0xCD, 1, 1},     // COLCTRL
+    {ST7701_BANK_CMD2_BK1, 0xB0, 1, 1},     // VRHS
+    {ST7701_BANK_CMD2_BK1, 0xB1, 1, 1},     // VCOMS
+    {ST7701_BANK_CMD2_BK1, 0xB2, 1, 1},     // VGHSS
+    {ST7701_BANK_CMD2_BK1, 0xB3, 1, 1},     // TESTCMD
+    {ST7701_BANK_CMD2_BK1, 0xB5, 1, 1},     // VGLS
+    {ST7701_BANK_CMD2_BK1, 0xB7, 1, 1},     // PWCTRL1
+    {ST7701_BANK_CMD2_BK1, 0xB8, 1, 1},     // PWCTRL2
+    {ST7701_BANK_CMD2_BK1, 0xB9, 1, 1},     // DGMLUTR
+    {ST7701_BANK_CMD2_BK1, 0xC1, 1, 1},     // SPD1
+    {ST7701_BANK_CMD2_BK1, 0xC2, 1, 1},     // SPD2
+    {ST7701_BANK_CMD2_BK1, 0xD0, 1, 1},     // MIPISET1
+    {ST7701_BANK_CMD2_BK1, 0xE0, 3, 3},     // Gate timing, E0 to ED
+    {ST7701_BANK_CMD2_BK1, 0xE1, 11, 11},
+    {ST7701_BANK_CMD2_BK1, 0xE2, 12, 13},
+    {ST7701_BANK_CMD2_BK1, 0xE3, 4, 4},
+    {ST7701_BANK_CMD2_BK1, 0xE4, 2, 2},
+    {ST7701_BANK_CMD2_BK1, 0xE5, 16, 16},
+    {ST7701_BANK_CMD2_BK1, 0xE6, 4, 4},
+    {ST7701_BANK_CMD2_BK1, 0xE7, 2, 2},
+    {ST7701_BANK_CMD2_BK1, 0xE8, 16, 16},
+    {ST7701_BANK_CMD2_BK1, 0xE9, 2, 2},
+    {ST7701_BANK_CMD2_BK1, 0xEB, 7, 7},
+    {ST7701_BANK_CMD2_BK1, 0xEC, 2, 2},
+    {ST7701_BANK_CMD2_BK1, 0xED, 16, 16},
+    {ST7701_BANK_CMD2_BK1, 0xEF, 6, 6},
+};
+
+static int st7701_emu_bank_index(uint8_t bank)
+{
+    return bank == ST7701_BANK_REGULAR ? 0 : bank - ST7701_BANK_CMD2_BK0 + 1;
+}
+
+static const st7701_emu_reg_t *st7701_emu_find_reg(const st7701_emu_t *emu, uint8_t bank, int cmd)
+{
+    for (size_t i = 0; i < sizeof(s_regs) / sizeof(s_regs[0]); i++) {
+        if (s_regs[i].bank == bank && s_regs[i].cmd == cmd) {
+            return &s_regs[i];
+        }
+    }
+    for (size_t i = 0; i < emu->config.num_extra_regs; i++) {
+        if (emu->config.extra_regs[i].bank == bank && emu->config.extra_regs[i].cmd == cmd) {
+            return &emu->config.extra_regs[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void st7701_emu_violation(st7701_emu_t *emu, st7701_emu_violation_type_t type, int cmd, uint32_t wait_us)
+{
+    if (emu->num_violations < ST7701_EMU_VIOLATIONS_MAX) {
+        emu->violations[emu->num_violations] = (st7701_emu_violation_t) {
+            .type = type,
+            .index = emu->num_cmds - 1,
+            .cmd = cmd,
+            .bank = emu->bank,
+            .time_us = emu->last_us,
+            .wait_us = wait_us,
+        };
+    }
+    emu->num_violations++;
+}
+
+static void st7701_emu_reset(st7701_emu_t *emu)
+{
+    emu->bank = ST7701_BANK_REGULAR;
+    emu->sleeping = true;
+    emu->display_on = false;
+    memset(emu->reg_len, 0, sizeof(emu->reg_len));
+}
+
+esp_err_t esp_lcd_st7701_emu_init(st7701_emu_t *emu, const st7701_emu_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(emu && (!config || !config->num_extra_regs || config->extra_regs), ESP_ERR_INVALID_ARG, TAG,
+                        "invalid arguments");
+
+    memset(emu, 0, sizeof(st7701_emu_t));
+    if (config) {
+        emu->config = *config;
+    }
+    for (size_t i = 0; i < emu->config.num_extra_regs; i++) {
+        ESP_RETURN_ON_FALSE(emu->config.extra_regs[i].max_params <= ST7701_EMU_PARAM_MAX, ESP_ERR_INVALID_ARG, TAG,
+                            "register 0x%02X takes too many parameters", emu->config.extra_regs[i].cmd);
+    }
+    if (!emu->config.swreset_wait_us) {
+        emu->config.swreset_wait_us = ST7701_SWRESET_WAIT_US;
+    }
+    if (!emu->config.swreset_slpout_us) {
+        emu->config.swreset_slpout_us = ST7701_SWRESET_SLPOUT_US;
+    }
+    if (!emu->config.sleep_wait_us) {
+        emu->config.sleep_wait_us = ST7701_SLEEP_WAIT_US;
+    }
+    if (!emu->config.sleep_toggle_us) {
+        emu->config.sleep_toggle_us = ST7701_SLEEP_TOGGLE_US;
+    }
+    st7701_emu_reset(emu);
+    // A hardware reset holds off SLPOUT like SWRESET does
+    emu->slpout_us = emu->config.swreset_slpout_us;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_emu_tx_param(st7701_emu_t *emu, int64_t time_us, int cmd, const void *param, size_t param_size)
+{
+    ESP_RETURN_ON_FALSE(emu && (param || !param_size) && cmd >= 0 && cmd <= 0xFF, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid arguments");
+    ESP_RETURN_ON_FALSE(time_us >= emu->last_us, ESP_ERR_INVALID_ARG, TAG, "time went backwards");
+    const uint8_t *data = (const uint8_t *)param;
+    int64_t earliest_us = emu->next_us;
+
+    emu->num_cmds++;
+    emu->last_us = time_us;
+    if (emu->bank == ST7701_BANK_REGULAR && cmd == ST7701_CMD_SLPOUT && emu->slpout_us > earliest_us) {
+        earliest_us = emu->slpout_us;
+    } else if (emu->bank == ST7701_BANK_REGULAR && cmd == ST7701_CMD_SLPIN && emu->slpin_us > earliest_us) {
+        earliest_us = emu->slpin_us;
+    }
+    if (time_us < earliest_us) {
+        st7701_emu_violation(emu, ST7701_EMU_TOO_EARLY, cmd, earliest_us - time_us);
+    }
+
+    if (cmd == ST7701_CMD_CND2BKxSEL) {
+        if (param_size == 5 && data[0] == 0x77 && data[1] == 0x01 && data[2] == 0x00 && data[3] == 0x00 &&
+                (data[4] == ST7701_BANK_REGULAR || (data[4] >= ST7701_BANK_CMD2_BK0 && data[4] <= ST7701_BANK_CMD2_BK3))) {
+            emu->bank = data[4];
+        } else {
+            st7701_emu_violation(emu, ST7701_EMU_BAD_BANK_SELECT, cmd, 0);
+        }
+        return ESP_OK;
+    }
+
+    // Command2 banks replace the regular command set, a command of the wrong bank goes nowhere
+    const st7701_emu_reg_t *reg = st7701_emu_find_reg(emu, emu->bank, cmd);
+    if (!reg) {
+        st7701_emu_violation(emu, ST7701_EMU_UNKNOWN_REG, cmd, 0);
+        return ESP_OK;
+    }
+    if (param_size < reg->min_params || param_size > reg->max_params) {
+        st7701_emu_violation(emu, ST7701_EMU_PARAM_LEN, cmd, 0);
+    }
+    // The panel latches the parameters it expects, surplus ones are dropped
+    int bank_index = st7701_emu_bank_index(emu->bank);
+    size_t len = param_size < reg->max_params ? param_size : reg->max_params;
+    emu->reg_len[bank_index][cmd] = len;
+    memcpy(emu->reg_val[bank_index][cmd], data, len);
+
+    if (emu->bank != ST7701_BANK_REGULAR) {
+        return ESP_OK;
+    }
+    switch (cmd) {
+    case ST7701_CMD_SWRESET:
+        st7701_emu_reset(emu);
+        emu->next_us = time_us + emu->config.swreset_wait_us;
+        emu->slpout_us = time_us + emu->config.swreset_slpout_us;
+        break;
+    case ST7701_CMD_SLPOUT:
+        emu->sleeping = false;
+        emu->next_us = time_us + emu->config.sleep_wait_us;
+        emu->slpin_us = time_us + emu->config.sleep_toggle_us;
+        break;
+    case ST7701_CMD_SLPIN:
+        emu->sleeping = true;
+        emu->next_us = time_us + emu->config.sleep_wait_us;
+        emu->slpout_us = time_us + emu->config.sleep_toggle_us;
+        break;
+    case ST7701_CMD_DISPOFF:
+    case ST7701_CMD_DISPON:
+        emu->display_on = cmd == ST7701_CMD_DISPON;
+        break;
+    default:
+        break;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_emu_run_cmds(st7701_emu_t *emu, const st7701_lcd_init_cmd_t *cmds, size_t num_cmds)
+{
+    ESP_RETURN_ON_FALSE(emu && (cmds || !num_cmds), ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    int64_t time_us = emu->last_us;
+
+    for (size_t i = 0; i < num_cmds; i++) {
+        ESP_RETURN_ON_ERROR(esp_lcd_st7701_emu_tx_param(emu, time_us, cmds[i].cmd, cmds[i].data, cmds[i].data_bytes), TAG,
+                            "send command %d failed", (int)i);
+        time_us += cmds[i].delay_ms * 1000LL;
+    }
+    // The last delay elapses too
+    emu->last_us = time_us;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_emu_get_reg(const st7701_emu_t *emu, uint8_t bank, uint8_t cmd, uint8_t *ret_param, size_t *ret_size)
+{
+    ESP_RETURN_ON_FALSE(emu && ret_param && ret_size, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    ESP_RETURN_ON_FALSE(bank == ST7701_BANK_REGULAR || (bank >= ST7701_BANK_CMD2_BK0 && bank <= ST7701_BANK_CMD2_BK3),
+                        ESP_ERR_INVALID_ARG, TAG, "invalid bank");
+    int bank_index = st7701_emu_bank_index(bank);
+
+    *ret_size = emu->reg_len[bank_index][cmd];
+    memcpy(ret_param, emu->reg_val[bank_index][cmd], *ret_size);
+
+    return ESP_OK;
+}
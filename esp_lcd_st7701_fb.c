@@ -0,0 +1,267 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <stdbool.h>
+#include "esp_check.h"
+#include "esp_lcd_st7701_fb.h"
+
+static const char *TAG = "ST7701";
+
+static uint32_t st7701_rect_area(const st7701_rect_t *rect)
+{
+    return (uint32_t)(rect->x_end - rect->x_start) * (rect->y_end - rect->y_start);
+}
+
+static st7701_rect_t st7701_rect_union(const st7701_rect_t *a, const st7701_rect_t *b)
+{
+    return (st7701_rect_t) {
+        .x_start = a->x_start < b->x_start ? a->x_start : b->x_start,
+        .y_start = a->y_start < b->y_start ? a->y_start : b->y_start,
+        .x_end = a->x_end > b->x_end ? a->x_end : b->x_end,
+        .y_end = a->y_end > b->y_end ? a->y_end : b->y_end,
+    };
+}
+
+// Overlapping rectangles are always merged, others only if the union costs no extra copying (e.g. adjacent rows)
+static bool st7701_rect_should_merge(const st7701_rect_t *a, const st7701_rect_t *b)
+{
+    bool overlap = a->x_start < b->x_end && b->x_start < a->x_end && a->y_start < b->y_end && b->y_start < a->y_end;
+    if (overlap) {
+        return true;
+    }
+    st7701_rect_t merged = st7701_rect_union(a, b);
+    return st7701_rect_area(&merged) <= st7701_rect_area(a) + st7701_rect_area(b);
+}
+
+static void st7701_dirty_collapse(st7701_dirty_region_t *region)
+{
+    for (int i = 1; i < region->num_rects; i++) {
+        region->rects[0] = st7701_rect_union(&region->rects[0], &region->rects[i]);
+    }
+    region->num_rects = region->num_rects ? 1 : 0;
+}
+
+esp_err_t esp_lcd_st7701_dirty_init(st7701_dirty_region_t *region, const st7701_dirty_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(region && config && config->width && config->height && config->max_rects <= ST7701_DIRTY_RECTS_MAX &&
+                        config->bbox_percent <= 100, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+
+    memset(region, 0, sizeof(st7701_dirty_region_t));
+    region->config = *config;
+    if (!region->config.max_rects) {
+        region->config.max_rects = ST7701_DIRTY_RECTS_MAX;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_dirty_add(st7701_dirty_region_t *region, int x_start, int y_start, int x_end, int y_end)
+{
+    ESP_RETURN_ON_FALSE(region, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+
+    x_start = x_start < 0 ? 0 : x_start;
+    y_start = y_start < 0 ? 0 : y_start;
+    x_end = x_end > region->config.width ? region->config.width : x_end;
+    y_end = y_end > region->config.height ? region->config.height : y_end;
+    if (x_start >= x_end || y_start >= y_end) {
+        return ESP_OK;
+    }
+
+    st7701_rect_t rect = {x_start, y_start, x_end, y_end};
+    // A merge grows the rectangle, which can make it overlap rectangles already passed, so start over after each one
+    for (int i = 0; i < region->num_rects;) {
+        if (st7701_rect_should_merge(&rect, &region->rects[i])) {
+            rect = st7701_rect_union(&rect, &region->rects[i]);
+            region->rects[i] = region->rects[--region->num_rects];
+            i = 0;
+        } else {
+            i++;
+        }
+    }
+    if (region->num_rects >= region->config.max_rects) {
+        st7701_dirty_collapse(region);
+        rect = st7701_rect_union(&rect, &region->rects[0]);
+        region->num_rects = 0;
+    }
+    region->rects[region->num_rects++] = rect;
+
+    if (region->config.bbox_percent && region->num_rects > 1) {
+        st7701_rect_t bbox = region->rects[0];
+        for (int i = 1; i < region->num_rects; i++) {
+            bbox = st7701_rect_union(&bbox, &region->rects[i]);
+        }
+        if ((uint64_t)esp_lcd_st7701_dirty_area(region) * 100 >= (uint64_t)st7701_rect_area(&bbox) * region->config.bbox_percent) {
+            st7701_dirty_collapse(region);
+        }
+    }
+
+    return ESP_OK;
+}
+
+void esp_lcd_st7701_dirty_clear(st7701_dirty_region_t *region)
+{
+    region->num_rects = 0;
+}
+
+uint32_t esp_lcd_st7701_dirty_area(const st7701_dirty_region_t *region)
+{
+    uint32_t area = 0;
+
+    for (int i = 0; i < region->num_rects; i++) {
+        area += st7701_rect_area(&region->rects[i]);
+    }
+
+    return area;
+}
+
+size_t esp_lcd_st7701_dirty_copy(void *dst, const void *src, uint8_t bytes_per_pixel, const st7701_dirty_region_t *region)
+{
+    size_t stride = (size_t)region->config.width * bytes_per_pixel;
+    size_t copied = 0;
+
+    for (int i = 0; i < region->num_rects; i++) {
+        const st7701_rect_t *rect = &region->rects[i];
+        size_t offset = rect->y_start * stride + (size_t)rect->x_start * bytes_per_pixel;
+        size_t line_bytes = (size_t)(rect->x_end - rect->x_start) * bytes_per_pixel;
+        for (int y = rect->y_start; y < rect->y_end; y++) {
+            memcpy((uint8_t *)dst + offset, (const uint8_t *)src + offset, line_bytes);
+            offset += stride;
+        }
+        copied += line_bytes * (rect->y_end - rect->y_start);
+    }
+
+    return copied;
+}
+
+static bool st7701_fb_rect_valid(const st7701_fb_t *fb, int x_start, int y_start, int x_end, int y_end)
+{
+    return x_start >= 0 && y_start >= 0 && x_start < x_end && y_start < y_end && x_end <= fb->width && y_end <= fb->height;
+}
+
+static esp_err_t st7701_fb_check(const st7701_fb_t *fb, uint8_t *ret_bytes_per_pixel)
+{
+    ESP_RETURN_ON_FALSE(fb && fb->buffer, ESP_ERR_INVALID_ARG, TAG, "invalid frame buffer");
+    ESP_RETURN_ON_FALSE(fb->format == ST7701_COLOR_FORMAT_RGB565 || fb->format == ST7701_COLOR_FORMAT_RGB888,
+                        ESP_ERR_NOT_SUPPORTED, TAG, "unsupported pixel format");
+    *ret_bytes_per_pixel = esp_lcd_st7701_color_bytes(fb->format);
+
+    return ESP_OK;
+}
+
+// Pixel in the frame buffer's byte order, see `st7701_color_format_t`
+static void st7701_fb_pack(st7701_color_format_t format, uint8_t r, uint8_t g, uint8_t b, uint8_t *pixel)
+{
+    if (format == ST7701_COLOR_FORMAT_RGB565) {
+        uint16_t value = (r & 0xF8) << 8 | (g & 0xFC) << 3 | b >> 3;
+        pixel[0] = value;
+        pixel[1] = value >> 8;
+    } else {
+        pixel[0] = b;
+        pixel[1] = g;
+        pixel[2] = r;
+    }
+}
+
+static void st7701_fb_unpack(st7701_color_format_t format, const uint8_t *pixel, uint8_t *r, uint8_t *g, uint8_t *b)
+{
+    if (format == ST7701_COLOR_FORMAT_RGB565) {
+        uint16_t value = pixel[0] | pixel[1] << 8;
+        uint8_t r5 = value >> 11;
+        uint8_t g6 = (value >> 5) & 0x3F;
+        uint8_t b5 = value & 0x1F;
+        *r = r5 << 3 | r5 >> 2;
+        *g = g6 << 2 | g6 >> 4;
+        *b = b5 << 3 | b5 >> 2;
+    } else {
+        *b = pixel[0];
+        *g = pixel[1];
+        *r = pixel[2];
+    }
+}
+
+esp_err_t esp_lcd_st7701_fb_fill(const st7701_fb_t *fb, int x_start, int y_start, int x_end, int y_end, uint32_t color)
+{
+    uint8_t bytes_per_pixel = 0;
+    ESP_RETURN_ON_ERROR(st7701_fb_check(fb, &bytes_per_pixel), TAG, "invalid frame buffer");
+    ESP_RETURN_ON_FALSE(st7701_fb_rect_valid(fb, x_start, y_start, x_end, y_end), ESP_ERR_INVALID_ARG, TAG, "invalid area");
+    size_t stride = (size_t)fb->width * bytes_per_pixel;
+    size_t line_bytes = (size_t)(x_end - x_start) * bytes_per_pixel;
+    uint8_t *first = (uint8_t *)fb->buffer + y_start * stride + (size_t)x_start * bytes_per_pixel;
+    uint8_t pixel[3];
+
+    st7701_fb_pack(fb->format, color >> 16, color >> 8, color, pixel);
+    for (size_t offset = 0; offset < line_bytes; offset += bytes_per_pixel) {
+        memcpy(first + offset, pixel, bytes_per_pixel);
+    }
+    // Whole lines at a time from here on, which memcpy moves in cache line sized bursts
+    for (uint8_t *line = first + stride; line < first + (size_t)(y_end - y_start) * stride; line += stride) {
+        memcpy(line, first, line_bytes);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_fb_copy(const st7701_fb_t *fb, int x_start, int y_start, int x_end, int y_end, int x_dst, int y_dst)
+{
+    uint8_t bytes_per_pixel = 0;
+    ESP_RETURN_ON_ERROR(st7701_fb_check(fb, &bytes_per_pixel), TAG, "invalid frame buffer");
+    ESP_RETURN_ON_FALSE(st7701_fb_rect_valid(fb, x_start, y_start, x_end, y_end) &&
+                        st7701_fb_rect_valid(fb, x_dst, y_dst, x_dst + x_end - x_start, y_dst + y_end - y_start),
+                        ESP_ERR_INVALID_ARG, TAG, "invalid area");
+    size_t stride = (size_t)fb->width * bytes_per_pixel;
+    size_t line_bytes = (size_t)(x_end - x_start) * bytes_per_pixel;
+    int lines = y_end - y_start;
+    const uint8_t *src = (const uint8_t *)fb->buffer + y_start * stride + (size_t)x_start * bytes_per_pixel;
+    uint8_t *dst = (uint8_t *)fb->buffer + y_dst * stride + (size_t)x_dst * bytes_per_pixel;
+
+    // Moving down, start at the bottom so no line is overwritten before it has been read. memmove handles the overlap
+    // within a line.
+    if (y_dst > y_start) {
+        for (int i = lines - 1; i >= 0; i--) {
+            memmove(dst + i * stride, src + i * stride, line_bytes);
+        }
+    } else {
+        for (int i = 0; i < lines; i++) {
+            memmove(dst + i * stride, src + i * stride, line_bytes);
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_fb_blend(const st7701_fb_t *fb, int x_start, int y_start, int x_end, int y_end, const void *argb)
+{
+    uint8_t bytes_per_pixel = 0;
+    ESP_RETURN_ON_ERROR(st7701_fb_check(fb, &bytes_per_pixel), TAG, "invalid frame buffer");
+    ESP_RETURN_ON_FALSE(argb && st7701_fb_rect_valid(fb, x_start, y_start, x_end, y_end), ESP_ERR_INVALID_ARG, TAG,
+                        "invalid arguments");
+    size_t stride = (size_t)fb->width * bytes_per_pixel;
+    const uint8_t *fg = argb;
+
+    for (int y = y_start; y < y_end; y++) {
+        uint8_t *bg = (uint8_t *)fb->buffer + y * stride + (size_t)x_start * bytes_per_pixel;
+        for (int x = x_start; x < x_end; x++, fg += 4, bg += bytes_per_pixel) {
+            uint8_t alpha = fg[3];
+            uint8_t r, g, b;
+            // Opaque and transparent pixels are common in UI assets, skip the arithmetic for them
+            if (alpha == 0xFF) {
+                st7701_fb_pack(fb->format, fg[2], fg[1], fg[0], bg);
+                continue;
+            }
+            if (alpha == 0) {
+                continue;
+            }
+            st7701_fb_unpack(fb->format, bg, &r, &g, &b);
+            r = (fg[2] * alpha + r * (0xFF - alpha) + 127) / 0xFF;
+            g = (fg[1] * alpha + g * (0xFF - alpha) + 127) / 0xFF;
+            b = (fg[0] * alpha + b * (0xFF - alpha) + 127) / 0xFF;
+            st7701_fb_pack(fb->format, r, g, b, bg);
+        }
+    }
+
+    return ESP_OK;
+}
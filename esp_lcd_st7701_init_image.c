@@ -0,0 +1,107 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "esp_check.h"
+#include "esp_partition.h"
+#include "esp_lcd_st7701.h"
+
+static const char *TAG = "ST7701";
+
+static esp_err_t st7701_init_image_get_size(const uint8_t header[ST7701_INIT_IMAGE_HEADER_SIZE], size_t max_size,
+                                            size_t *ret_size)
+{
+    ESP_RETURN_ON_FALSE(memcmp(header, ST7701_INIT_IMAGE_MAGIC, 4) == 0, ESP_ERR_NOT_FOUND, TAG, "no init image found");
+
+    uint32_t bytecode_size = header[8] | (header[9] << 8) | (header[10] << 16) | ((uint32_t)header[11] << 24);
+    ESP_RETURN_ON_FALSE(bytecode_size <= ST7701_INIT_IMAGE_MAX_SIZE - ST7701_INIT_IMAGE_HEADER_SIZE &&
+                        bytecode_size <= max_size - ST7701_INIT_IMAGE_HEADER_SIZE, ESP_ERR_INVALID_SIZE, TAG,
+                        "invalid bytecode size %"PRIu32, bytecode_size);
+    *ret_size = ST7701_INIT_IMAGE_HEADER_SIZE + bytecode_size;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_init_image_load_partition(const char *label, st7701_init_image_t *ret_image)
+{
+    ESP_RETURN_ON_FALSE(label && ret_image, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    memset(ret_image, 0, sizeof(st7701_init_image_t));
+
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    ESP_RETURN_ON_FALSE(partition, ESP_ERR_NOT_FOUND, TAG, "partition %s not found", label);
+    ESP_RETURN_ON_FALSE(partition->size >= ST7701_INIT_IMAGE_HEADER_SIZE, ESP_ERR_INVALID_SIZE, TAG, "partition too small");
+
+    uint8_t header[ST7701_INIT_IMAGE_HEADER_SIZE];
+    size_t size = 0;
+    ESP_RETURN_ON_ERROR(esp_partition_read(partition, 0, header, sizeof(header)), TAG, "read image header failed");
+    ESP_RETURN_ON_ERROR(st7701_init_image_get_size(header, partition->size, &size), TAG, "invalid image header");
+
+    // Map the image instead of copying it, the bytecode is decoded straight from flash
+    const void *image = NULL;
+    esp_partition_mmap_handle_t mmap_handle;
+    ESP_RETURN_ON_ERROR(esp_partition_mmap(partition, 0, size, ESP_PARTITION_MMAP_DATA, &image, &mmap_handle), TAG,
+                        "map partition failed");
+    esp_err_t ret = esp_lcd_st7701_init_image_parse(image, size, &ret_image->bytecode, &ret_image->bytecode_size);
+    if (ret != ESP_OK) {
+        esp_partition_munmap(mmap_handle);
+        ESP_RETURN_ON_ERROR(ret, TAG, "invalid init image in partition %s", label);
+    }
+    ret_image->mmap_handle = mmap_handle;
+    ret_image->flags.mapped = true;
+    ESP_LOGD(TAG, "loaded %u bytes of init bytecode from partition %s", (unsigned int)ret_image->bytecode_size, label);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_init_image_load_file(const char *path, st7701_init_image_t *ret_image)
+{
+    ESP_RETURN_ON_FALSE(path && ret_image, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    memset(ret_image, 0, sizeof(st7701_init_image_t));
+
+    esp_err_t ret = ESP_OK;
+    uint8_t *image = NULL;
+    size_t size = 0;
+    uint8_t header[ST7701_INIT_IMAGE_HEADER_SIZE];
+    FILE *file = fopen(path, "rb");
+    ESP_RETURN_ON_FALSE(file, ESP_ERR_NOT_FOUND, TAG, "open %s failed", path);
+
+    ESP_GOTO_ON_FALSE(fread(header, 1, sizeof(header), file) == sizeof(header), ESP_ERR_INVALID_SIZE, err, TAG,
+                      "read image header failed");
+    ESP_GOTO_ON_ERROR(st7701_init_image_get_size(header, ST7701_INIT_IMAGE_MAX_SIZE, &size), err, TAG, "invalid image header");
+    image = malloc(size);
+    ESP_GOTO_ON_FALSE(image, ESP_ERR_NO_MEM, err, TAG, "no mem for init image");
+    memcpy(image, header, sizeof(header));
+    ESP_GOTO_ON_FALSE(fread(&image[sizeof(header)], 1, size - sizeof(header), file) == size - sizeof(header),
+                      ESP_ERR_INVALID_SIZE, err, TAG, "truncated init image");
+    ESP_GOTO_ON_ERROR(esp_lcd_st7701_init_image_parse(image, size, &ret_image->bytecode, &ret_image->bytecode_size), err,
+                      TAG, "invalid init image in %s", path);
+    fclose(file);
+    ret_image->buffer = image;
+    ESP_LOGD(TAG, "loaded %u bytes of init bytecode from %s", (unsigned int)ret_image->bytecode_size, path);
+
+    return ESP_OK;
+
+err:
+    free(image);
+    fclose(file);
+    return ret;
+}
+
+esp_err_t esp_lcd_st7701_init_image_release(st7701_init_image_t *image)
+{
+    ESP_RETURN_ON_FALSE(image, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+
+    if (image->flags.mapped) {
+        esp_partition_munmap(image->mmap_handle);
+    }
+    free(image->buffer);
+    memset(image, 0, sizeof(st7701_init_image_t));
+
+    return ESP_OK;
+}
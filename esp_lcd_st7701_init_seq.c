@@ -0,0 +1,468 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include <inttypes.h>
+#include "esp_check.h"
+#include "esp_lcd_st7701_init_seq.h"
+
+#define ST7701_CMD_CND2BKxSEL       (0xFF)  // Command2 BKx selection
+#define ST7701_CMD_RAMWR            (0x2C)
+#define ST7701_CMD_RAMWRC           (0x3C)
+#define ST7701_BANK_REGULAR         (0x00)
+#define ST7701_BANK_CMD2_BK0        (0x10)
+#define ST7701_BANK_CMD2_BK3        (0x13)
+
+#define ST7701_DSI_SHORT_PKT_BYTES  (4)     // DI, data0, data1, ECC
+#define ST7701_DSI_LONG_PKT_BYTES   (6)     // DI, WC (2), ECC, checksum (2)
+#define ST7701_DSI_ESC_CLK_MAX_KHZ  (20000) // Escape clock is divided down from the lane byte clock to at most 20 MHz
+#define ST7701_DSI_ESC_ENTRY_CYCLES (24)    // Escape entry, LPDT command and exit, in escape clock cycles
+#define ST7701_DSI_LINE_OVERHEAD_BYTES (20) // HSS, HSE, blanking and pixel packet headers and footers of a video line
+#define ST7701_DSI_LANE_RATE_MIN    (80)    // D-PHY lane bit rate range, in Mbps
+#define ST7701_DSI_LANE_RATE_MAX    (1500)
+
+#define ST7701_LINE_PCLK_BASE       (512)   // INVSET: minimum line length is 512 + 16 * RTNI pixel clock cycles
+#define ST7701_LINE_PCLK_STEP       (16)
+#define ST7701_RTNI_MAX             (31)
+#define ST7701_INVSET_INVERSION     (0x37)  // Column inversion, as in the default initialization sequence
+#define ST7701_HSYNC_PULSE_WIDTH    (10)
+#define ST7701_HSYNC_BACK_PORCH     (20)
+#define ST7701_HSYNC_FRONT_PORCH_MIN (10)
+#define ST7701_VSYNC_PULSE_WIDTH    (2)
+#define ST7701_VSYNC_BACK_PORCH     (14)
+#define ST7701_VSYNC_FRONT_PORCH    (12)
+
+static const char *TAG = "ST7701";
+
+esp_err_t esp_lcd_st7701_get_init_budget(const st7701_lcd_init_cmd_t *init_cmds, uint16_t init_cmds_size,
+                                         uint32_t lane_bit_rate_mbps, st7701_init_budget_t *ret_budget)
+{
+    ESP_RETURN_ON_FALSE((init_cmds || !init_cmds_size) && lane_bit_rate_mbps && ret_budget, ESP_ERR_INVALID_ARG, TAG,
+                        "invalid arguments");
+
+    uint32_t byte_clk_khz = lane_bit_rate_mbps * 1000 / 8;
+    uint32_t esc_clk_div = (byte_clk_khz + ST7701_DSI_ESC_CLK_MAX_KHZ - 1) / ST7701_DSI_ESC_CLK_MAX_KHZ;
+    uint32_t esc_clk_khz = byte_clk_khz / esc_clk_div;
+    uint64_t esc_cycles = 0;
+
+    memset(ret_budget, 0, sizeof(st7701_init_budget_t));
+    for (int i = 0; i < init_cmds_size; i++) {
+        // Zero or one parameter fits in a DCS short write, anything longer needs a DCS long write
+        uint32_t pkt_bytes = init_cmds[i].data_bytes <= 1 ? ST7701_DSI_SHORT_PKT_BYTES :
+                             ST7701_DSI_LONG_PKT_BYTES + 1 + init_cmds[i].data_bytes;
+
+        ret_budget->num_packets++;
+        ret_budget->payload_bytes += 1 + init_cmds[i].data_bytes;
+        ret_budget->wire_bytes += pkt_bytes;
+        ret_budget->delay_ms += init_cmds[i].delay_ms;
+        // Spaced-one-hot coding takes two escape clock cycles per bit
+        esc_cycles += ST7701_DSI_ESC_ENTRY_CYCLES + pkt_bytes * 8 * 2;
+    }
+    ret_budget->transfer_us = (uint32_t)((esc_cycles * 1000 + esc_clk_khz - 1) / esc_clk_khz);
+    ret_budget->total_us = ret_budget->transfer_us + ret_budget->delay_ms * 1000;
+
+    return ESP_OK;
+}
+
+static bool st7701_is_bank_select(const st7701_lcd_init_cmd_t *cmd)
+{
+    const uint8_t *data = (const uint8_t *)cmd->data;
+
+    return cmd->cmd == ST7701_CMD_CND2BKxSEL && cmd->data_bytes == 5 && data[0] == 0x77 && data[1] == 0x01 &&
+           data[2] == 0x00 && data[3] == 0x00;
+}
+
+static size_t st7701_varint_put(uint8_t *buf, uint32_t value)
+{
+    size_t len = 0;
+
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        if (buf) {
+            buf[len] = byte | (value ? 0x80 : 0x00);
+        }
+        len++;
+    } while (value);
+
+    return len;
+}
+
+static esp_err_t st7701_varint_get(st7701_bytecode_reader_t *reader, uint32_t *ret_value)
+{
+    uint32_t value = 0;
+
+    for (int shift = 0; shift < 32; shift += 7) {
+        ESP_RETURN_ON_FALSE(reader->offset < reader->size, ESP_ERR_INVALID_SIZE, TAG, "truncated varint");
+        uint8_t byte = reader->bytecode[reader->offset++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *ret_value = value;
+            return ESP_OK;
+        }
+    }
+
+    ESP_RETURN_ON_FALSE(false, ESP_ERR_INVALID_RESPONSE, TAG, "varint too long");
+}
+
+esp_err_t esp_lcd_st7701_bytecode_encode(const st7701_lcd_init_cmd_t *init_cmds, uint16_t init_cmds_size,
+                                         uint8_t *bytecode, size_t bytecode_size, size_t *ret_size)
+{
+    ESP_RETURN_ON_FALSE((init_cmds || !init_cmds_size) && ret_size, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+
+    uint8_t insn[2 + 255 + 1 + 5];
+    size_t size = 0;
+
+    for (int i = 0; i < init_cmds_size; i++) {
+        const st7701_lcd_init_cmd_t *cmd = &init_cmds[i];
+        size_t len = 0;
+
+        ESP_RETURN_ON_FALSE(cmd->cmd >= 0 && cmd->cmd <= 0xFF && cmd->data_bytes <= 0xFF && (cmd->data || !cmd->data_bytes),
+                            ESP_ERR_INVALID_ARG, TAG, "command %d can't be encoded", i);
+        if (st7701_is_bank_select(cmd)) {
+            insn[len++] = ST7701_INIT_OP_BANK;
+            insn[len++] = ((const uint8_t *)cmd->data)[4];
+        } else {
+            insn[len++] = ST7701_INIT_OP_CMD;
+            insn[len++] = cmd->cmd;
+            insn[len++] = cmd->data_bytes;
+            if (cmd->data_bytes) {
+                memcpy(&insn[len], cmd->data, cmd->data_bytes);
+                len += cmd->data_bytes;
+            }
+        }
+        if (cmd->delay_ms) {
+            insn[len++] = ST7701_INIT_OP_SLEEP;
+            len += st7701_varint_put(&insn[len], cmd->delay_ms);
+        }
+
+        if (bytecode) {
+            ESP_RETURN_ON_FALSE(size + len <= bytecode_size, ESP_ERR_INVALID_SIZE, TAG, "bytecode buffer too small");
+            memcpy(&bytecode[size], insn, len);
+        }
+        size += len;
+    }
+    *ret_size = size;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_bytecode_reader_init(st7701_bytecode_reader_t *reader, const uint8_t *bytecode, size_t size)
+{
+    ESP_RETURN_ON_FALSE(reader && (bytecode || !size), ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+
+    memset(reader, 0, sizeof(st7701_bytecode_reader_t));
+    reader->bytecode = bytecode;
+    reader->size = size;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_bytecode_next(st7701_bytecode_reader_t *reader, st7701_lcd_init_cmd_t *ret_cmd)
+{
+    ESP_RETURN_ON_FALSE(reader && ret_cmd, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+
+    if (reader->offset >= reader->size || reader->bytecode[reader->offset] == ST7701_INIT_OP_END) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const uint8_t *insn = &reader->bytecode[reader->offset];
+    size_t remain = reader->size - reader->offset;
+    switch (insn[0]) {
+    case ST7701_INIT_OP_CMD:
+        ESP_RETURN_ON_FALSE(remain >= 3 && remain - 3 >= insn[2], ESP_ERR_INVALID_SIZE, TAG, "truncated command @%u",
+                            (unsigned int)reader->offset);
+        ret_cmd->cmd = insn[1];
+        ret_cmd->data = insn[2] ? &insn[3] : NULL;
+        ret_cmd->data_bytes = insn[2];
+        reader->offset += 3 + insn[2];
+        break;
+    case ST7701_INIT_OP_BANK:
+        ESP_RETURN_ON_FALSE(remain >= 2, ESP_ERR_INVALID_SIZE, TAG, "truncated bank selection @%u", (unsigned int)reader->offset);
+        reader->bank_data[0] = 0x77;
+        reader->bank_data[1] = 0x01;
+        reader->bank_data[2] = 0x00;
+        reader->bank_data[3] = 0x00;
+        reader->bank_data[4] = insn[1];
+        ret_cmd->cmd = ST7701_CMD_CND2BKxSEL;
+        ret_cmd->data = reader->bank_data;
+        ret_cmd->data_bytes = sizeof(reader->bank_data);
+        reader->offset += 2;
+        break;
+    default:
+        ESP_RETURN_ON_FALSE(false, ESP_ERR_INVALID_RESPONSE, TAG, "unexpected opcode 0x%02X @%u", insn[0],
+                            (unsigned int)reader->offset);
+    }
+
+    // Fold the sleep instructions that follow into the delay of this command
+    ret_cmd->delay_ms = 0;
+    while (reader->offset < reader->size && reader->bytecode[reader->offset] == ST7701_INIT_OP_SLEEP) {
+        uint32_t delay_ms = 0;
+        reader->offset++;
+        ESP_RETURN_ON_ERROR(st7701_varint_get(reader, &delay_ms), TAG, "invalid sleep");
+        ret_cmd->delay_ms += delay_ms;
+    }
+
+    return ESP_OK;
+}
+
+static bool st7701_is_known_bank(uint8_t bank)
+{
+    return bank == ST7701_BANK_REGULAR || (bank >= ST7701_BANK_CMD2_BK0 && bank <= ST7701_BANK_CMD2_BK3);
+}
+
+esp_err_t esp_lcd_st7701_bytecode_validate(const uint8_t *bytecode, size_t size, uint16_t *ret_num_cmds)
+{
+    ESP_RETURN_ON_FALSE(bytecode || !size, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+
+    st7701_bytecode_reader_t reader;
+    st7701_lcd_init_cmd_t cmd;
+    uint8_t bank = ST7701_BANK_REGULAR;
+    uint16_t num_cmds = 0;
+    esp_err_t ret = ESP_OK;
+
+    esp_lcd_st7701_bytecode_reader_init(&reader, bytecode, size);
+    while ((ret = esp_lcd_st7701_bytecode_next(&reader, &cmd)) == ESP_OK) {
+        if (cmd.cmd == ST7701_CMD_CND2BKxSEL) {
+            ESP_RETURN_ON_FALSE(st7701_is_bank_select(&cmd), ESP_ERR_INVALID_RESPONSE, TAG,
+                                "malformed bank selection in command %d", num_cmds);
+            bank = ((const uint8_t *)cmd.data)[4];
+            ESP_RETURN_ON_FALSE(st7701_is_known_bank(bank), ESP_ERR_INVALID_RESPONSE, TAG,
+                                "unknown bank 0x%02X in command %d", bank, num_cmds);
+        }
+        ESP_RETURN_ON_FALSE(num_cmds < UINT16_MAX, ESP_ERR_INVALID_SIZE, TAG, "too many commands");
+        num_cmds++;
+    }
+    ESP_RETURN_ON_FALSE(ret == ESP_ERR_NOT_FOUND, ret, TAG, "invalid command %d", num_cmds);
+    // Everything after the sequence (standard DCS commands from the driver) assumes the regular command bank
+    ESP_RETURN_ON_FALSE(bank == ST7701_BANK_REGULAR, ESP_ERR_INVALID_STATE, TAG, "sequence doesn't end in the regular bank");
+
+    if (ret_num_cmds) {
+        *ret_num_cmds = num_cmds;
+    }
+
+    return ESP_OK;
+}
+
+uint32_t esp_lcd_st7701_crc32(uint32_t crc, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+
+    return ~crc;
+}
+
+static uint32_t st7701_get_le32(const uint8_t *data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static void st7701_put_le32(uint8_t *data, uint32_t value)
+{
+    data[0] = value;
+    data[1] = value >> 8;
+    data[2] = value >> 16;
+    data[3] = value >> 24;
+}
+
+esp_err_t esp_lcd_st7701_init_image_parse(const uint8_t *image, size_t size, const uint8_t **ret_bytecode,
+                                          size_t *ret_bytecode_size)
+{
+    ESP_RETURN_ON_FALSE(image && ret_bytecode && ret_bytecode_size, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    ESP_RETURN_ON_FALSE(size >= ST7701_INIT_IMAGE_HEADER_SIZE, ESP_ERR_INVALID_SIZE, TAG, "truncated image header");
+    ESP_RETURN_ON_FALSE(memcmp(image, ST7701_INIT_IMAGE_MAGIC, 4) == 0, ESP_ERR_NOT_FOUND, TAG, "no init image found");
+    ESP_RETURN_ON_FALSE(image[4] == ST7701_INIT_IMAGE_VERSION, ESP_ERR_INVALID_VERSION, TAG,
+                        "unsupported init image version %d", image[4]);
+
+    uint32_t bytecode_size = st7701_get_le32(&image[8]);
+    ESP_RETURN_ON_FALSE(bytecode_size <= ST7701_INIT_IMAGE_MAX_SIZE - ST7701_INIT_IMAGE_HEADER_SIZE &&
+                        bytecode_size <= size - ST7701_INIT_IMAGE_HEADER_SIZE, ESP_ERR_INVALID_SIZE, TAG,
+                        "invalid bytecode size %"PRIu32, bytecode_size);
+
+    const uint8_t *bytecode = &image[ST7701_INIT_IMAGE_HEADER_SIZE];
+    ESP_RETURN_ON_FALSE(esp_lcd_st7701_crc32(0, bytecode, bytecode_size) == st7701_get_le32(&image[12]),
+                        ESP_ERR_INVALID_CRC, TAG, "init image checksum mismatch");
+    ESP_RETURN_ON_ERROR(esp_lcd_st7701_bytecode_validate(bytecode, bytecode_size, NULL), TAG, "invalid bytecode");
+
+    *ret_bytecode = bytecode;
+    *ret_bytecode_size = bytecode_size;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_init_image_make_header(const uint8_t *bytecode, size_t size,
+                                                uint8_t ret_header[ST7701_INIT_IMAGE_HEADER_SIZE])
+{
+    ESP_RETURN_ON_FALSE((bytecode || !size) && ret_header, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    ESP_RETURN_ON_FALSE(size <= ST7701_INIT_IMAGE_MAX_SIZE - ST7701_INIT_IMAGE_HEADER_SIZE, ESP_ERR_INVALID_SIZE, TAG,
+                        "bytecode too large");
+
+    memset(ret_header, 0, ST7701_INIT_IMAGE_HEADER_SIZE);
+    memcpy(ret_header, ST7701_INIT_IMAGE_MAGIC, 4);
+    ret_header[4] = ST7701_INIT_IMAGE_VERSION;
+    st7701_put_le32(&ret_header[8], size);
+    st7701_put_le32(&ret_header[12], esp_lcd_st7701_crc32(0, bytecode, size));
+
+    return ESP_OK;
+}
+
+// Whether a later write to the same register makes this command redundant
+static bool st7701_is_mergeable(const st7701_lcd_init_cmd_t *cmd)
+{
+    // Commands without parameters are actions (SLPOUT, DISPON...), memory writes append data
+    return cmd->data_bytes && cmd->cmd != ST7701_CMD_CND2BKxSEL && cmd->cmd != ST7701_CMD_RAMWR &&
+           cmd->cmd != ST7701_CMD_RAMWRC;
+}
+
+esp_err_t esp_lcd_st7701_optimize_init_cmds(const st7701_lcd_init_cmd_t *init_cmds, uint16_t init_cmds_size,
+                                            st7701_lcd_init_cmd_t *ret_cmds, uint16_t max_cmds,
+                                            st7701_init_optimize_stats_t *ret_stats)
+{
+    ESP_RETURN_ON_FALSE((init_cmds || !init_cmds_size) && (ret_cmds || !init_cmds_size) && ret_stats, ESP_ERR_INVALID_ARG,
+                        TAG, "invalid arguments");
+    ESP_RETURN_ON_FALSE(max_cmds >= init_cmds_size, ESP_ERR_INVALID_SIZE, TAG, "output table too small");
+
+    int bank = -1; // unknown until the first bank selection
+    uint16_t num_cmds = 0;
+
+    memset(ret_stats, 0, sizeof(st7701_init_optimize_stats_t));
+    ret_stats->num_cmds_in = init_cmds_size;
+
+    // Drop selections of the bank that is selected already, moving their delay (if any) to the previous command
+    for (int i = 0; i < init_cmds_size; i++) {
+        st7701_lcd_init_cmd_t cmd = init_cmds[i];
+        if (cmd.cmd == ST7701_CMD_CND2BKxSEL) {
+            int new_bank = st7701_is_bank_select(&cmd) ? ((const uint8_t *)cmd.data)[4] : -1;
+            if (new_bank >= 0 && new_bank == bank && (num_cmds || !cmd.delay_ms)) {
+                if (num_cmds) {
+                    ret_cmds[num_cmds - 1].delay_ms += cmd.delay_ms;
+                }
+                ret_stats->bank_selects_dropped++;
+                continue;
+            }
+            bank = new_bank;
+        }
+        ret_cmds[num_cmds++] = cmd;
+    }
+
+    // Drop register writes that are overwritten later in the same run of back-to-back commands
+    uint16_t kept = 0;
+    for (int i = 0; i < num_cmds; i++) {
+        bool replaced = false;
+        if (st7701_is_mergeable(&ret_cmds[i])) {
+            for (int j = i + 1; j < num_cmds && !ret_cmds[j - 1].delay_ms && ret_cmds[j].cmd != ST7701_CMD_CND2BKxSEL; j++) {
+                if (ret_cmds[j].cmd == ret_cmds[i].cmd && st7701_is_mergeable(&ret_cmds[j])) {
+                    replaced = true;
+                    break;
+                }
+            }
+        }
+        if (replaced) {
+            ret_stats->writes_merged++;
+            continue;
+        }
+        ret_cmds[kept++] = ret_cmds[i];
+    }
+    ret_stats->num_cmds_out = kept;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_calc_timing(const st7701_timing_config_t *config, st7701_timing_t *ret_timing)
+{
+    ESP_RETURN_ON_FALSE(config && ret_timing && config->h_res && config->v_res && config->refresh_hz, ESP_ERR_INVALID_ARG,
+                        TAG, "invalid arguments");
+    ESP_RETURN_ON_FALSE(config->bits_per_pixel == 16 || config->bits_per_pixel == 18 || config->bits_per_pixel == 24,
+                        ESP_ERR_NOT_SUPPORTED, TAG, "unsupported pixel width");
+    ESP_RETURN_ON_FALSE(config->h_res <= ST7701_MAX_H_RES, ESP_ERR_NOT_SUPPORTED, TAG, "horizontal resolution too high");
+    ESP_RETURN_ON_FALSE(config->v_res <= ST7701_MAX_V_RES && !(config->v_res % ST7701_LINE_STEP), ESP_ERR_NOT_SUPPORTED,
+                        TAG, "vertical resolution must be a multiple of %d up to %d", ST7701_LINE_STEP, ST7701_MAX_V_RES);
+
+    st7701_timing_t *timing = ret_timing;
+    memset(timing, 0, sizeof(st7701_timing_t));
+    timing->h_res = config->h_res;
+    timing->v_res = config->v_res;
+    timing->bits_per_pixel = config->bits_per_pixel;
+    timing->lane_num = config->lane_num ? config->lane_num : 2;
+    timing->lane_bit_rate_mbps = config->lane_bit_rate_mbps;
+
+    // The panel only knows line lengths of 512 + 16 * RTNI pixel clock cycles, the front porch makes up the difference
+    timing->hsync_pulse_width = ST7701_HSYNC_PULSE_WIDTH;
+    timing->hsync_back_porch = ST7701_HSYNC_BACK_PORCH;
+    uint32_t h_total = config->h_res + ST7701_HSYNC_PULSE_WIDTH + ST7701_HSYNC_BACK_PORCH + ST7701_HSYNC_FRONT_PORCH_MIN;
+    uint32_t rtni = 0;
+    if (h_total > ST7701_LINE_PCLK_BASE) {
+        rtni = (h_total - ST7701_LINE_PCLK_BASE + ST7701_LINE_PCLK_STEP - 1) / ST7701_LINE_PCLK_STEP;
+    }
+    ESP_RETURN_ON_FALSE(rtni <= ST7701_RTNI_MAX, ESP_ERR_NOT_SUPPORTED, TAG, "line too long");
+    h_total = ST7701_LINE_PCLK_BASE + rtni * ST7701_LINE_PCLK_STEP;
+    timing->hsync_front_porch = h_total - config->h_res - ST7701_HSYNC_PULSE_WIDTH - ST7701_HSYNC_BACK_PORCH;
+
+    timing->vsync_pulse_width = ST7701_VSYNC_PULSE_WIDTH;
+    timing->vsync_back_porch = ST7701_VSYNC_BACK_PORCH;
+    timing->vsync_front_porch = ST7701_VSYNC_FRONT_PORCH;
+    uint32_t v_total = config->v_res + ST7701_VSYNC_PULSE_WIDTH + ST7701_VSYNC_BACK_PORCH + ST7701_VSYNC_FRONT_PORCH;
+
+    // refresh_rate = dpi_clock_freq_mhz * 1000000 / (h_total * v_total)
+    uint64_t frame_pclks = (uint64_t)h_total * v_total;
+    uint64_t pclk_hz = frame_pclks * config->refresh_hz;
+    timing->dpi_clock_freq_mhz = (uint32_t)((pclk_hz + 500000) / 1000000);
+    if (!timing->dpi_clock_freq_mhz) {
+        timing->dpi_clock_freq_mhz = 1;
+    }
+    timing->refresh_mhz = (uint32_t)((uint64_t)timing->dpi_clock_freq_mhz * 1000000000ULL / frame_pclks);
+
+    ESP_RETURN_ON_ERROR(esp_lcd_st7701_calc_lane_bit_rate(timing, 0, &timing->required_lane_bit_rate_mbps), TAG,
+                        "video stream too fast for the link");
+    if (!config->lane_bit_rate_mbps) {
+        ESP_RETURN_ON_ERROR(esp_lcd_st7701_calc_lane_bit_rate(timing, config->headroom_percent, &timing->lane_bit_rate_mbps),
+                            TAG, "video stream too fast for the link");
+    }
+    ESP_RETURN_ON_FALSE(timing->required_lane_bit_rate_mbps <= timing->lane_bit_rate_mbps, ESP_ERR_NOT_SUPPORTED, TAG,
+                        "video stream needs %"PRIu32" Mbps per lane, link has %"PRIu32, timing->required_lane_bit_rate_mbps,
+                        timing->lane_bit_rate_mbps);
+
+    timing->lneset[0] = config->v_res / ST7701_LINE_STEP - 1;
+    timing->lneset[1] = 0x00;
+    // The panel counts the back porch from the start of the sync pulse
+    timing->porctrl[0] = ST7701_VSYNC_PULSE_WIDTH + ST7701_VSYNC_BACK_PORCH;
+    timing->porctrl[1] = ST7701_VSYNC_FRONT_PORCH;
+    timing->invset[0] = ST7701_INVSET_INVERSION;
+    timing->invset[1] = rtni;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_calc_lane_bit_rate(const st7701_timing_t *timing, uint8_t headroom_percent,
+                                            uint32_t *ret_lane_bit_rate_mbps)
+{
+    ESP_RETURN_ON_FALSE(timing && ret_lane_bit_rate_mbps && timing->h_res && timing->v_res && timing->dpi_clock_freq_mhz,
+                        ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+
+    uint32_t lane_num = timing->lane_num ? timing->lane_num : 2;
+    uint64_t h_total = (uint64_t)timing->h_res + timing->hsync_pulse_width + timing->hsync_back_porch + timing->hsync_front_porch;
+    uint64_t v_total = (uint64_t)timing->v_res + timing->vsync_pulse_width + timing->vsync_back_porch + timing->vsync_front_porch;
+    // Every line carries its sync and blanking packets, the active ones also the pixels. RGB666 is sent loosely packed.
+    uint32_t wire_bpp = timing->bits_per_pixel == 16 ? 16 : 24;
+    uint64_t frame_bits = (uint64_t)timing->v_res * timing->h_res * wire_bpp + v_total * ST7701_DSI_LINE_OVERHEAD_BYTES * 8;
+    // bits per second = frame_bits * refresh_rate, with refresh_rate = dpi_clock_freq_mhz * 1000000 / (h_total * v_total)
+    uint64_t lane_bps = frame_bits * timing->dpi_clock_freq_mhz * 1000000ULL * (100 + headroom_percent);
+    uint64_t lane_divisor = h_total * v_total * lane_num * 100;
+    uint64_t lane_mbps = (lane_bps + lane_divisor * 1000000 - 1) / (lane_divisor * 1000000);
+
+    ESP_RETURN_ON_FALSE(lane_mbps <= ST7701_DSI_LANE_RATE_MAX, ESP_ERR_NOT_SUPPORTED, TAG,
+                        "video stream needs %"PRIu64" Mbps per lane", lane_mbps);
+    *ret_lane_bit_rate_mbps = lane_mbps < ST7701_DSI_LANE_RATE_MIN ? ST7701_DSI_LANE_RATE_MIN : (uint32_t)lane_mbps;
+
+    return ESP_OK;
+}
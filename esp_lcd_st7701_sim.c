@@ -0,0 +1,189 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "esp_check.h"
+#include "esp_lcd_st7701_sim.h"
+
+#define ST7701_CMD_SWRESET          (0x01)
+#define ST7701_CMD_SLPIN            (0x10)
+#define ST7701_CMD_SLPOUT           (0x11)
+#define ST7701_CMD_INVOFF           (0x20)
+#define ST7701_CMD_INVON            (0x21)
+#define ST7701_CMD_DISPOFF          (0x28)
+#define ST7701_CMD_DISPON           (0x29)
+#define ST7701_CMD_MADCTL           (0x36)
+#define ST7701_CMD_COLMOD           (0x3A)
+#define ST7701_CMD_SDIR             (0xC7)  // Source direction control, in BK0
+#define ST7701_CMD_CND2BKxSEL       (0xFF)  // Command2 BKx selection
+#define ST7701_BANK_REGULAR         (0x00)
+#define ST7701_BANK_CMD2_BK0        (0x10)
+#define ST7701_MADCTL_BGR_BIT       (1 << 3)
+#define ST7701_MADCTL_ML_BIT        (1 << 4)
+#define ST7701_SDIR_SS_BIT          (1 << 2)
+#define ST7701_COLMOD_RGB565        (0x50)
+#define ST7701_COLMOD_RGB666        (0x60)
+#define ST7701_COLMOD_MASK          (0x70)  // DPI pixel format, the low bits select the DBI format
+
+static const char *TAG = "ST7701";
+
+static void st7701_sim_reset(st7701_sim_t *sim)
+{
+    sim->bank = ST7701_BANK_REGULAR;
+    sim->madctl = 0;
+    sim->colmod = 0x70;
+    sim->sdir = 0;
+    sim->inverted = false;
+    sim->sleeping = true;
+    sim->display_on = false;
+}
+
+esp_err_t esp_lcd_st7701_sim_init(st7701_sim_t *sim, uint16_t width, uint16_t height)
+{
+    ESP_RETURN_ON_FALSE(sim && width && height, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+
+    sim->width = width;
+    sim->height = height;
+    st7701_sim_reset(sim);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_sim_tx_param(st7701_sim_t *sim, int cmd, const void *param, size_t param_size)
+{
+    ESP_RETURN_ON_FALSE(sim && (param || !param_size), ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    const uint8_t *data = (const uint8_t *)param;
+
+    if (cmd == ST7701_CMD_CND2BKxSEL) {
+        if (param_size == 5 && data[0] == 0x77 && data[1] == 0x01 && data[2] == 0x00 && data[3] == 0x00) {
+            sim->bank = data[4];
+        }
+        return ESP_OK;
+    }
+    // Command2 banks reuse the command codes of the regular one
+    if (sim->bank == ST7701_BANK_CMD2_BK0) {
+        if (cmd == ST7701_CMD_SDIR && param_size >= 1) {
+            sim->sdir = data[0];
+        }
+        return ESP_OK;
+    }
+    if (sim->bank != ST7701_BANK_REGULAR) {
+        return ESP_OK;
+    }
+
+    switch (cmd) {
+    case ST7701_CMD_SWRESET:
+        st7701_sim_reset(sim);
+        break;
+    case ST7701_CMD_SLPIN:
+    case ST7701_CMD_SLPOUT:
+        sim->sleeping = cmd == ST7701_CMD_SLPIN;
+        break;
+    case ST7701_CMD_INVOFF:
+    case ST7701_CMD_INVON:
+        sim->inverted = cmd == ST7701_CMD_INVON;
+        break;
+    case ST7701_CMD_DISPOFF:
+    case ST7701_CMD_DISPON:
+        sim->display_on = cmd == ST7701_CMD_DISPON;
+        break;
+    case ST7701_CMD_MADCTL:
+        if (param_size >= 1) {
+            sim->madctl = data[0];
+        }
+        break;
+    case ST7701_CMD_COLMOD:
+        if (param_size >= 1) {
+            sim->colmod = data[0];
+        }
+        break;
+    default:
+        break;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_sim_run_cmds(st7701_sim_t *sim, const st7701_lcd_init_cmd_t *cmds, size_t num_cmds)
+{
+    ESP_RETURN_ON_FALSE(sim && (cmds || !num_cmds), ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+
+    for (size_t i = 0; i < num_cmds; i++) {
+        ESP_RETURN_ON_ERROR(esp_lcd_st7701_sim_tx_param(sim, cmds[i].cmd, cmds[i].data, cmds[i].data_bytes), TAG,
+                            "send command %d failed", (int)i);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_sim_render(const st7701_sim_t *sim, const void *fb, st7701_color_format_t format, uint8_t *rgb)
+{
+    ESP_RETURN_ON_FALSE(sim && fb && rgb, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    ESP_RETURN_ON_FALSE(format == ST7701_COLOR_FORMAT_RGB565 || format == ST7701_COLOR_FORMAT_RGB888, ESP_ERR_NOT_SUPPORTED,
+                        TAG, "unsupported pixel format");
+    uint8_t colmod = sim->colmod & ST7701_COLMOD_MASK;
+    ESP_RETURN_ON_FALSE((format == ST7701_COLOR_FORMAT_RGB565) == (colmod == ST7701_COLMOD_RGB565), ESP_ERR_INVALID_STATE,
+                        TAG, "COLMOD 0x%02X doesn't match the frame buffer", sim->colmod);
+    size_t num_pixels = (size_t)sim->width * sim->height;
+    uint8_t bytes_per_pixel = esp_lcd_st7701_color_bytes(format);
+    // An 18-bit interface drops the low bits of every component
+    uint8_t depth_mask = colmod == ST7701_COLMOD_RGB666 ? 0xFC : 0xFF;
+    uint8_t invert_mask = sim->inverted ? 0xFF : 0x00;
+    bool flip_lines = sim->madctl & ST7701_MADCTL_ML_BIT;
+    bool flip_sources = sim->sdir & ST7701_SDIR_SS_BIT;
+    bool bgr = sim->madctl & ST7701_MADCTL_BGR_BIT;
+
+    if (sim->sleeping || !sim->display_on) {
+        memset(rgb, 0, num_pixels * 3);
+        return ESP_OK;
+    }
+
+    for (int y = 0; y < sim->height; y++) {
+        const uint8_t *line = (const uint8_t *)fb + (size_t)(flip_lines ? sim->height - 1 - y : y) * sim->width * bytes_per_pixel;
+        for (int x = 0; x < sim->width; x++, rgb += 3) {
+            const uint8_t *pixel = line + (size_t)(flip_sources ? sim->width - 1 - x : x) * bytes_per_pixel;
+            uint8_t r, g, b;
+            if (format == ST7701_COLOR_FORMAT_RGB565) {
+                // The panel widens the components by repeating their top bits
+                uint16_t value = pixel[0] | pixel[1] << 8;
+                uint8_t r5 = value >> 11;
+                uint8_t g6 = (value >> 5) & 0x3F;
+                uint8_t b5 = value & 0x1F;
+                r = r5 << 3 | r5 >> 2;
+                g = g6 << 2 | g6 >> 4;
+                b = b5 << 3 | b5 >> 2;
+            } else {
+                b = pixel[0];
+                g = pixel[1];
+                r = pixel[2];
+            }
+            // The panel latches the first component of the interface into its blue subpixels in BGR order
+            rgb[0] = ((bgr ? b : r) ^ invert_mask) & depth_mask;
+            rgb[1] = (g ^ invert_mask) & depth_mask;
+            rgb[2] = ((bgr ? r : b) ^ invert_mask) & depth_mask;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_st7701_sim_write_ppm(const st7701_sim_t *sim, const void *fb, st7701_color_format_t format, FILE *stream)
+{
+    ESP_RETURN_ON_FALSE(sim && fb && stream, ESP_ERR_INVALID_ARG, TAG, "invalid arguments");
+    esp_err_t ret = ESP_OK;
+    size_t image_size = (size_t)sim->width * sim->height * 3;
+    uint8_t *rgb = malloc(image_size);
+    ESP_RETURN_ON_FALSE(rgb, ESP_ERR_NO_MEM, TAG, "no mem for image");
+
+    ESP_GOTO_ON_ERROR(esp_lcd_st7701_sim_render(sim, fb, format, rgb), err, TAG, "render failed");
+    ESP_GOTO_ON_FALSE(fprintf(stream, "P6\n%d %d\n255\n", sim->width, sim->height) > 0 &&
+                      fwrite(rgb, 1, image_size, stream) == image_size, ESP_FAIL, err, TAG, "write image failed");
+
+err:
+    free(rgb);
+    return ret;
+}
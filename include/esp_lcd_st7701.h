@@ -8,27 +8,20 @@
 #pragma once
 
 #include <stdint.h>
+#include <stdio.h>
 #include "soc/soc_caps.h"
 
 #if SOC_MIPI_DSI_SUPPORTED
 #include "esp_lcd_panel_vendor.h"
 #include "esp_lcd_mipi_dsi.h"
+#include "esp_lcd_st7701_init_seq.h"
+#include "esp_lcd_st7701_fb.h"
+#include "esp_lcd_st7701_color.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/**
- * @brief LCD panel initialization commands.
- *
- */
-typedef struct {
-    int cmd;                /*<! The specific LCD command */
-    const void *data;       /*<! Buffer that holds the command specific data */
-    size_t data_bytes;      /*<! Size of `data` in memory, in bytes */
-    unsigned int delay_ms;  /*<! Delay in milliseconds after this command */
-} st7701_lcd_init_cmd_t;
-
 /**
  * @brief LCD panel vendor configuration.
  *
@@ -41,17 +34,55 @@ typedef struct {
                                                      *   Please refer to `vendor_specific_init_default` in source file.
                                                      */
     uint16_t init_cmds_size;                        /*<! Number of commands in above array */
+    const uint8_t *init_bytecode;                   /*!< Initialization commands in the compact bytecode format, see `ST7701_INIT_OP_CMD`.
+                                                     *   Only used if `init_cmds` is NULL. Must stay valid for the lifetime of the panel.
+                                                     *   Either is decoded into a table of about 16 bytes per command when the panel is
+                                                     *   created and optimized, see `esp_lcd_st7701_get_init_optimize_stats()`.
+                                                     */
+    size_t init_bytecode_size;                      /*!< Size of `init_bytecode` in bytes */
+    const st7701_timing_t *timing;                  /*!< Timing from `esp_lcd_st7701_calc_timing()`, optional. Its LNESET, PORCTRL and INVSET
+                                                     *   values replace the parameters of those commands in the initialization sequence.
+                                                     *   Without it, the line count in LNESET of the default sequence follows the vertical
+                                                     *   resolution of `dpi_config`, its other parameters and custom sequences are sent as they are.
+                                                     */
     struct {
         esp_lcd_dsi_bus_handle_t dsi_bus;               /*!< MIPI-DSI bus configuration */
+        int dsi_bus_id;                                 /*!< `esp_lcd_dsi_bus_config_t::bus_id` `dsi_bus` was created with, for the
+                                                         *   refresh rate scaling, see `esp_lcd_st7701_set_refresh_scaling()`
+                                                         */
         const esp_lcd_dpi_panel_config_t *dpi_config;   /*!< MIPI-DPI panel configuration */
         uint8_t  lane_num;                              /*!< Number of MIPI-DSI lanes, defaults to 2 if set to 0 */
+        uint32_t lane_bit_rate_mbps;                    /*!< Lane bit rate `dsi_bus` was created with, optional. If set, a rate too
+                                                         *   low for the video stream of `dpi_config` is rejected.
+                                                         */
+        uint8_t  num_fbs;                               /*!< Number of frame buffers, overrides `dpi_config->num_fbs` if not 0.
+                                                         *   2 or 3 enable tear-free buffer swapping, see `esp_lcd_st7701_present()`
+                                                         */
     } mipi_config;
+    struct {
+        unsigned int poll_ready: 1;                 /*!< After SLPOUT and DISPON, poll the power mode (RDDPM) and continue as soon as
+                                                     *   the panel reports ready instead of sleeping for the whole table delay, which
+                                                     *   becomes the timeout. The measured time-to-ready is logged.
+                                                     */
+        unsigned int warm_start: 1;                 /*!< On reset, read back the display ID, MADCTL, COLMOD and power mode. If the panel is
+                                                     *   awake and matches the configuration (e.g. after a soft restart), and the checksum
+                                                     *   of the initialization sequence, timing and driver registers matches the one stored
+                                                     *   by the last full initialization, skip the reset and replace the initialization
+                                                     *   sequence by DISPON. The checksum is kept in NVS (namespace "st7701"), which the
+                                                     *   application must have initialized with `nvs_flash_init()`.
+                                                     */
+    } flags;
 } st7701_vendor_config_t;
 
 /**
  * @brief Create LCD panel for model ST7701
  *
  * @note  Vendor specific initialization can be different between manufacturers, should consult the LCD supplier for initialization sequence code.
+ * @note  `esp_lcd_panel_mirror()`: `mirror_x` reverses the source outputs (SS bit of SDIR, 0xC7 in Command2 BK0) and
+ *        `mirror_y` the line order (ML bit of MADCTL). Older versions of the driver set MADCTL ML for `mirror_x`, which
+ *        flipped the picture vertically instead; applications that called `esp_lcd_panel_mirror(panel, true, false)`
+ *        to flip it vertically now need `esp_lcd_panel_mirror(panel, false, true)`. Once mirrored, the driver's SDIR
+ *        value replaces the one of the initialization sequence.
  *
  * @param[in]  io LCD panel IO handle
  * @param[in]  panel_dev_config General panel device configuration
@@ -64,9 +95,633 @@ typedef struct {
 esp_err_t esp_lcd_new_panel_st7701(const esp_lcd_panel_io_handle_t io, const esp_lcd_panel_dev_config_t *panel_dev_config,
                                     esp_lcd_panel_handle_t *ret_panel);
 
+/**
+ * @brief Callback invoked when an asynchronous panel initialization has finished
+ *
+ * @param[in] panel LCD panel handle
+ * @param[in] status ESP_OK if the panel is initialized, otherwise the error that aborted the sequence
+ * @param[in] user_ctx User data passed to `esp_lcd_st7701_init_async()`
+ */
+typedef void (*esp_lcd_st7701_init_done_cb_t)(esp_lcd_panel_handle_t panel, esp_err_t status, void *user_ctx);
+
+/**
+ * @brief Initialize the panel without blocking the calling task
+ *
+ * @note  This is the non-blocking counterpart of `esp_lcd_panel_init()`. The initialization commands are sent from the
+ *        esp_timer task and the delays between them are timer driven, so the caller can do other work meanwhile.
+ *        The panel must not be used (and not be deleted) until `done_cb` has been called.
+ * @note  `done_cb` runs in the esp_timer task context, it should return quickly, e.g. by setting an event group bit.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`, already reset
+ * @param[in] done_cb Callback invoked on completion, can be NULL
+ * @param[in] user_ctx User data passed to `done_cb`
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_INVALID_STATE if an initialization is already in progress
+ *      - ESP_OK                on success
+ *      - Otherwise             on fail
+ */
+esp_err_t esp_lcd_st7701_init_async(esp_lcd_panel_handle_t panel, esp_lcd_st7701_init_done_cb_t done_cb, void *user_ctx);
+
+/**
+ * @brief Fill the MIPI DSI bus and MIPI DPI panel configuration from a timing
+ *
+ * @note  Fields not covered by the timing are set as by `ST7701_PANEL_BUS_DSI_2CH_CONFIG()` and
+ *        `ST7701_1024_600_PANEL_60HZ_CONFIG()`.
+ *
+ * @param[in]  timing Timing from `esp_lcd_st7701_calc_timing()`
+ * @param[out] ret_bus_config Returned MIPI DSI bus configuration, can be NULL
+ * @param[out] ret_dpi_config Returned MIPI DPI panel configuration, can be NULL
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_timing_to_config(const st7701_timing_t *timing, esp_lcd_dsi_bus_config_t *ret_bus_config,
+                                          esp_lcd_dpi_panel_config_t *ret_dpi_config);
+
+/**
+ * @brief Get the minimum MIPI-DSI lane bit rate for a MIPI DPI panel configuration
+ *
+ * @note  Use it for `esp_lcd_dsi_bus_config_t::lane_bit_rate_mbps` instead of running the PHY at a fixed rate, see
+ *        `esp_lcd_st7701_calc_lane_bit_rate()`.
+ *
+ * @param[in]  dpi_config MIPI DPI panel configuration
+ * @param[in]  lane_num Number of MIPI-DSI data lanes, defaults to 2 if set to 0
+ * @param[in]  headroom_percent Margin on top of the minimum
+ * @param[out] ret_lane_bit_rate_mbps Returned lane bit rate
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_NOT_SUPPORTED if the video stream needs more than the D-PHY can carry
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_get_lane_bit_rate(const esp_lcd_dpi_panel_config_t *dpi_config, uint8_t lane_num,
+                                           uint8_t headroom_percent, uint32_t *ret_lane_bit_rate_mbps);
+
+/**
+ * @brief Fill in the lane bit rate of a MIPI DSI bus configuration, or check the one it has
+ *
+ * @note  Call it before `esp_lcd_new_dsi_bus()`. A `lane_bit_rate_mbps` of 0 is replaced by the minimum the video stream
+ *        of `dpi_config` needs over `num_data_lanes` lanes plus `headroom_percent`, see
+ *        `esp_lcd_st7701_get_lane_bit_rate()`. Any other rate, such as the 1000 Mbps of
+ *        `ST7701_PANEL_BUS_DSI_2CH_CONFIG()`, is only checked against that minimum.
+ *
+ * @param[inout] bus_config MIPI DSI bus configuration
+ * @param[in]    dpi_config MIPI DPI panel configuration
+ * @param[in]    headroom_percent Margin on top of the minimum, only used if `bus_config->lane_bit_rate_mbps` is 0
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid or the lane bit rate is too low for the video stream
+ *      - ESP_ERR_NOT_SUPPORTED if the video stream needs more than the D-PHY can carry
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_set_lane_bit_rate(esp_lcd_dsi_bus_config_t *bus_config, const esp_lcd_dpi_panel_config_t *dpi_config,
+                                           uint8_t headroom_percent);
+
+/**
+ * @brief Panel rotation, clockwise
+ *
+ */
+typedef enum {
+    ST7701_ROTATION_0 = 0,
+    ST7701_ROTATION_90,
+    ST7701_ROTATION_180,
+    ST7701_ROTATION_270,
+} st7701_rotation_t;
+
+/**
+ * @brief Rotate the panel
+ *
+ * @note  0° and 180° are done by the panel's scan direction and cost nothing per frame. 90° and 270° additionally swap
+ *        the axes, which makes `esp_lcd_panel_draw_bitmap()` transpose each bitmap with the PPA on its way into the
+ *        frame buffer, so the CPU doesn't touch the pixels. The call returns once the bitmap is in the frame buffer and
+ *        `on_color_trans_done` isn't invoked for those draws.
+ * @note  Swapped axes need the PPA, a single frame buffer and RGB565 or RGB888 pixels.
+ * @note  This is equivalent to calling `esp_lcd_panel_swap_xy()` and `esp_lcd_panel_mirror()`.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[in] rotation Rotation
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_INVALID_STATE if an asynchronous initialization is in progress
+ *      - ESP_ERR_NOT_SUPPORTED if the rotation needs swapped axes, which aren't supported by the configuration
+ *      - ESP_OK                on success
+ *      - Otherwise             on fail
+ */
+esp_err_t esp_lcd_st7701_set_rotation(esp_lcd_panel_handle_t panel, st7701_rotation_t rotation);
+
+#define ST7701_GAMMA_SIZE   (16)    /*!< Parameters of PVGAMCTRL (0xB0) and NVGAMCTRL (0xB1) */
+
+/**
+ * @brief Change the gamma curves while the panel is running
+ *
+ * @note  Selects Command2 BK0, writes PVGAMCTRL and NVGAMCTRL and selects the regular bank again: at most 4 short
+ *        transfers instead of a full initialization, so the picture isn't blanked. Curves the panel already holds are
+ *        not sent again.
+ * @note  `esp_lcd_panel_init()` restores the curves of the initialization sequence.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[in] positive Positive voltage gamma curve, `ST7701_GAMMA_SIZE` bytes as in PVGAMCTRL
+ * @param[in] negative Negative voltage gamma curve, `ST7701_GAMMA_SIZE` bytes as in NVGAMCTRL
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_INVALID_STATE if an asynchronous initialization is in progress
+ *      - ESP_OK                on success
+ *      - Otherwise             on fail
+ */
+esp_err_t esp_lcd_st7701_set_gamma(esp_lcd_panel_handle_t panel, const uint8_t positive[ST7701_GAMMA_SIZE],
+                                   const uint8_t negative[ST7701_GAMMA_SIZE]);
+
+/**
+ * @brief Switch the pixel format of the panel at runtime
+ *
+ * @note  Both the panel (COLMOD) and the MIPI DPI panel are switched. The MIPI DPI panel is created again, which
+ *        reallocates its frame buffers and replaces the handle: `*panel` is updated and the old handle must no longer
+ *        be used, whether the call succeeds or not. Frame buffer content is lost. MIPI DPI event callbacks have to be
+ *        registered again, unless they were registered with `esp_lcd_st7701_register_event_callbacks()`.
+ * @note  If the new MIPI DPI panel can't be created, the panel is switched back to the previous pixel format and
+ *        `*panel` is the handle of a MIPI DPI panel created again with it. Only if that fails as well, the panel has
+ *        been deleted and `*panel` is set to NULL.
+ *
+ * @param[inout] panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`, replaced by the new handle
+ * @param[in]    bits_per_pixel Pixel width: 16 (RGB565), 18 (RGB666) or 24 (RGB888)
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_INVALID_STATE if an asynchronous initialization is in progress
+ *      - ESP_ERR_NOT_SUPPORTED if the pixel width is not supported
+ *      - ESP_OK                on success
+ *      - Otherwise             on fail
+ */
+esp_err_t esp_lcd_st7701_set_pixel_format(esp_lcd_panel_handle_t *panel, int bits_per_pixel);
+
+/**
+ * @brief Register MIPI DPI panel event callbacks that survive the panel being replaced
+ *
+ * @note  Use this instead of `esp_lcd_dpi_panel_register_event_callbacks()` together with
+ *        `esp_lcd_st7701_set_pixel_format()`, which creates the MIPI DPI panel again and registers the callbacks on the
+ *        new one.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[in] cbs Callbacks
+ * @param[in] user_ctx User data passed to the callbacks
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ *      - Otherwise             on fail
+ */
+esp_err_t esp_lcd_st7701_register_event_callbacks(esp_lcd_panel_handle_t panel, const esp_lcd_dpi_panel_event_callbacks_t *cbs,
+                                                  void *user_ctx);
+
+/**
+ * @brief Statistics of the frame buffer swapping
+ *
+ */
+typedef struct {
+    uint32_t refreshes;             /*!< Refreshes of the panel (refresh done events) */
+    uint32_t frames_presented;      /*!< Frame buffers passed to `esp_lcd_st7701_present()` */
+    uint32_t frames_shown;          /*!< Presented frame buffers that have been scanned out */
+    uint32_t frames_dropped;        /*!< Presented frame buffers replaced by a newer one before being scanned out */
+    uint32_t frames_late;           /*!< Frames that replaced a frame scanned out more than once, i.e. came in after the
+                                     *   refresh they were due for. This includes the first frame after a static period.
+                                     */
+} st7701_swap_stats_t;
+
+/**
+ * @brief Get the frame buffer to render the next frame into
+ *
+ * @note  Needs 2 or 3 frame buffers, see `st7701_vendor_config_t::mipi_config.num_fbs`. The returned frame buffer is
+ *        neither being scanned out nor waiting to be, so rendering into it can't tear. Doesn't block.
+ * @note  With triple buffering a frame buffer is always available: presenting again before the pending frame was
+ *        scanned out replaces it (counted as dropped).
+ *
+ * @param[in]  panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[out] ret_fb Returned frame buffer
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_INVALID_STATE if the panel has less than 2 frame buffers
+ *      - ESP_ERR_NOT_FINISHED  if no frame buffer is free yet, try again after the next refresh
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_get_back_buffer(esp_lcd_panel_handle_t panel, void **ret_fb);
+
+/**
+ * @brief Present a rendered frame buffer, it is scanned out from the next refresh on
+ *
+ * @note  The swap happens on the refresh done event, so a frame is never shown partially.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[in] fb Frame buffer returned by `esp_lcd_st7701_get_back_buffer()`
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_INVALID_STATE if the frame buffer is the one being scanned out, or the panel has less than 2
+ *      - ESP_OK                on success
+ *      - Otherwise             on fail
+ */
+esp_err_t esp_lcd_st7701_present(esp_lcd_panel_handle_t panel, void *fb);
+
+/**
+ * @brief Get the statistics of the frame buffer swapping
+ *
+ * @param[in]  panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[out] ret_stats Returned statistics
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_get_swap_stats(esp_lcd_panel_handle_t panel, st7701_swap_stats_t *ret_stats);
+
+#define ST7701_FRAME_LATENCY_BUCKETS    (10)    /*!< Buckets of the latency histogram in `st7701_frame_stats_t` */
+
+/**
+ * @brief Frame pacing statistics, see `CONFIG_ST7701_FRAME_STATS`
+ *
+ * @note  A frame is everything drawn between two refreshes, through `esp_lcd_panel_draw_bitmap()`,
+ *        `esp_lcd_st7701_present()` or `esp_lcd_st7701_flush_dirty()`. Its latency runs from the first draw to the
+ *        refresh done event after which it is scanned out.
+ *
+ */
+typedef struct {
+    uint32_t refreshes;             /*!< Refreshes of the panel (refresh done events) */
+    uint32_t frames_submitted;      /*!< Frames drawn */
+    uint32_t frames_scanned_out;    /*!< Frames that reached the panel */
+    uint32_t deadlines_missed;      /*!< Frames scanned out more than `CONFIG_ST7701_FRAME_STATS_INTERVAL` refreshes
+                                     *   after the previous one. This includes the first frame after a static period.
+                                     */
+    uint32_t latency_max_us;        /*!< Longest submit to scan out latency */
+    uint64_t latency_sum_us;        /*!< Sum of the latencies of all scanned out frames */
+    uint32_t latency_hist[ST7701_FRAME_LATENCY_BUCKETS];    /*!< Latency histogram, bucket 0 counts latencies below
+                                                             *   1024 us, bucket i below 1024 << i us, the last one
+                                                             *   everything longer
+                                                             */
+} st7701_frame_stats_t;
+
+/**
+ * @brief Get the frame pacing statistics
+ *
+ * @param[in]  panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[out] ret_stats Returned statistics
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_NOT_SUPPORTED if `CONFIG_ST7701_FRAME_STATS` is disabled
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_get_frame_stats(esp_lcd_panel_handle_t panel, st7701_frame_stats_t *ret_stats);
+
+/**
+ * @brief Reset the frame pacing statistics, e.g. at the start of an animation
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_NOT_SUPPORTED if `CONFIG_ST7701_FRAME_STATS` is disabled
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_reset_frame_stats(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Dump the frame pacing statistics and the latency histogram as text
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[in] stream Stream to write to, e.g. stdout
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_NOT_SUPPORTED if `CONFIG_ST7701_FRAME_STATS` is disabled
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_dump_frame_stats(esp_lcd_panel_handle_t panel, FILE *stream);
+
+/**
+ * @brief Refresh rate scaling configuration
+ *
+ */
+typedef struct {
+    uint32_t idle_ms;               /*!< Time without draws before the refresh rate is lowered */
+    uint16_t low_refresh_hz;        /*!< Refresh rate while idle, e.g. 20 to 30 Hz */
+} st7701_refresh_scaling_config_t;
+
+/**
+ * @brief Statistics of the refresh rate scaling
+ *
+ */
+typedef struct {
+    bool low;                       /*!< The panel runs at the low refresh rate */
+    uint32_t switches;              /*!< Number of refresh rate changes */
+    uint64_t high_us;               /*!< Time spent at the configured refresh rate while scaling was enabled */
+    uint64_t low_us;                /*!< Time spent at the low refresh rate */
+} st7701_refresh_stats_t;
+
+/**
+ * @brief Enable or disable lowering the refresh rate while nothing is drawn
+ *
+ * @note  Scanning out the frame buffer less often frees PSRAM bandwidth for static content. The refresh rate is lowered
+ *        by lengthening the vertical front porch, of the MIPI DSI host and of the panel (PORCTRL) together. The pixel
+ *        clock, the frame buffers and the panel handle stay the same.
+ * @note  The front porch of the MIPI DSI host is at most 1023 lines, which bounds the low refresh rate. The panel's
+ *        PORCTRL is set to at most 255 lines.
+ * @note  The rate changes in `esp_lcd_st7701_refresh_scaling_update()`, never behind the application's back.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[in] config Configuration, NULL to disable and restore the configured refresh rate
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_INVALID_STATE if an asynchronous initialization is in progress
+ *      - ESP_OK                on success
+ *      - Otherwise             on fail
+ */
+esp_err_t esp_lcd_st7701_set_refresh_scaling(esp_lcd_panel_handle_t panel, const st7701_refresh_scaling_config_t *config);
+
+/**
+ * @brief Lower or restore the refresh rate, depending on draw activity
+ *
+ * @note  Call this regularly from the task that draws, e.g. once per iteration of the UI loop. It lowers the refresh
+ *        rate after `idle_ms` without `esp_lcd_panel_draw_bitmap()`, and restores it at the first call after a draw.
+ *        Switching takes three short commands to the panel and a few register writes.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success, also if scaling is disabled
+ *      - Otherwise             on fail
+ */
+esp_err_t esp_lcd_st7701_refresh_scaling_update(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Get the statistics of the refresh rate scaling
+ *
+ * @param[in]  panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[out] ret_stats Returned statistics
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_get_refresh_stats(esp_lcd_panel_handle_t panel, st7701_refresh_stats_t *ret_stats);
+
+/**
+ * @brief Copy the dirty parts of a full-screen draw buffer into the frame buffer
+ *
+ * @note  Instead of drawing whole regions with `esp_lcd_panel_draw_bitmap()`, render into `src`, track what changed
+ *        with `esp_lcd_st7701_dirty_add()` and copy only that. The copy is done by the PPA (DMA2D) if available,
+ *        otherwise by the CPU followed by a cache write-back.
+ * @note  `src` has the layout of the frame buffer: same pixel format, `h_res` pixels per line, no rotation applied.
+ *        RGB666 is not supported. The region is left as is, clear it after the flush.
+ *
+ * @param[in]  panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[in]  src Full-screen draw buffer
+ * @param[in]  region Dirty region, configured with the panel's resolution
+ * @param[out] ret_bytes Returned number of bytes copied, can be NULL
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_NOT_SUPPORTED if the pixel format is not supported
+ *      - ESP_OK                on success
+ *      - Otherwise             on fail
+ */
+esp_err_t esp_lcd_st7701_flush_dirty(esp_lcd_panel_handle_t panel, const void *src, const st7701_dirty_region_t *region,
+                                     size_t *ret_bytes);
+
+/**
+ * @brief Draw a bitmap in another pixel format than the frame buffer, converting it on the way
+ *
+ * @note  The pixels are converted straight into the frame buffer, without an intermediate bitmap. The PPA does the
+ *        conversion if available and no dithering is needed, the CPU otherwise, see `esp_lcd_st7701_convert_color()`.
+ * @note  On a 24 bpp frame buffer the bitmap is dithered to RGB666 if the panel is set to 18 bits (COLMOD 0x60).
+ * @note  Like `esp_lcd_st7701_flush_dirty()`, this writes the first frame buffer and doesn't apply swapped axes.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[in] x_start Start column, inclusive
+ * @param[in] y_start Start row, inclusive
+ * @param[in] x_end End column, exclusive
+ * @param[in] y_end End row, exclusive
+ * @param[in] color_data Bitmap, `x_end - x_start` pixels per line
+ * @param[in] format Pixel format of the bitmap, RGB888 or ARGB8888
+ * @param[in] dither Dithering to apply when reducing the color depth
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_INVALID_STATE if the axes are swapped
+ *      - ESP_ERR_NOT_SUPPORTED if the conversion is not supported
+ *      - ESP_OK                on success
+ *      - Otherwise             on fail
+ */
+esp_err_t esp_lcd_st7701_draw_bitmap_convert(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                             const void *color_data, st7701_color_format_t format, st7701_dither_t dither);
+
+/**
+ * @brief Fill a rectangle of the frame buffer with a solid color
+ *
+ * @note  Done by the PPA if available, by `esp_lcd_st7701_fb_fill()` otherwise. No bitmap is needed.
+ * @note  Like `esp_lcd_st7701_flush_dirty()`, this writes the first frame buffer and doesn't apply swapped axes.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[in] x_start Start column, inclusive
+ * @param[in] y_start Start row, inclusive
+ * @param[in] x_end End column, exclusive
+ * @param[in] y_end End row, exclusive
+ * @param[in] color Color as 0xRRGGBB
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_INVALID_STATE if the axes are swapped
+ *      - ESP_ERR_NOT_SUPPORTED if the pixel format is not supported
+ *      - ESP_OK                on success
+ *      - Otherwise             on fail
+ */
+esp_err_t esp_lcd_st7701_fill_rect(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end, uint32_t color);
+
+/**
+ * @brief Copy a rectangle of the frame buffer to another position, e.g. to scroll
+ *
+ * @note  Source and destination may overlap. Rectangles that don't are copied by the PPA if available, all others by
+ *        `esp_lcd_st7701_fb_copy()`.
+ * @note  Like `esp_lcd_st7701_flush_dirty()`, this works on the first frame buffer and doesn't apply swapped axes.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[in] x_start Start column of the source, inclusive
+ * @param[in] y_start Start row of the source, inclusive
+ * @param[in] x_end End column of the source, exclusive
+ * @param[in] y_end End row of the source, exclusive
+ * @param[in] x_dst Start column of the destination
+ * @param[in] y_dst Start row of the destination
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_INVALID_STATE if the axes are swapped
+ *      - ESP_ERR_NOT_SUPPORTED if the pixel format is not supported
+ *      - ESP_OK                on success
+ *      - Otherwise             on fail
+ */
+esp_err_t esp_lcd_st7701_copy_rect(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end, int x_dst,
+                                   int y_dst);
+
+/**
+ * @brief Blend an ARGB8888 bitmap over a rectangle of the frame buffer
+ *
+ * @note  Done by the PPA if available, by `esp_lcd_st7701_fb_blend()` otherwise. The PPA may round differently by one
+ *        step per component.
+ * @note  Like `esp_lcd_st7701_flush_dirty()`, this writes the first frame buffer and doesn't apply swapped axes.
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[in] x_start Start column, inclusive
+ * @param[in] y_start Start row, inclusive
+ * @param[in] x_end End column, exclusive
+ * @param[in] y_end End row, exclusive
+ * @param[in] argb Bitmap in ARGB8888, `x_end - x_start` pixels per line
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_INVALID_STATE if the axes are swapped
+ *      - ESP_ERR_NOT_SUPPORTED if the pixel format is not supported
+ *      - ESP_OK                on success
+ *      - Otherwise             on fail
+ */
+esp_err_t esp_lcd_st7701_blend_rect(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end, const void *argb);
+
+/**
+ * @brief Trace of one initialization command, see `CONFIG_ST7701_INIT_TRACE`
+ *
+ */
+typedef struct {
+    int64_t start_us;       /*!< Time the command was submitted, from `esp_timer_get_time()` */
+    uint32_t bus_us;        /*!< Time spent sending the command */
+    uint32_t sleep_us;      /*!< Time from the end of the command until the next one was submitted */
+    uint8_t cmd;            /*!< Command */
+    uint8_t data_bytes;     /*!< Number of parameters */
+    esp_err_t ret;          /*!< Result of sending the command */
+} st7701_init_trace_entry_t;
+
+/**
+ * @brief Get the trace of the last initialization, oldest command first
+ *
+ * @param[in]  panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[out] entries Returned trace entries
+ * @param[in]  max_entries Number of entries `entries` can hold
+ * @param[out] ret_num_entries Returned number of entries written
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_NOT_SUPPORTED if `CONFIG_ST7701_INIT_TRACE` is disabled
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_get_init_trace(esp_lcd_panel_handle_t panel, st7701_init_trace_entry_t *entries, size_t max_entries,
+                                        size_t *ret_num_entries);
+
+/**
+ * @brief Dump the trace of the last initialization as Chrome trace event JSON (chrome://tracing, Perfetto)
+ *
+ * @param[in] panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[in] stream Stream to write to, e.g. stdout or a file
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_NOT_SUPPORTED if `CONFIG_ST7701_INIT_TRACE` is disabled
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_dump_init_trace(esp_lcd_panel_handle_t panel, FILE *stream);
+
+/**
+ * @brief Statistics of the shadow register cache
+ *
+ */
+typedef struct {
+    uint32_t writes_sent;   /*!< Number of commands sent to the panel */
+    uint32_t writes_elided; /*!< Number of commands not sent because the panel was already in the requested state */
+} st7701_shadow_stats_t;
+
+/**
+ * @brief Get the statistics of the shadow register cache
+ *
+ * @note  The driver keeps a copy of MADCTL, COLMOD, the inversion state, the selected Command2 bank and the gamma
+ *        registers as last written. Requests like `esp_lcd_panel_mirror()` that would not change them return
+ *        without touching the bus.
+ *
+ * @param[in]  panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[out] ret_stats Returned statistics
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_get_shadow_stats(esp_lcd_panel_handle_t panel, st7701_shadow_stats_t *ret_stats);
+
+/**
+ * @brief Get how much `esp_lcd_st7701_optimize_init_cmds()` shortened the initialization sequence of a panel
+ *
+ * @note  The panel runs its sequence (`init_cmds`, `init_bytecode` or the default one) through the optimizer when it is
+ *        created. `num_cmds_out` is the number of DCS packets the vendor sequence takes, before the registers managed
+ *        by the driver and the shadow registers are accounted for.
+ *
+ * @param[in]  panel LCD panel handle returned by `esp_lcd_new_panel_st7701()`
+ * @param[out] ret_stats Returned statistics
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_get_init_optimize_stats(esp_lcd_panel_handle_t panel, st7701_init_optimize_stats_t *ret_stats);
+
+/**
+ * @brief Get the initialization commands used when `st7701_vendor_config_t::init_cmds` is NULL
+ *
+ * @note  Combine with `esp_lcd_st7701_get_init_budget()` to budget the boot time of the default panel.
+ *
+ * @param[out] init_cmds Returned command table
+ * @param[out] init_cmds_size Returned number of commands
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_get_default_init_cmds(const st7701_lcd_init_cmd_t **init_cmds, uint16_t *init_cmds_size);
+
+/**
+ * @brief Initialization image loaded from a partition or file
+ *
+ */
+typedef struct {
+    const uint8_t *bytecode;    /*!< Validated bytecode, to be passed to `st7701_vendor_config_t::init_bytecode` */
+    size_t bytecode_size;       /*!< Size of `bytecode` in bytes, to be passed to `st7701_vendor_config_t::init_bytecode_size` */
+    uint32_t mmap_handle;       /*!< Partition mapping that holds the image, for internal use */
+    void *buffer;               /*!< Buffer that holds the image read from a file, for internal use */
+    struct {
+        unsigned int mapped: 1; /*!< `mmap_handle` is valid, for internal use */
+    } flags;
+} st7701_init_image_t;
+
+/**
+ * @brief Load an initialization image from a data partition
+ *
+ * @note  The image is memory-mapped, not copied. It must not be released while a panel uses the bytecode.
+ *
+ * @param[in]  label Label of the data partition that holds the image
+ * @param[out] ret_image Returned image
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_NOT_FOUND     if the partition doesn't exist or doesn't hold an image
+ *      - ESP_OK                on success
+ *      - Otherwise             on fail, see `esp_lcd_st7701_init_image_parse()`
+ */
+esp_err_t esp_lcd_st7701_init_image_load_partition(const char *label, st7701_init_image_t *ret_image);
+
+/**
+ * @brief Load an initialization image from a file on a mounted VFS
+ *
+ * @note  The image must not be released while a panel uses the bytecode.
+ *
+ * @param[in]  path Path of the file that holds the image
+ * @param[out] ret_image Returned image
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_NOT_FOUND     if the file can't be opened or doesn't hold an image
+ *      - ESP_ERR_NO_MEM        if out of memory
+ *      - ESP_OK                on success
+ *      - Otherwise             on fail, see `esp_lcd_st7701_init_image_parse()`
+ */
+esp_err_t esp_lcd_st7701_init_image_load_file(const char *path, st7701_init_image_t *ret_image);
+
+/**
+ * @brief Release an initialization image
+ *
+ * @param[in] image Image returned by `esp_lcd_st7701_init_image_load_partition()` or `esp_lcd_st7701_init_image_load_file()`
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_init_image_release(st7701_init_image_t *image);
+
 /**
  * @brief MIPI DSI bus configuration structure
  *
+ * @note  Runs the PHY at a fixed 1000 Mbps per lane. To run it at the lowest rate the video stream needs instead, set
+ *        `lane_bit_rate_mbps` to 0 and call `esp_lcd_st7701_set_lane_bit_rate()`, or fill the configuration with
+ *        `esp_lcd_st7701_timing_to_config()`.
  */
 #define ST7701_PANEL_BUS_DSI_2CH_CONFIG()                \
     {                                                     \
@@ -90,6 +745,10 @@ esp_err_t esp_lcd_new_panel_st7701(const esp_lcd_panel_io_handle_t io, const esp
 /**
  * @brief MIPI DPI configuration structure
  *
+ * @note  1024 pixels per line are more than the `ST7701_MAX_H_RES` sources of the ST7701. The driver accepts this
+ *        configuration with a warning and sets the line count in LNESET of the default sequence to its 600 lines. For a
+ *        panel within the ST7701's limits, get the configuration from `esp_lcd_st7701_calc_timing()` and
+ *        `esp_lcd_st7701_timing_to_config()` instead.
  * @note  refresh_rate = (dpi_clock_freq_mhz * 1000000) / (h_res + hsync_pulse_width + hsync_back_porch + hsync_front_porch)
  *                                                      / (v_res + vsync_pulse_width + vsync_back_porch + vsync_front_porch)
  *
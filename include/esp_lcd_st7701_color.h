@@ -0,0 +1,82 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Pixel formats, in the memory layout of the MIPI DPI frame buffers and the PPA
+ *
+ */
+typedef enum {
+    ST7701_COLOR_FORMAT_RGB565,     /*!< 2 bytes per pixel, little endian 16-bit word with red in the top 5 bits */
+    ST7701_COLOR_FORMAT_RGB666,     /*!< 3 bytes per pixel like RGB888 with the low 2 bits of every component cleared, for
+                                     *   24 bpp frame buffers feeding a panel set to 18 bits (COLMOD 0x60)
+                                     */
+    ST7701_COLOR_FORMAT_RGB888,     /*!< 3 bytes per pixel: blue, green, red */
+    ST7701_COLOR_FORMAT_ARGB8888,   /*!< 4 bytes per pixel: blue, green, red, alpha */
+} st7701_color_format_t;
+
+/**
+ * @brief Dithering applied when reducing the color depth
+ *
+ */
+typedef enum {
+    ST7701_DITHER_NONE,             /*!< Truncate, fastest but shows banding in gradients */
+    ST7701_DITHER_ORDERED,          /*!< 4x4 Bayer matrix, the pattern is fixed to the screen so it doesn't crawl */
+} st7701_dither_t;
+
+/**
+ * @brief Color conversion configuration
+ *
+ */
+typedef struct {
+    st7701_color_format_t src_format;   /*!< Source format, RGB888 or ARGB8888. Alpha is ignored. */
+    st7701_color_format_t dst_format;   /*!< Destination format, RGB565, RGB666 or RGB888 */
+    st7701_dither_t dither;             /*!< Dithering, no effect on RGB888 destinations */
+    uint16_t width;                     /*!< Width of the block to convert */
+    uint16_t height;                    /*!< Height of the block to convert */
+    size_t src_stride;                  /*!< Bytes from one source line to the next, 0 if the lines are contiguous */
+    size_t dst_stride;                  /*!< Bytes from one destination line to the next, 0 if the lines are contiguous */
+    uint16_t x;                         /*!< Screen column of the block, aligns the dither pattern of adjacent blocks */
+    uint16_t y;                         /*!< Screen row of the block */
+} st7701_color_conv_config_t;
+
+/**
+ * @brief Get the bytes per pixel of a pixel format
+ *
+ * @param[in] format Pixel format
+ * @return Bytes per pixel
+ */
+uint8_t esp_lcd_st7701_color_bytes(st7701_color_format_t format);
+
+/**
+ * @brief Convert a block of pixels on the CPU
+ *
+ * @note  Reference for the conversion done by `esp_lcd_st7701_draw_bitmap_convert()`, which uses the PPA where it can.
+ *        The PPA truncates, so without dithering both give identical pixels.
+ * @note  This function has no dependency on the LCD peripheral and can be used on the host.
+ *
+ * @param[in]  config Conversion configuration
+ * @param[in]  src Source pixels
+ * @param[out] dst Destination pixels
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_NOT_SUPPORTED if the conversion is not supported
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_convert_color(const st7701_color_conv_config_t *config, const void *src, void *dst);
+
+#ifdef __cplusplus
+}
+#endif
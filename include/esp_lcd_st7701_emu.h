@@ -0,0 +1,155 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_lcd_st7701_init_seq.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ST7701_EMU_VIOLATIONS_MAX   (16)    /*!< Violations kept by `st7701_emu_t`, later ones are only counted */
+#define ST7701_EMU_PARAM_MAX        (16)    /*!< Longest register payload */
+#define ST7701_EMU_BANKS            (5)     /*!< Regular bank and Command2 BK0 to BK3 */
+
+/**
+ * @brief Protocol violations found by the register file emulator
+ *
+ */
+typedef enum {
+    ST7701_EMU_UNKNOWN_REG,         /*!< The register doesn't exist in the selected bank */
+    ST7701_EMU_PARAM_LEN,           /*!< Wrong number of parameters for the register */
+    ST7701_EMU_BAD_BANK_SELECT,     /*!< Malformed Command2 bank selection, or a bank that doesn't exist */
+    ST7701_EMU_TOO_EARLY,           /*!< Sent before the settle time of an earlier command elapsed */
+} st7701_emu_violation_type_t;
+
+/**
+ * @brief Protocol violation
+ *
+ */
+typedef struct {
+    st7701_emu_violation_type_t type;
+    uint32_t index;                 /*!< Position of the command in the stream, from 0 */
+    int cmd;                        /*!< Command */
+    uint8_t bank;                   /*!< Selected bank, 0x00 for the regular one or 0x10 to 0x13 */
+    int64_t time_us;                /*!< Time the command was sent */
+    uint32_t wait_us;               /*!< For `ST7701_EMU_TOO_EARLY`: how much longer it should have waited */
+} st7701_emu_violation_t;
+
+/**
+ * @brief Register description, for registers the built-in map doesn't know
+ *
+ */
+typedef struct {
+    uint8_t bank;                   /*!< Bank, 0x00 for the regular one or 0x10 to 0x13 */
+    uint8_t cmd;                    /*!< Command */
+    uint8_t min_params;             /*!< Fewest parameters accepted */
+    uint8_t max_params;             /*!< Most parameters accepted, at most `ST7701_EMU_PARAM_MAX` */
+} st7701_emu_reg_t;
+
+/**
+ * @brief Register file emulator configuration, 0 selects the datasheet timing
+ *
+ */
+typedef struct {
+    uint32_t swreset_wait_us;       /*!< From SWRESET to the next command, 5 ms */
+    uint32_t swreset_slpout_us;     /*!< From SWRESET to SLPOUT, 120 ms */
+    uint32_t sleep_wait_us;         /*!< From SLPOUT or SLPIN to the next command, 5 ms */
+    uint32_t sleep_toggle_us;       /*!< From SLPOUT to SLPIN and from SLPIN to SLPOUT, 120 ms */
+    const st7701_emu_reg_t *extra_regs;     /*!< Vendor registers to accept in addition to the built-in map */
+    size_t num_extra_regs;                  /*!< Number of entries in `extra_regs` */
+} st7701_emu_config_t;
+
+/**
+ * @brief Register file emulator: bank selection, sleep and display state and the last value of every register
+ *
+ * @note  About 20 KB, meant for host tests. Declare it static or allocate it.
+ * @note  Host only: `esp_lcd_st7701_emu.c` is built by the host tests in `test/host`, not by the component.
+ */
+typedef struct {
+    st7701_emu_config_t config;
+    uint8_t bank;                   /*!< Selected bank */
+    bool sleeping;                  /*!< In sleep mode, i.e. after reset or SLPIN */
+    bool display_on;                /*!< DISPON was sent after the last DISPOFF */
+    int64_t last_us;                /*!< Time of the last command */
+    int64_t next_us;                /*!< Earliest time for the next command */
+    int64_t slpout_us;              /*!< Earliest time for SLPOUT */
+    int64_t slpin_us;               /*!< Earliest time for SLPIN */
+    uint32_t num_cmds;              /*!< Commands received */
+    uint32_t num_violations;        /*!< Violations found, `violations` holds the first ones */
+    st7701_emu_violation_t violations[ST7701_EMU_VIOLATIONS_MAX];
+    uint8_t reg_len[ST7701_EMU_BANKS][256];
+    uint8_t reg_val[ST7701_EMU_BANKS][256][ST7701_EMU_PARAM_MAX];
+} st7701_emu_t;
+
+/**
+ * @brief Initialize a register file emulator in the state after a hardware reset, at time 0
+ *
+ * @note  As after SWRESET, SLPOUT is accepted from `swreset_slpout_us` on.
+ *
+ * @param[out] emu Emulator
+ * @param[in]  config Configuration, NULL for the defaults
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_emu_init(st7701_emu_t *emu, const st7701_emu_config_t *config);
+
+/**
+ * @brief Send one command to the emulator
+ *
+ * @note  Takes the arguments of `esp_lcd_panel_io_tx_param()` plus a timestamp, so a host side `esp_lcd_panel_io_t`
+ *        can forward the driver's traffic with `esp_timer_get_time()`.
+ * @note  Violations are recorded, not returned: the command is applied as far as the panel would.
+ *
+ * @param[inout] emu Emulator
+ * @param[in]    time_us Time the command is sent, not before the previous one
+ * @param[in]    cmd Command
+ * @param[in]    param Parameters, can be NULL if `param_size` is 0
+ * @param[in]    param_size Number of parameters
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_emu_tx_param(st7701_emu_t *emu, int64_t time_us, int cmd, const void *param, size_t param_size);
+
+/**
+ * @brief Send an initialization command table to the emulator, as `panel_st7701_send_init_cmds()` would
+ *
+ * @note  Starts at the time of the last command, every command is sent when the delay of the previous one elapsed.
+ *        Bus time is not modeled.
+ *
+ * @param[inout] emu Emulator
+ * @param[in]    cmds Initialization commands
+ * @param[in]    num_cmds Number of commands
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_emu_run_cmds(st7701_emu_t *emu, const st7701_lcd_init_cmd_t *cmds, size_t num_cmds);
+
+/**
+ * @brief Get the last value written to a register
+ *
+ * @param[in]  emu Emulator
+ * @param[in]  bank Bank, 0x00 for the regular one or 0x10 to 0x13
+ * @param[in]  cmd Command
+ * @param[out] ret_param Returned parameters, `ST7701_EMU_PARAM_MAX` bytes
+ * @param[out] ret_size Returned number of parameters, 0 if the register hasn't been written since the last reset
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_emu_get_reg(const st7701_emu_t *emu, uint8_t bank, uint8_t cmd, uint8_t *ret_param, size_t *ret_size);
+
+#ifdef __cplusplus
+}
+#endif
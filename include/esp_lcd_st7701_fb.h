@@ -0,0 +1,194 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_lcd_st7701_color.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Maximum number of rectangles a dirty region keeps apart
+ *
+ */
+#define ST7701_DIRTY_RECTS_MAX (16)
+
+/**
+ * @brief Rectangle, the end coordinates are exclusive as in `esp_lcd_panel_draw_bitmap()`
+ *
+ */
+typedef struct {
+    uint16_t x_start;
+    uint16_t y_start;
+    uint16_t x_end;
+    uint16_t y_end;
+} st7701_rect_t;
+
+/**
+ * @brief Dirty region configuration
+ *
+ */
+typedef struct {
+    uint16_t width;                 /*!< Width of the frame buffer, rectangles are clipped to it */
+    uint16_t height;                /*!< Height of the frame buffer */
+    uint8_t max_rects;              /*!< Collapse into the bounding box beyond this many rectangles, at most and defaults to
+                                     *   `ST7701_DIRTY_RECTS_MAX` if set to 0
+                                     */
+    uint8_t bbox_percent;           /*!< Collapse into the bounding box once the rectangles cover this share of it, as one
+                                     *   large copy beats many small ones. 0 to disable.
+                                     */
+} st7701_dirty_config_t;
+
+/**
+ * @brief Dirty region: the parts of a frame buffer that changed, as non-overlapping rectangles
+ *
+ */
+typedef struct {
+    st7701_dirty_config_t config;
+    st7701_rect_t rects[ST7701_DIRTY_RECTS_MAX];
+    uint8_t num_rects;
+} st7701_dirty_region_t;
+
+/**
+ * @brief Initialize an empty dirty region
+ *
+ * @param[out] region Dirty region
+ * @param[in]  config Configuration
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_dirty_init(st7701_dirty_region_t *region, const st7701_dirty_config_t *config);
+
+/**
+ * @brief Add a changed rectangle to a dirty region
+ *
+ * @note  The rectangle is clipped to the frame buffer, then merged with every rectangle it overlaps or that it extends
+ *        without adding area, until the rectangles are disjoint. Too many rectangles, or rectangles covering most of
+ *        their bounding box (see `st7701_dirty_config_t`), collapse into the bounding box.
+ * @note  This function has no dependency on the LCD peripheral and can be used on the host.
+ *
+ * @param[inout] region Dirty region
+ * @param[in]    x_start Start column, inclusive
+ * @param[in]    y_start Start row, inclusive
+ * @param[in]    x_end End column, exclusive
+ * @param[in]    y_end End row, exclusive
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success, also if the rectangle is empty or outside the frame buffer
+ */
+esp_err_t esp_lcd_st7701_dirty_add(st7701_dirty_region_t *region, int x_start, int y_start, int x_end, int y_end);
+
+/**
+ * @brief Empty a dirty region, e.g. after it has been flushed
+ *
+ * @param[inout] region Dirty region
+ */
+void esp_lcd_st7701_dirty_clear(st7701_dirty_region_t *region);
+
+/**
+ * @brief Get the number of pixels in a dirty region
+ *
+ * @param[in] region Dirty region
+ * @return Number of pixels
+ */
+uint32_t esp_lcd_st7701_dirty_area(const st7701_dirty_region_t *region);
+
+/**
+ * @brief Copy the dirty region from one frame buffer to another of the same layout, on the CPU
+ *
+ * @note  Reference implementation of the copy done by `esp_lcd_st7701_flush_dirty()`, usable on the host to measure the
+ *        bytes copied per frame for a workload.
+ *
+ * @param[out] dst Destination frame buffer
+ * @param[in]  src Source frame buffer
+ * @param[in]  bytes_per_pixel Bytes per pixel of both frame buffers
+ * @param[in]  region Dirty region, its `config.width` is the line length of both frame buffers
+ * @return Number of bytes copied
+ */
+size_t esp_lcd_st7701_dirty_copy(void *dst, const void *src, uint8_t bytes_per_pixel, const st7701_dirty_region_t *region);
+
+/**
+ * @brief Frame buffer description for the 2D operations
+ *
+ */
+typedef struct {
+    void *buffer;                   /*!< Pixels, `width` per line */
+    uint16_t width;                 /*!< Width in pixels */
+    uint16_t height;                /*!< Height in pixels */
+    st7701_color_format_t format;   /*!< Pixel format, RGB565 or RGB888 */
+} st7701_fb_t;
+
+/**
+ * @brief Fill a rectangle with a solid color, on the CPU
+ *
+ * @note  Reference for `esp_lcd_st7701_fill_rect()`: the color is truncated to the frame buffer format. The first line
+ *        is filled pixel by pixel, the others are copied from it.
+ * @note  This function has no dependency on the LCD peripheral and can be used on the host.
+ *
+ * @param[in] fb Frame buffer
+ * @param[in] x_start Start column, inclusive
+ * @param[in] y_start Start row, inclusive
+ * @param[in] x_end End column, exclusive
+ * @param[in] y_end End row, exclusive
+ * @param[in] color Color as 0xRRGGBB, any alpha in the top byte is ignored
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid or the rectangle is not inside the frame buffer
+ *      - ESP_ERR_NOT_SUPPORTED if the pixel format is not supported
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_fb_fill(const st7701_fb_t *fb, int x_start, int y_start, int x_end, int y_end, uint32_t color);
+
+/**
+ * @brief Copy a rectangle within a frame buffer, on the CPU
+ *
+ * @note  Reference for `esp_lcd_st7701_copy_rect()`. Source and destination may overlap, e.g. for scrolling: the lines
+ *        are copied in the order that reads every line before overwriting it.
+ * @note  This function has no dependency on the LCD peripheral and can be used on the host.
+ *
+ * @param[in] fb Frame buffer
+ * @param[in] x_start Start column of the source, inclusive
+ * @param[in] y_start Start row of the source, inclusive
+ * @param[in] x_end End column of the source, exclusive
+ * @param[in] y_end End row of the source, exclusive
+ * @param[in] x_dst Start column of the destination
+ * @param[in] y_dst Start row of the destination
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid or a rectangle is not inside the frame buffer
+ *      - ESP_ERR_NOT_SUPPORTED if the pixel format is not supported
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_fb_copy(const st7701_fb_t *fb, int x_start, int y_start, int x_end, int y_end, int x_dst, int y_dst);
+
+/**
+ * @brief Blend an ARGB8888 bitmap over a rectangle of a frame buffer, on the CPU
+ *
+ * @note  Reference for `esp_lcd_st7701_blend_rect()`. Every component becomes
+ *        `(fg * a + bg * (255 - a) + 127) / 255`, RGB565 components are expanded to 8 bits first by repeating their top
+ *        bits, and the result is truncated to the frame buffer format.
+ * @note  This function has no dependency on the LCD peripheral and can be used on the host.
+ *
+ * @param[in] fb Frame buffer
+ * @param[in] x_start Start column, inclusive
+ * @param[in] y_start Start row, inclusive
+ * @param[in] x_end End column, exclusive
+ * @param[in] y_end End row, exclusive
+ * @param[in] argb Bitmap in ARGB8888, `x_end - x_start` pixels per line
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid or the rectangle is not inside the frame buffer
+ *      - ESP_ERR_NOT_SUPPORTED if the pixel format is not supported
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_fb_blend(const st7701_fb_t *fb, int x_start, int y_start, int x_end, int y_end, const void *argb);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,373 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ * SPDX-FileCopyrightText: 2023 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief LCD panel initialization commands.
+ *
+ */
+typedef struct {
+    int cmd;                /*<! The specific LCD command */
+    const void *data;       /*<! Buffer that holds the command specific data */
+    size_t data_bytes;      /*<! Size of `data` in memory, in bytes */
+    unsigned int delay_ms;  /*<! Delay in milliseconds after this command */
+} st7701_lcd_init_cmd_t;
+
+/**
+ * @brief Build a `st7701_lcd_init_cmd_t` entry, `data_bytes` is derived from the parameters
+ *
+ * @note  The parameters are placed in a `const` compound literal, so they end up in flash instead of RAM.
+ *
+ *        static const st7701_lcd_init_cmd_t init_cmds[] = {
+ *            ST7701_INIT_CMD(0xC0, 0, 0x63, 0x00),
+ *            ST7701_INIT_CMD_NO_PARAM(LCD_CMD_SLPOUT, 120),
+ *        };
+ */
+#define ST7701_INIT_CMD(cmd, delay_ms, ...) \
+    { (cmd), (const uint8_t []){ __VA_ARGS__ }, sizeof((const uint8_t []){ __VA_ARGS__ }), (delay_ms) }
+
+/**
+ * @brief Build a `st7701_lcd_init_cmd_t` entry with an explicit `data_bytes`, which is checked at compile time
+ *
+ * @note  Useful when converting existing tables: a length that doesn't match the parameters fails the build.
+ */
+#define ST7701_INIT_CMD_N(cmd, data_bytes, delay_ms, ...) \
+    { (cmd), (const uint8_t []){ __VA_ARGS__ }, ST7701_INIT_CMD_CHECKED_LEN(data_bytes, __VA_ARGS__), (delay_ms) }
+
+/**
+ * @brief Build a `st7701_lcd_init_cmd_t` entry for a command without parameters
+ */
+#define ST7701_INIT_CMD_NO_PARAM(cmd, delay_ms) \
+    { (cmd), NULL, 0, (delay_ms) }
+
+/**
+ * @brief Number of commands in an initialization command table, for `st7701_vendor_config_t::init_cmds_size`
+ */
+#define ST7701_INIT_CMDS_SIZE(init_cmds) (sizeof(init_cmds) / sizeof(st7701_lcd_init_cmd_t))
+
+// Evaluates to `data_bytes`, the struct only exists to host the static assertion inside an expression
+#define ST7701_INIT_CMD_CHECKED_LEN(data_bytes, ...) \
+    (sizeof(struct { _Static_assert(sizeof((const uint8_t []){ __VA_ARGS__ }) == (data_bytes), \
+                                    "data_bytes does not match the number of parameters"); int unused; }) * 0 + (data_bytes))
+
+/**
+ * @brief Boot-time budget of an initialization command table.
+ *
+ */
+typedef struct {
+    uint32_t num_packets;   /*!< Number of DCS packets sent */
+    uint32_t payload_bytes; /*!< Command and parameter bytes */
+    uint32_t wire_bytes;    /*!< Bytes on the wire, including DSI packet headers and checksums */
+    uint32_t delay_ms;      /*!< Sum of the programmed delays */
+    uint32_t transfer_us;   /*!< Estimated LP-mode (escape mode) transfer time of all packets */
+    uint32_t total_us;      /*!< `transfer_us` plus `delay_ms`, i.e. the time spent inside the table */
+} st7701_init_budget_t;
+
+/**
+ * @brief Compute the boot-time budget of an initialization command table.
+ *
+ * @note  Commands are sent in LP mode on data lane 0 only, so the estimate depends on the lane bit rate
+ *        (which sets the escape clock) but not on the number of lanes. Software overhead per command
+ *        and the hardware reset of the panel (30 ms) are not included.
+ * @note  This function has no dependency on the LCD peripheral and can be used on the host.
+ *
+ * @param[in]  init_cmds Initialization command table
+ * @param[in]  init_cmds_size Number of commands in `init_cmds`
+ * @param[in]  lane_bit_rate_mbps Configured MIPI-DSI lane bit rate
+ * @param[out] ret_budget Returned budget
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_get_init_budget(const st7701_lcd_init_cmd_t *init_cmds, uint16_t init_cmds_size,
+                                         uint32_t lane_bit_rate_mbps, st7701_init_budget_t *ret_budget);
+
+/**
+ * @brief Opcodes of the compact initialization bytecode
+ *
+ * A bytecode sequence is a series of instructions, each starting with one of these opcodes:
+ *   - `ST7701_INIT_OP_CMD`:   cmd, data_bytes, data[data_bytes]
+ *   - `ST7701_INIT_OP_BANK`:  bank, sends the 0xFF (Command2 BKx selection) command with parameters 0x77 0x01 0x00 0x00 bank
+ *   - `ST7701_INIT_OP_SLEEP`: delay_ms as unsigned LEB128 varint, delay after the previous command
+ *   - `ST7701_INIT_OP_END`:   optional, stops the sequence before the end of the buffer
+ *
+ * A command with a single parameter costs 4 bytes instead of a 16 byte `st7701_lcd_init_cmd_t` plus its data.
+ */
+#define ST7701_INIT_OP_END   (0x00)
+#define ST7701_INIT_OP_CMD   (0x01)
+#define ST7701_INIT_OP_BANK  (0x02)
+#define ST7701_INIT_OP_SLEEP (0x03)
+
+/**
+ * @brief Bytecode reader state, see `esp_lcd_st7701_bytecode_next()`
+ *
+ */
+typedef struct {
+    const uint8_t *bytecode;    /*!< Bytecode being decoded */
+    size_t size;                /*!< Size of `bytecode` in bytes */
+    size_t offset;              /*!< Offset of the next instruction */
+    uint8_t bank_data[5];       /*!< Parameters of the last decoded bank selection */
+} st7701_bytecode_reader_t;
+
+/**
+ * @brief Encode an initialization command table as bytecode
+ *
+ * @note  This function has no dependency on the LCD peripheral and can be used on the host to convert existing tables.
+ *
+ * @param[in]  init_cmds Initialization command table
+ * @param[in]  init_cmds_size Number of commands in `init_cmds`
+ * @param[out] bytecode Output buffer, can be NULL to only compute the size
+ * @param[in]  bytecode_size Size of `bytecode` in bytes
+ * @param[out] ret_size Returned size of the encoded bytecode in bytes
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid, or a command doesn't fit the encoding (cmd or data_bytes above 255)
+ *      - ESP_ERR_INVALID_SIZE  if `bytecode` is too small
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_bytecode_encode(const st7701_lcd_init_cmd_t *init_cmds, uint16_t init_cmds_size,
+                                         uint8_t *bytecode, size_t bytecode_size, size_t *ret_size);
+
+/**
+ * @brief Start decoding bytecode
+ *
+ * @param[out] reader Reader to initialize
+ * @param[in]  bytecode Bytecode to decode, must stay valid while the reader is used
+ * @param[in]  size Size of `bytecode` in bytes
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_bytecode_reader_init(st7701_bytecode_reader_t *reader, const uint8_t *bytecode, size_t size);
+
+/**
+ * @brief Decode the next command of a bytecode sequence
+ *
+ * @note  Sleep instructions are folded into the `delay_ms` of the returned command. `data` points into the bytecode
+ *        (or into the reader for bank selections), nothing is copied.
+ *
+ * @param[in]  reader Reader initialized by `esp_lcd_st7701_bytecode_reader_init()`
+ * @param[out] ret_cmd Returned command
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_NOT_FOUND     if the end of the sequence has been reached
+ *      - ESP_ERR_INVALID_SIZE  if an instruction is truncated
+ *      - ESP_ERR_INVALID_RESPONSE if an unknown opcode or a sleep without preceding command is found
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_bytecode_next(st7701_bytecode_reader_t *reader, st7701_lcd_init_cmd_t *ret_cmd);
+
+/**
+ * @brief Layout of an initialization image, i.e. bytecode that is stored in a partition or file
+ *
+ * All fields are little-endian:
+ *   - 0:  magic "7701"
+ *   - 4:  format version, `ST7701_INIT_IMAGE_VERSION`
+ *   - 5:  reserved, 3 bytes of zero
+ *   - 8:  bytecode size in bytes
+ *   - 12: CRC-32 (IEEE 802.3) of the bytecode
+ *   - 16: bytecode
+ */
+#define ST7701_INIT_IMAGE_MAGIC       "7701"
+#define ST7701_INIT_IMAGE_VERSION     (1)
+#define ST7701_INIT_IMAGE_HEADER_SIZE (16)
+#define ST7701_INIT_IMAGE_MAX_SIZE    (64 * 1024)
+
+/**
+ * @brief Validate bytecode before it is sent to a panel
+ *
+ * @note  Checks that every instruction is complete, that only Command2 banks known to the ST7701 are selected, that raw
+ *        0xFF commands carry a well formed bank selection and that the sequence ends in the regular command bank.
+ * @note  This function has no dependency on the LCD peripheral and can be used (and fuzzed) on the host.
+ *
+ * @param[in]  bytecode Bytecode to validate
+ * @param[in]  size Size of `bytecode` in bytes
+ * @param[out] ret_num_cmds Returned number of commands in the sequence, can be NULL
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_INVALID_SIZE  if an instruction is truncated
+ *      - ESP_ERR_INVALID_RESPONSE if the bytecode is malformed
+ *      - ESP_ERR_INVALID_STATE if the sequence doesn't end in the regular command bank
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_bytecode_validate(const uint8_t *bytecode, size_t size, uint16_t *ret_num_cmds);
+
+/**
+ * @brief Parse and validate an initialization image, see `ST7701_INIT_IMAGE_MAGIC`
+ *
+ * @note  Nothing is copied, the returned bytecode points into `image`.
+ * @note  This function has no dependency on the LCD peripheral and can be used (and fuzzed) on the host.
+ *
+ * @param[in]  image Image to parse
+ * @param[in]  size Size of `image` in bytes, may be larger than the image itself
+ * @param[out] ret_bytecode Returned bytecode
+ * @param[out] ret_bytecode_size Returned size of the bytecode in bytes
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_NOT_FOUND     if `image` doesn't start with the magic
+ *      - ESP_ERR_INVALID_VERSION if the image format version is not supported
+ *      - ESP_ERR_INVALID_SIZE  if the image is truncated or too large
+ *      - ESP_ERR_INVALID_CRC   if the checksum doesn't match
+ *      - Otherwise             the bytecode failed validation, see `esp_lcd_st7701_bytecode_validate()`
+ */
+esp_err_t esp_lcd_st7701_init_image_parse(const uint8_t *image, size_t size, const uint8_t **ret_bytecode,
+                                          size_t *ret_bytecode_size);
+
+/**
+ * @brief Update a CRC-32 (IEEE 802.3), the checksum of initialization images
+ *
+ * @param[in] crc CRC of the data so far, 0 to start
+ * @param[in] data Data to add
+ * @param[in] size Size of `data` in bytes
+ * @return CRC of the data so far followed by `data`
+ */
+uint32_t esp_lcd_st7701_crc32(uint32_t crc, const void *data, size_t size);
+
+/**
+ * @brief Build an initialization image header for bytecode
+ *
+ * @note  Intended for host tools, the image is the header followed by the bytecode.
+ *
+ * @param[in]  bytecode Bytecode to wrap
+ * @param[in]  size Size of `bytecode` in bytes
+ * @param[out] ret_header Returned header, `ST7701_INIT_IMAGE_HEADER_SIZE` bytes
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_INVALID_SIZE  if the bytecode is too large
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_init_image_make_header(const uint8_t *bytecode, size_t size,
+                                                uint8_t ret_header[ST7701_INIT_IMAGE_HEADER_SIZE]);
+
+/**
+ * @brief Result of `esp_lcd_st7701_optimize_init_cmds()`
+ *
+ */
+typedef struct {
+    uint16_t num_cmds_in;           /*!< Number of commands in the input table */
+    uint16_t num_cmds_out;          /*!< Number of commands (DCS packets) in the optimized table */
+    uint16_t bank_selects_dropped;  /*!< Bank selections dropped because the bank was selected already */
+    uint16_t writes_merged;         /*!< Register writes dropped because a later write to the same register replaces them */
+} st7701_init_optimize_stats_t;
+
+/**
+ * @brief Remove redundant commands from an initialization command table
+ *
+ * @note  Tracks the selected Command2 bank and drops bank selections that select the current bank again. A register
+ *        write is dropped when the same register is written again later in the same bank, with no delay or bank
+ *        selection in between, so the last write wins. Commands without parameters are never dropped.
+ * @note  The optimized table refers to the parameters of `init_cmds`, which must outlive it.
+ * @note  This function has no dependency on the LCD peripheral and can be used on the host.
+ *
+ * @param[in]  init_cmds Initialization command table
+ * @param[in]  init_cmds_size Number of commands in `init_cmds`
+ * @param[out] ret_cmds Returned optimized table, can be the same as `init_cmds` to optimize in place
+ * @param[in]  max_cmds Number of commands `ret_cmds` can hold, at least `init_cmds_size`
+ * @param[out] ret_stats Returned statistics, the size of the optimized table is `num_cmds_out`
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_INVALID_SIZE  if `ret_cmds` is too small
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_optimize_init_cmds(const st7701_lcd_init_cmd_t *init_cmds, uint16_t init_cmds_size,
+                                            st7701_lcd_init_cmd_t *ret_cmds, uint16_t max_cmds,
+                                            st7701_init_optimize_stats_t *ret_stats);
+
+#define ST7701_MAX_H_RES    (480)   /*!< Source outputs of the ST7701, i.e. highest horizontal resolution */
+#define ST7701_MAX_V_RES    (864)   /*!< Highest vertical resolution LNESET can be set to */
+#define ST7701_LINE_STEP    (8)     /*!< LNESET counts lines in steps of 8 */
+
+/**
+ * @brief Display timing requirements, input of `esp_lcd_st7701_calc_timing()`
+ *
+ */
+typedef struct {
+    uint16_t h_res;                 /*!< Horizontal resolution, at most `ST7701_MAX_H_RES` */
+    uint16_t v_res;                 /*!< Vertical resolution, a multiple of `ST7701_LINE_STEP` and at most `ST7701_MAX_V_RES` */
+    uint16_t refresh_hz;            /*!< Target refresh rate */
+    uint8_t bits_per_pixel;         /*!< Pixel width: 16 (RGB565), 18 (RGB666) or 24 (RGB888) */
+    uint8_t lane_num;               /*!< Number of MIPI-DSI data lanes, defaults to 2 if set to 0 */
+    uint32_t lane_bit_rate_mbps;    /*!< MIPI-DSI lane bit rate, 0 to use the minimum the video stream needs plus `headroom_percent` */
+    uint8_t headroom_percent;       /*!< Margin on top of the minimum lane bit rate, only used if `lane_bit_rate_mbps` is 0 */
+} st7701_timing_config_t;
+
+/**
+ * @brief Display timing, output of `esp_lcd_st7701_calc_timing()`
+ *
+ * @note  The video timing and clock go to the MIPI DSI bus and MIPI DPI panel configuration (see
+ *        `esp_lcd_st7701_timing_to_config()`), the register values to the panel (see `st7701_vendor_config_t::timing`).
+ */
+typedef struct {
+    uint16_t h_res;                 /*!< Horizontal resolution */
+    uint16_t v_res;                 /*!< Vertical resolution */
+    uint16_t hsync_pulse_width;     /*!< Horizontal sync width, in pixel clock cycles */
+    uint16_t hsync_back_porch;      /*!< Horizontal back porch, in pixel clock cycles */
+    uint16_t hsync_front_porch;     /*!< Horizontal front porch, in pixel clock cycles */
+    uint16_t vsync_pulse_width;     /*!< Vertical sync width, in lines */
+    uint16_t vsync_back_porch;      /*!< Vertical back porch, in lines */
+    uint16_t vsync_front_porch;     /*!< Vertical front porch, in lines */
+    uint32_t dpi_clock_freq_mhz;    /*!< Pixel clock */
+    uint32_t refresh_mhz;           /*!< Resulting refresh rate, in millihertz */
+    uint8_t bits_per_pixel;         /*!< Pixel width */
+    uint8_t lane_num;               /*!< Number of MIPI-DSI data lanes */
+    uint32_t lane_bit_rate_mbps;    /*!< MIPI-DSI lane bit rate */
+    uint32_t required_lane_bit_rate_mbps; /*!< Lane bit rate needed to carry the video stream, without headroom */
+    uint8_t lneset[2];              /*!< Parameters of LNESET (C0h, Command2 BK0): number of lines */
+    uint8_t porctrl[2];             /*!< Parameters of PORCTRL (C1h, Command2 BK0): vertical back and front porch */
+    uint8_t invset[2];              /*!< Parameters of INVSET (C2h, Command2 BK0): inversion and minimum line length */
+} st7701_timing_t;
+
+/**
+ * @brief Calculate a consistent display timing for the given resolution, refresh rate and MIPI-DSI link
+ *
+ * @note  The porches are fixed (horizontal 10/20/10+, vertical 2/14/12 for sync/back/front), the horizontal front
+ *        porch is stretched so the line length is one the panel can program (512 + 16 * n pixel clock cycles).
+ *        The pixel clock is rounded to whole MHz, `refresh_mhz` is the refresh rate that results.
+ * @note  This function has no dependency on the LCD peripheral and can be used on the host.
+ *
+ * @param[in]  config Timing requirements
+ * @param[out] ret_timing Returned timing
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_NOT_SUPPORTED if the resolution is out of range for the panel, or the video stream exceeds the capacity
+ *                              of the MIPI-DSI link
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_calc_timing(const st7701_timing_config_t *config, st7701_timing_t *ret_timing);
+
+/**
+ * @brief Calculate the minimum MIPI-DSI lane bit rate for a video timing
+ *
+ * @note  Accounts for the pixel data (RGB666 loosely packed, i.e. 24 bits) and the sync and blanking packets of every
+ *        line, split over `timing->lane_num` lanes. The result is rounded up to whole Mbps and is at least the lowest
+ *        rate of the D-PHY (80 Mbps). Running the PHY no faster than needed saves power and reduces EMI.
+ * @note  Only the video timing, `dpi_clock_freq_mhz`, `bits_per_pixel` and `lane_num` of `timing` are used.
+ * @note  This function has no dependency on the LCD peripheral and can be used on the host.
+ *
+ * @param[in]  timing Video timing
+ * @param[in]  headroom_percent Margin on top of the minimum
+ * @param[out] ret_lane_bit_rate_mbps Returned lane bit rate
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_NOT_SUPPORTED if the video stream needs more than the D-PHY can carry (1500 Mbps per lane)
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_calc_lane_bit_rate(const st7701_timing_t *timing, uint8_t headroom_percent,
+                                            uint32_t *ret_lane_bit_rate_mbps);
+
+#ifdef __cplusplus
+}
+#endif
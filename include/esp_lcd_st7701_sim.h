@@ -0,0 +1,113 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_lcd_st7701_init_seq.h"
+#include "esp_lcd_st7701_color.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Simulated ST7701: the registers that decide how the frame buffer shows up on the glass
+ *
+ * @note  Feed it every command the driver sends, e.g. from the `tx_param()` of a host side `esp_lcd_panel_io_t`, and
+ *        render the frame buffer through it to get what the panel would display.
+ * @note  Host only: `esp_lcd_st7701_sim.c` is built by the host tests in `test/host`, not by the component.
+ */
+typedef struct {
+    uint16_t width;                 /*!< Horizontal resolution */
+    uint16_t height;                /*!< Vertical resolution */
+    uint8_t bank;                   /*!< Selected Command2 bank */
+    uint8_t madctl;                 /*!< MADCTL: ML (bit 4) reverses the line order, BGR (bit 3) swaps red and blue */
+    uint8_t colmod;                 /*!< COLMOD: interface pixel format, 0x50 RGB565, 0x60 RGB666, 0x70 RGB888 */
+    uint8_t sdir;                   /*!< SDIR in BK0: SS (bit 2) reverses the source order */
+    bool inverted;                  /*!< INVON was sent after the last INVOFF */
+    bool sleeping;                  /*!< In sleep mode, i.e. after reset or SLPIN */
+    bool display_on;                /*!< DISPON was sent after the last DISPOFF */
+} st7701_sim_t;
+
+/**
+ * @brief Initialize a simulated panel in its reset state: sleeping, display off, regular bank, RGB888
+ *
+ * @param[out] sim Simulated panel
+ * @param[in]  width Horizontal resolution
+ * @param[in]  height Vertical resolution
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_sim_init(st7701_sim_t *sim, uint16_t width, uint16_t height);
+
+/**
+ * @brief Send one command to the simulated panel, with the arguments of `esp_lcd_panel_io_tx_param()`
+ *
+ * @note  Commands that don't change how the frame buffer is displayed are accepted and ignored.
+ *
+ * @param[inout] sim Simulated panel
+ * @param[in]    cmd Command
+ * @param[in]    param Parameters, can be NULL if `param_size` is 0
+ * @param[in]    param_size Number of parameters
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_sim_tx_param(st7701_sim_t *sim, int cmd, const void *param, size_t param_size);
+
+/**
+ * @brief Send an initialization command table to the simulated panel, delays are skipped
+ *
+ * @param[inout] sim Simulated panel
+ * @param[in]    cmds Initialization commands
+ * @param[in]    num_cmds Number of commands
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_sim_run_cmds(st7701_sim_t *sim, const st7701_lcd_init_cmd_t *cmds, size_t num_cmds);
+
+/**
+ * @brief Render what the panel displays for a frame buffer
+ *
+ * @note  Applies the line and source order, color inversion, BGR order and the color depth of the interface. A
+ *        sleeping panel or one with the display off shows black.
+ *
+ * @param[in]  sim Simulated panel
+ * @param[in]  fb Frame buffer, `width` x `height` pixels as sent over MIPI DPI
+ * @param[in]  format Pixel format of the frame buffer, RGB565 or RGB888
+ * @param[out] rgb Rendered image, `width` x `height` pixels of 3 bytes in the order red, green, blue
+ * @return
+ *      - ESP_ERR_INVALID_ARG   if parameter is invalid
+ *      - ESP_ERR_NOT_SUPPORTED if the pixel format is not supported
+ *      - ESP_ERR_INVALID_STATE if COLMOD doesn't match the frame buffer, which shows garbage on the real panel
+ *      - ESP_OK                on success
+ */
+esp_err_t esp_lcd_st7701_sim_render(const st7701_sim_t *sim, const void *fb, st7701_color_format_t format, uint8_t *rgb);
+
+/**
+ * @brief Render what the panel displays for a frame buffer as a binary PPM (P6) image
+ *
+ * @param[in] sim Simulated panel
+ * @param[in] fb Frame buffer, see `esp_lcd_st7701_sim_render()`
+ * @param[in] format Pixel format of the frame buffer, RGB565 or RGB888
+ * @param[in] stream Stream to write to, e.g. a file opened in binary mode
+ * @return
+ *      - ESP_ERR_NO_MEM        if the image can't be allocated
+ *      - ESP_FAIL              if writing the stream failed
+ *      - Otherwise             see `esp_lcd_st7701_sim_render()`
+ */
+esp_err_t esp_lcd_st7701_sim_write_ppm(const st7701_sim_t *sim, const void *fb, st7701_color_format_t format, FILE *stream);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,115 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Fuzz target for `esp_lcd_st7701_init_image_parse()`, the entry point for images from flash or files.
+// With clang and -DST7701_FUZZ=ON this is a libFuzzer binary:
+//   ./fuzz_init_image -max_len=4096 corpus/
+// Without, it runs the target on the files given on the command line, or on every truncation and single bit flip
+// of a valid image, as a regular test.
+
+#include <string.h>
+#include "test_common.h"
+#include "esp_lcd_st7701_init_seq.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    const uint8_t *bytecode = NULL;
+    size_t bytecode_size = 0;
+
+    // Copy the input so the sanitizers see reads past its end
+    uint8_t *image = malloc(size ? size : 1);
+    TEST_ASSERT(image);
+    memcpy(image, data, size);
+
+    if (esp_lcd_st7701_init_image_parse(image, size, &bytecode, &bytecode_size) == ESP_OK) {
+        TEST_ASSERT(bytecode >= image && bytecode + bytecode_size <= image + size);
+
+        // An accepted image decodes to the end without errors, every command within the image
+        st7701_bytecode_reader_t reader;
+        st7701_lcd_init_cmd_t cmd;
+        uint16_t num_cmds = 0;
+        uint16_t count = 0;
+        esp_err_t ret = ESP_OK;
+        TEST_ESP_OK(esp_lcd_st7701_bytecode_validate(bytecode, bytecode_size, &num_cmds));
+        TEST_ESP_OK(esp_lcd_st7701_bytecode_reader_init(&reader, bytecode, bytecode_size));
+        while ((ret = esp_lcd_st7701_bytecode_next(&reader, &cmd)) == ESP_OK) {
+            const uint8_t *param = cmd.data;
+            TEST_ASSERT(!cmd.data_bytes || (param >= image && param + cmd.data_bytes <= image + size) ||
+                        param == reader.bank_data);
+            count++;
+        }
+        TEST_ESP_ERR(ESP_ERR_NOT_FOUND, ret);
+        TEST_ASSERT_EQUAL(num_cmds, count);
+    }
+    // The bytecode checks alone, on input without a header
+    esp_lcd_st7701_bytecode_validate(image, size, NULL);
+
+    free(image);
+    return 0;
+}
+
+#ifndef ST7701_LIBFUZZER
+
+static void run_file(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    TEST_ASSERT(file);
+    static uint8_t data[ST7701_INIT_IMAGE_MAX_SIZE];
+    size_t size = fread(data, 1, sizeof(data), file);
+    fclose(file);
+    LLVMFuzzerTestOneInput(data, size);
+}
+
+static void run_mutations(void)
+{
+    const st7701_lcd_init_cmd_t *init_cmds = NULL;
+    uint16_t init_cmds_size = 0;
+    static uint8_t image[1024];
+    size_t bytecode_size = 0;
+
+    TEST_ESP_OK(esp_lcd_st7701_get_default_init_cmds(&init_cmds, &init_cmds_size));
+    TEST_ESP_OK(esp_lcd_st7701_bytecode_encode(init_cmds, init_cmds_size, &image[ST7701_INIT_IMAGE_HEADER_SIZE],
+                                               sizeof(image) - ST7701_INIT_IMAGE_HEADER_SIZE, &bytecode_size));
+    const uint8_t *bytecode = &image[ST7701_INIT_IMAGE_HEADER_SIZE];
+    TEST_ESP_OK(esp_lcd_st7701_init_image_make_header(bytecode, bytecode_size, image));
+    size_t size = ST7701_INIT_IMAGE_HEADER_SIZE + bytecode_size;
+
+    for (size_t i = 0; i <= size; i++) {
+        LLVMFuzzerTestOneInput(image, i);
+    }
+    for (size_t i = 0; i < size; i++) {
+        for (int bit = 0; bit < 8; bit++) {
+            image[i] ^= 1 << bit;
+            // Fix up the checksum, so the flip reaches the bytecode checks
+            if (i >= ST7701_INIT_IMAGE_HEADER_SIZE) {
+                TEST_ESP_OK(esp_lcd_st7701_init_image_make_header(bytecode, bytecode_size, image));
+            }
+            LLVMFuzzerTestOneInput(image, size);
+            image[i] ^= 1 << bit;
+        }
+        if (i >= ST7701_INIT_IMAGE_HEADER_SIZE) {
+            TEST_ESP_OK(esp_lcd_st7701_init_image_make_header(bytecode, bytecode_size, image));
+        }
+    }
+    printf("%u inputs\n", (unsigned int)(size + 1 + size * 8));
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            run_file(argv[i]);
+        }
+    } else {
+        run_mutations();
+    }
+
+    return 0;
+}
+
+#endif // ST7701_LIBFUZZER
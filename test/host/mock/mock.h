@@ -0,0 +1,171 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "esp_lcd_types.h"
+#include "esp_lcd_mipi_dsi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MOCK_TX_MAX         (256)   /*!< Transactions recorded, later ones are only counted */
+#define MOCK_DELAY_MAX      (64)    /*!< Delays recorded, later ones are only counted */
+#define MOCK_GPIO_MAX       (16)    /*!< GPIO level changes recorded, later ones are only counted */
+#define MOCK_PARAM_MAX      (32)    /*!< Parameters recorded per transaction, longer ones are truncated */
+
+/**
+ * @brief DCS transaction sent through the mocked panel IO
+ */
+typedef struct {
+    int64_t time_us;                /*!< Virtual time the transaction started */
+    int cmd;                        /*!< Command */
+    size_t param_size;              /*!< Number of parameters sent */
+    uint8_t param[MOCK_PARAM_MAX];  /*!< Parameters, the first `MOCK_PARAM_MAX` of them */
+    bool in_critical;               /*!< Sent inside a critical section, where a blocking transfer must never be */
+} mock_tx_t;
+
+/**
+ * @brief Delay requested through `vTaskDelay()`
+ */
+typedef struct {
+    int64_t time_us;                /*!< Virtual time the delay started */
+    uint32_t ticks;                 /*!< Requested ticks */
+} mock_delay_t;
+
+/**
+ * @brief GPIO level change
+ */
+typedef struct {
+    int64_t time_us;                /*!< Virtual time of the change */
+    int gpio_num;
+    uint32_t level;
+} mock_gpio_t;
+
+/**
+ * @brief Called for every transaction after it has been recorded, e.g. to forward it to a simulated panel
+ */
+typedef void (*mock_tx_hook_t)(void *ctx, int64_t time_us, int cmd, const void *param, size_t param_size);
+
+/**
+ * @brief Answers reads through the mocked panel IO, reads fail with ESP_ERR_TIMEOUT without one
+ */
+typedef esp_err_t (*mock_rx_hook_t)(void *ctx, int cmd, void *param, size_t param_size);
+
+/**
+ * @brief Reset all mocks: virtual time 0, no records, no hooks, no armed timers, no injected failures
+ * @note  MIPI DPI panels that are still alive are leaked, delete them first.
+ */
+void mock_reset(void);
+
+/**
+ * @brief Get the virtual time, the time base of `esp_timer_get_time()` and `vTaskDelay()`
+ */
+int64_t mock_time_us(void);
+
+/**
+ * @brief Let virtual time pass
+ */
+void mock_advance_us(int64_t us);
+
+/**
+ * @brief Set the bus time every transaction takes, 0 by default
+ */
+void mock_set_tx_cost_us(uint32_t us);
+
+/**
+ * @brief Make the next `count` transactions of `cmd` fail with ESP_ERR_TIMEOUT, unrecorded
+ */
+void mock_fail_tx(int cmd, int count);
+
+/**
+ * @brief Set the hooks of the mocked panel IO, NULL to remove
+ */
+void mock_set_tx_hook(mock_tx_hook_t hook, void *ctx);
+void mock_set_rx_hook(mock_rx_hook_t hook, void *ctx);
+
+/**
+ * @brief Get the mocked panel IO and MIPI DSI bus
+ */
+esp_lcd_panel_io_handle_t mock_panel_io(void);
+esp_lcd_dsi_bus_handle_t mock_dsi_bus(void);
+
+/**
+ * @brief Recorded transactions, delays and GPIO level changes, oldest first
+ */
+size_t mock_num_tx(void);
+const mock_tx_t *mock_get_tx(size_t index);
+size_t mock_num_rx(void);
+size_t mock_num_delays(void);
+const mock_delay_t *mock_get_delay(size_t index);
+size_t mock_num_gpio(void);
+const mock_gpio_t *mock_get_gpio(size_t index);
+
+/**
+ * @brief Find the first recorded transaction of `cmd` at or after `from`
+ * @return Index of the transaction, -1 if there is none
+ */
+int mock_find_tx(int cmd, size_t from);
+
+/**
+ * @brief Fire the esp_timer that expires next, advancing virtual time to its expiry
+ * @return false if no timer is armed
+ */
+bool mock_run_timer(void);
+
+/**
+ * @brief Make `nvs_open()` fail as if `nvs_flash_init()` had not been called, NVS is initialized and empty by default
+ */
+void mock_nvs_set_initialized(bool initialized);
+
+/**
+ * @brief Number of `nvs_commit()` calls, i.e. flash writes
+ */
+size_t mock_nvs_num_commits(void);
+
+/**
+ * @brief Make the next `count` calls of `esp_lcd_new_panel_dpi()` fail with ESP_ERR_NO_MEM
+ */
+void mock_dpi_fail_create(int count);
+
+/**
+ * @brief Number of MIPI DPI panels alive
+ */
+int mock_dpi_num_panels(void);
+
+/**
+ * @brief Get the configuration a mocked MIPI DPI panel was created with
+ */
+const esp_lcd_dpi_panel_config_t *mock_dpi_get_config(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Check whether a mocked MIPI DPI panel has been initialized, i.e. streams video
+ */
+bool mock_dpi_started(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Get the frame buffer a mocked MIPI DPI panel scans out
+ */
+void *mock_dpi_front_fb(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief End a refresh of a mocked MIPI DPI panel: switch to the frame buffer drawn last and call `on_refresh_done`
+ */
+void mock_dpi_refresh(esp_lcd_panel_handle_t panel);
+
+/**
+ * @brief Number of scale-rotate-mirror operations done by the PPA, only in builds with the PPA
+ */
+size_t mock_ppa_num_srm(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,377 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// System services on a virtual clock: time only passes through delays, timers and bus time, so every run of a test
+// sees the same timestamps
+
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_cache.h"
+#include "esp_partition.h"
+#include "nvs.h"
+#include "mock.h"
+#include "mock_internal.h"
+
+#define MOCK_TIMERS_MAX (8)
+#define MOCK_NVS_MAX    (8)
+
+typedef struct {
+    char namespace_name[16];
+    char key[16];
+    uint32_t value;
+} mock_nvs_entry_t;
+
+struct esp_timer {
+    esp_timer_create_args_t args;
+    int64_t expiry_us;
+    bool armed;
+    bool used;
+};
+
+static struct {
+    int64_t time_us;
+    size_t num_delays;
+    mock_delay_t delays[MOCK_DELAY_MAX];
+    size_t num_gpio;
+    mock_gpio_t gpio[MOCK_GPIO_MAX];
+    struct esp_timer timers[MOCK_TIMERS_MAX];
+    bool nvs_uninitialized;
+    char nvs_namespaces[MOCK_NVS_MAX][16];      // handle n refers to entry n - 1
+    mock_nvs_entry_t nvs[MOCK_NVS_MAX];
+    size_t nvs_commits;
+} s_idf;
+
+int mock_critical_nesting;
+
+void mock_idf_reset(void)
+{
+    memset(&s_idf, 0, sizeof(s_idf));
+    mock_critical_nesting = 0;
+}
+
+void mock_nvs_set_initialized(bool initialized)
+{
+    s_idf.nvs_uninitialized = !initialized;
+}
+
+size_t mock_nvs_num_commits(void)
+{
+    return s_idf.nvs_commits;
+}
+
+int64_t mock_time_us(void)
+{
+    return s_idf.time_us;
+}
+
+void mock_advance_us(int64_t us)
+{
+    s_idf.time_us += us;
+}
+
+size_t mock_num_delays(void)
+{
+    return s_idf.num_delays;
+}
+
+const mock_delay_t *mock_get_delay(size_t index)
+{
+    return index < s_idf.num_delays && index < MOCK_DELAY_MAX ? &s_idf.delays[index] : NULL;
+}
+
+size_t mock_num_gpio(void)
+{
+    return s_idf.num_gpio;
+}
+
+const mock_gpio_t *mock_get_gpio(size_t index)
+{
+    return index < s_idf.num_gpio && index < MOCK_GPIO_MAX ? &s_idf.gpio[index] : NULL;
+}
+
+bool mock_run_timer(void)
+{
+    struct esp_timer *next = NULL;
+
+    for (int i = 0; i < MOCK_TIMERS_MAX; i++) {
+        if (s_idf.timers[i].armed && (!next || s_idf.timers[i].expiry_us < next->expiry_us)) {
+            next = &s_idf.timers[i];
+        }
+    }
+    if (!next) {
+        return false;
+    }
+    if (next->expiry_us > s_idf.time_us) {
+        s_idf.time_us = next->expiry_us;
+    }
+    next->armed = false;
+    next->args.callback(next->args.arg);
+
+    return true;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:
+        return "ESP_OK";
+    case ESP_FAIL:
+        return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:
+        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:
+        return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:
+        return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:
+        return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:
+        return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:
+        return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:
+        return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_CRC:
+        return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_NOT_FINISHED:
+        return "ESP_ERR_NOT_FINISHED";
+    case ESP_ERR_NVS_NOT_INITIALIZED:
+        return "ESP_ERR_NVS_NOT_INITIALIZED";
+    case ESP_ERR_NVS_NOT_FOUND:
+        return "ESP_ERR_NVS_NOT_FOUND";
+    default:
+        return "UNKNOWN ERROR";
+    }
+}
+
+void vTaskDelay(const TickType_t ticks_to_delay)
+{
+    if (s_idf.num_delays < MOCK_DELAY_MAX) {
+        s_idf.delays[s_idf.num_delays] = (mock_delay_t) {
+            .time_us = s_idf.time_us,
+            .ticks = ticks_to_delay,
+        };
+    }
+    s_idf.num_delays++;
+    s_idf.time_us += (int64_t)ticks_to_delay * portTICK_PERIOD_MS * 1000;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return s_idf.time_us / 1000 / portTICK_PERIOD_MS;
+}
+
+esp_err_t gpio_config(const gpio_config_t *config)
+{
+    return config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+    if (s_idf.num_gpio < MOCK_GPIO_MAX) {
+        s_idf.gpio[s_idf.num_gpio] = (mock_gpio_t) {
+            .time_us = s_idf.time_us,
+            .gpio_num = gpio_num,
+            .level = level,
+        };
+    }
+    s_idf.num_gpio++;
+
+    return ESP_OK;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio_num)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *create_args, esp_timer_handle_t *out_handle)
+{
+    if (!create_args || !create_args->callback || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < MOCK_TIMERS_MAX; i++) {
+        if (!s_idf.timers[i].used) {
+            s_idf.timers[i] = (struct esp_timer) {
+                .args = *create_args,
+                .used = true,
+            };
+            *out_handle = &s_idf.timers[i];
+            return ESP_OK;
+        }
+    }
+
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (!timer || !timer->used) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->expiry_us = s_idf.time_us + timeout_us;
+    timer->armed = true;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer || !timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->armed = false;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (!timer || timer->armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->used = false;
+
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return s_idf.time_us;
+}
+
+void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    return malloc(size);
+}
+
+void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    return calloc(n, size);
+}
+
+void *heap_caps_aligned_calloc(size_t alignment, size_t n, size_t size, uint32_t caps)
+{
+    void *ptr = aligned_alloc(alignment, (n * size + alignment - 1) / alignment * alignment);
+
+    if (ptr) {
+        memset(ptr, 0, n * size);
+    }
+    return ptr;
+}
+
+void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
+
+esp_err_t esp_cache_msync(void *addr, size_t size, int flags)
+{
+    return addr ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label)
+{
+    return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t *partition, size_t offset, size_t size, esp_partition_mmap_memory_t memory,
+                             const void **out_ptr, esp_partition_mmap_handle_t *out_handle)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t handle)
+{
+}
+
+esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    if (s_idf.nvs_uninitialized) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    if (!namespace_name || strlen(namespace_name) >= sizeof(s_idf.nvs_namespaces[0]) || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (int i = 0; i < MOCK_NVS_MAX; i++) {
+        if (!s_idf.nvs_namespaces[i][0] || !strcmp(s_idf.nvs_namespaces[i], namespace_name)) {
+            strcpy(s_idf.nvs_namespaces[i], namespace_name);
+            *out_handle = i + 1;
+            return ESP_OK;
+        }
+    }
+
+    return ESP_ERR_NO_MEM;
+}
+
+static mock_nvs_entry_t *mock_nvs_find(nvs_handle_t handle, const char *key, bool create)
+{
+    if (!handle || handle > MOCK_NVS_MAX || !key || strlen(key) >= sizeof(s_idf.nvs[0].key)) {
+        return NULL;
+    }
+    const char *namespace_name = s_idf.nvs_namespaces[handle - 1];
+    for (int i = 0; i < MOCK_NVS_MAX; i++) {
+        mock_nvs_entry_t *entry = &s_idf.nvs[i];
+        if (!entry->key[0] && create) {
+            strcpy(entry->namespace_name, namespace_name);
+            strcpy(entry->key, key);
+            return entry;
+        }
+        if (!strcmp(entry->namespace_name, namespace_name) && !strcmp(entry->key, key)) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *out_value)
+{
+    mock_nvs_entry_t *entry = mock_nvs_find(handle, key, false);
+
+    if (!entry || !out_value) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *out_value = entry->value;
+
+    return ESP_OK;
+}
+
+esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value)
+{
+    mock_nvs_entry_t *entry = mock_nvs_find(handle, key, true);
+
+    if (!entry) {
+        return ESP_ERR_NO_MEM;
+    }
+    entry->value = value;
+
+    return ESP_OK;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    s_idf.nvs_commits++;
+
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+}
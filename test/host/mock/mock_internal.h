@@ -0,0 +1,12 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+// Shared between the mocks, not for tests
+
+void mock_idf_reset(void);
+void mock_lcd_reset(void);
@@ -0,0 +1,380 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Panel IO that records every transaction and a MIPI DPI panel whose frame buffers live in host memory
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_lcd_panel_io.h"
+#include "esp_lcd_panel_interface.h"
+#include "esp_lcd_panel_vendor.h"
+#include "esp_lcd_mipi_dsi.h"
+#include "hal/mipi_dsi_host_ll.h"
+#include "hal/mipi_dsi_brg_ll.h"
+#include "mock.h"
+#include "mock_internal.h"
+
+typedef struct {
+    esp_lcd_panel_t base;           // must be first, the handle points here
+    esp_lcd_dpi_panel_config_t config;
+    void *fbs[3];
+    size_t fb_size;
+    int draw;                       // frame buffer drawn last, scanned out from the next refresh on
+    int front;
+    bool started;
+    esp_lcd_dpi_panel_event_callbacks_t cbs;
+    void *cbs_ctx;
+} mock_dpi_panel_t;
+
+struct esp_lcd_panel_io_t {
+    int reserved;
+};
+
+struct esp_lcd_dsi_bus_t {
+    int reserved;
+};
+
+static struct esp_lcd_panel_io_t s_io;
+static struct esp_lcd_dsi_bus_t s_bus;
+
+dsi_host_dev_t MIPI_DSI_HOST;
+dsi_brg_dev_t MIPI_DSI_BRIDGE;
+
+static struct {
+    uint32_t tx_cost_us;
+    mock_tx_hook_t tx_hook;
+    void *tx_ctx;
+    mock_rx_hook_t rx_hook;
+    void *rx_ctx;
+    size_t num_tx;
+    mock_tx_t tx[MOCK_TX_MAX];
+    size_t num_rx;
+    int fail_tx_cmd;
+    int fail_tx;
+    int dpi_fail;
+    int dpi_panels;
+} s_lcd;
+
+void mock_lcd_reset(void)
+{
+    memset(&s_lcd, 0, sizeof(s_lcd));
+    memset(&MIPI_DSI_HOST, 0, sizeof(MIPI_DSI_HOST));
+    memset(&MIPI_DSI_BRIDGE, 0, sizeof(MIPI_DSI_BRIDGE));
+}
+
+void mock_reset(void)
+{
+    mock_idf_reset();
+    mock_lcd_reset();
+}
+
+void mock_set_tx_cost_us(uint32_t us)
+{
+    s_lcd.tx_cost_us = us;
+}
+
+void mock_set_tx_hook(mock_tx_hook_t hook, void *ctx)
+{
+    s_lcd.tx_hook = hook;
+    s_lcd.tx_ctx = ctx;
+}
+
+void mock_set_rx_hook(mock_rx_hook_t hook, void *ctx)
+{
+    s_lcd.rx_hook = hook;
+    s_lcd.rx_ctx = ctx;
+}
+
+esp_lcd_panel_io_handle_t mock_panel_io(void)
+{
+    return &s_io;
+}
+
+esp_lcd_dsi_bus_handle_t mock_dsi_bus(void)
+{
+    return &s_bus;
+}
+
+size_t mock_num_tx(void)
+{
+    return s_lcd.num_tx;
+}
+
+const mock_tx_t *mock_get_tx(size_t index)
+{
+    return index < s_lcd.num_tx && index < MOCK_TX_MAX ? &s_lcd.tx[index] : NULL;
+}
+
+size_t mock_num_rx(void)
+{
+    return s_lcd.num_rx;
+}
+
+int mock_find_tx(int cmd, size_t from)
+{
+    for (size_t i = from; i < s_lcd.num_tx && i < MOCK_TX_MAX; i++) {
+        if (s_lcd.tx[i].cmd == cmd) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void mock_fail_tx(int cmd, int count)
+{
+    s_lcd.fail_tx_cmd = cmd;
+    s_lcd.fail_tx = count;
+}
+
+esp_err_t esp_lcd_panel_io_tx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, const void *param, size_t param_size)
+{
+    if (io != &s_io || (param_size && !param)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_lcd.fail_tx && lcd_cmd == s_lcd.fail_tx_cmd) {
+        s_lcd.fail_tx--;
+        return ESP_ERR_TIMEOUT;
+    }
+    int64_t time_us = mock_time_us();
+    if (s_lcd.num_tx < MOCK_TX_MAX) {
+        mock_tx_t *tx = &s_lcd.tx[s_lcd.num_tx];
+        tx->time_us = time_us;
+        tx->cmd = lcd_cmd;
+        tx->param_size = param_size;
+        tx->in_critical = mock_critical_nesting > 0;
+        memcpy(tx->param, param, param_size < MOCK_PARAM_MAX ? param_size : MOCK_PARAM_MAX);
+    }
+    s_lcd.num_tx++;
+    mock_advance_us(s_lcd.tx_cost_us);
+    if (s_lcd.tx_hook) {
+        s_lcd.tx_hook(s_lcd.tx_ctx, time_us, lcd_cmd, param, param_size);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_io_rx_param(esp_lcd_panel_io_handle_t io, int lcd_cmd, void *param, size_t param_size)
+{
+    if (io != &s_io || (param_size && !param)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_lcd.num_rx++;
+    mock_advance_us(s_lcd.tx_cost_us);
+
+    return s_lcd.rx_hook ? s_lcd.rx_hook(s_lcd.rx_ctx, lcd_cmd, param, param_size) : ESP_ERR_TIMEOUT;
+}
+
+static size_t mock_dpi_bytes_per_pixel(lcd_color_rgb_pixel_format_t format)
+{
+    return format == LCD_COLOR_PIXEL_FORMAT_RGB565 ? 2 : 3;
+}
+
+static esp_err_t mock_dpi_del(esp_lcd_panel_t *panel)
+{
+    mock_dpi_panel_t *dpi = (mock_dpi_panel_t *)panel;
+
+    for (int i = 0; i < 3; i++) {
+        free(dpi->fbs[i]);
+    }
+    free(dpi);
+    s_lcd.dpi_panels--;
+
+    return ESP_OK;
+}
+
+static esp_err_t mock_dpi_init(esp_lcd_panel_t *panel)
+{
+    mock_dpi_panel_t *dpi = (mock_dpi_panel_t *)panel;
+    const esp_lcd_video_timing_t *timing = &dpi->config.video_timing;
+
+    // As the MIPI DPI panel of ESP-IDF, which programs the video timing when it starts
+    mipi_dsi_host_ll_dpi_set_vertical_timing(&MIPI_DSI_HOST, timing->vsync_pulse_width, timing->vsync_back_porch,
+                                             timing->v_size, timing->vsync_front_porch);
+    mipi_dsi_brg_ll_set_vertical_timing(&MIPI_DSI_BRIDGE, timing->vsync_pulse_width, timing->vsync_back_porch,
+                                        timing->v_size, timing->vsync_front_porch);
+    mipi_dsi_brg_ll_update_dpi_config(&MIPI_DSI_BRIDGE);
+    dpi->started = true;
+
+    return ESP_OK;
+}
+
+static esp_err_t mock_dpi_draw_bitmap(esp_lcd_panel_t *panel, int x_start, int y_start, int x_end, int y_end,
+                                      const void *color_data)
+{
+    mock_dpi_panel_t *dpi = (mock_dpi_panel_t *)panel;
+    const esp_lcd_video_timing_t *timing = &dpi->config.video_timing;
+
+    if (x_start < 0 || y_start < 0 || x_start >= x_end || y_start >= y_end || x_end > timing->h_size ||
+            y_end > timing->v_size || !color_data) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Like the real panel, drawing one of its own frame buffers selects it instead of copying
+    for (int i = 0; i < dpi->config.num_fbs; i++) {
+        const uint8_t *fb = dpi->fbs[i];
+        if ((const uint8_t *)color_data >= fb && (const uint8_t *)color_data < fb + dpi->fb_size) {
+            dpi->draw = i;
+            return ESP_OK;
+        }
+    }
+    size_t bpp = mock_dpi_bytes_per_pixel(dpi->config.pixel_format);
+    size_t row = (x_end - x_start) * bpp;
+    const uint8_t *src = color_data;
+    uint8_t *dst = (uint8_t *)dpi->fbs[dpi->draw] + (y_start * timing->h_size + x_start) * bpp;
+    for (int y = y_start; y < y_end; y++) {
+        memcpy(dst, src, row);
+        dst += timing->h_size * bpp;
+        src += row;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_new_panel_dpi(esp_lcd_dsi_bus_handle_t bus, const esp_lcd_dpi_panel_config_t *panel_config,
+                                esp_lcd_panel_handle_t *ret_panel)
+{
+    if (bus != &s_bus || !panel_config || !ret_panel || panel_config->num_fbs > 3) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_lcd.dpi_fail) {
+        s_lcd.dpi_fail--;
+        return ESP_ERR_NO_MEM;
+    }
+    mock_dpi_panel_t *dpi = calloc(1, sizeof(mock_dpi_panel_t));
+    if (!dpi) {
+        return ESP_ERR_NO_MEM;
+    }
+    dpi->config = *panel_config;
+    if (!dpi->config.num_fbs) {
+        dpi->config.num_fbs = 1;
+    }
+    dpi->fb_size = panel_config->video_timing.h_size * panel_config->video_timing.v_size *
+                   mock_dpi_bytes_per_pixel(panel_config->pixel_format);
+    for (int i = 0; i < dpi->config.num_fbs; i++) {
+        dpi->fbs[i] = calloc(1, dpi->fb_size);
+        if (!dpi->fbs[i]) {
+            s_lcd.dpi_panels++;
+            mock_dpi_del(&dpi->base);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    dpi->base.del = mock_dpi_del;
+    dpi->base.init = mock_dpi_init;
+    dpi->base.draw_bitmap = mock_dpi_draw_bitmap;
+    s_lcd.dpi_panels++;
+    *ret_panel = &dpi->base;
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_dpi_panel_get_frame_buffer(esp_lcd_panel_handle_t dpi_panel, uint32_t fb_num, void **fb0, ...)
+{
+    mock_dpi_panel_t *dpi = (mock_dpi_panel_t *)dpi_panel;
+
+    if (!dpi || !fb_num || fb_num > dpi->config.num_fbs) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *fb0 = dpi->fbs[0];
+    va_list args;
+    va_start(args, fb0);
+    for (uint32_t i = 1; i < fb_num; i++) {
+        void **fb = va_arg(args, void **);
+        *fb = dpi->fbs[i];
+    }
+    va_end(args);
+
+    return ESP_OK;
+}
+
+esp_err_t esp_lcd_dpi_panel_register_event_callbacks(esp_lcd_panel_handle_t dpi_panel,
+                                                     const esp_lcd_dpi_panel_event_callbacks_t *cbs, void *user_ctx)
+{
+    mock_dpi_panel_t *dpi = (mock_dpi_panel_t *)dpi_panel;
+
+    if (!dpi || !cbs) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    dpi->cbs = *cbs;
+    dpi->cbs_ctx = user_ctx;
+
+    return ESP_OK;
+}
+
+void mock_dpi_fail_create(int count)
+{
+    s_lcd.dpi_fail = count;
+}
+
+int mock_dpi_num_panels(void)
+{
+    return s_lcd.dpi_panels;
+}
+
+const esp_lcd_dpi_panel_config_t *mock_dpi_get_config(esp_lcd_panel_handle_t panel)
+{
+    return &((mock_dpi_panel_t *)panel)->config;
+}
+
+bool mock_dpi_started(esp_lcd_panel_handle_t panel)
+{
+    return ((mock_dpi_panel_t *)panel)->started;
+}
+
+void *mock_dpi_front_fb(esp_lcd_panel_handle_t panel)
+{
+    mock_dpi_panel_t *dpi = (mock_dpi_panel_t *)panel;
+
+    return dpi->fbs[dpi->front];
+}
+
+void mock_dpi_refresh(esp_lcd_panel_handle_t panel)
+{
+    mock_dpi_panel_t *dpi = (mock_dpi_panel_t *)panel;
+    esp_lcd_dpi_panel_event_data_t edata = { 0 };
+
+    dpi->front = dpi->draw;
+    if (dpi->cbs.on_refresh_done) {
+        dpi->cbs.on_refresh_done(panel, &edata, dpi->cbs_ctx);
+    }
+}
+
+esp_err_t esp_lcd_panel_reset(esp_lcd_panel_handle_t panel)
+{
+    return panel->reset ? panel->reset(panel) : ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_init(esp_lcd_panel_handle_t panel)
+{
+    return panel->init ? panel->init(panel) : ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_del(esp_lcd_panel_handle_t panel)
+{
+    return panel->del ? panel->del(panel) : ESP_OK;
+}
+
+esp_err_t esp_lcd_panel_draw_bitmap(esp_lcd_panel_handle_t panel, int x_start, int y_start, int x_end, int y_end,
+                                    const void *color_data)
+{
+    return panel->draw_bitmap(panel, x_start, y_start, x_end, y_end, color_data);
+}
+
+esp_err_t esp_lcd_panel_mirror(esp_lcd_panel_handle_t panel, bool mirror_x, bool mirror_y)
+{
+    return panel->mirror ? panel->mirror(panel, mirror_x, mirror_y) : ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_panel_swap_xy(esp_lcd_panel_handle_t panel, bool swap_axes)
+{
+    return panel->swap_xy ? panel->swap_xy(panel, swap_axes) : ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_lcd_panel_invert_color(esp_lcd_panel_handle_t panel, bool invert_color_data)
+{
+    return panel->invert_color ? panel->invert_color(panel, invert_color_data) : ESP_ERR_NOT_SUPPORTED;
+}
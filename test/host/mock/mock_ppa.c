@@ -0,0 +1,180 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// The PPA on the CPU, with the semantics ESP-IDF documents: scale-rotate-mirror rotates the input block
+// counter-clockwise, then mirrors the result. Scaling is limited to 1:1, which is all the driver uses.
+
+#include <stdlib.h>
+#include <string.h>
+#include "driver/ppa.h"
+#include "esp_lcd_st7701_fb.h"
+#include "mock.h"
+
+struct ppa_client_t {
+    ppa_operation_t oper_type;
+};
+
+static size_t s_srm_ops;
+
+size_t mock_ppa_num_srm(void)
+{
+    return s_srm_ops;
+}
+
+esp_err_t ppa_register_client(const ppa_client_config_t *config, ppa_client_handle_t *ret_client)
+{
+    if (!config || !ret_client) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    ppa_client_handle_t client = calloc(1, sizeof(struct ppa_client_t));
+    if (!client) {
+        return ESP_ERR_NO_MEM;
+    }
+    client->oper_type = config->oper_type;
+    *ret_client = client;
+
+    return ESP_OK;
+}
+
+esp_err_t ppa_unregister_client(ppa_client_handle_t client)
+{
+    free(client);
+
+    return ESP_OK;
+}
+
+static size_t mock_ppa_srm_bytes(ppa_srm_color_mode_t mode)
+{
+    return mode == PPA_SRM_COLOR_MODE_RGB565 ? 2 : mode == PPA_SRM_COLOR_MODE_RGB888 ? 3 : 4;
+}
+
+// Pixel as 0xRRGGBB
+static uint32_t mock_ppa_get(ppa_srm_color_mode_t mode, const uint8_t *pixel)
+{
+    if (mode == PPA_SRM_COLOR_MODE_RGB565) {
+        uint16_t value = pixel[0] | pixel[1] << 8;
+        return (value & 0xF800) << 8 | (value & 0x07E0) << 5 | (value & 0x001F) << 3;
+    }
+
+    return pixel[2] << 16 | pixel[1] << 8 | pixel[0];
+}
+
+static void mock_ppa_put(ppa_srm_color_mode_t mode, uint32_t color, uint8_t *pixel)
+{
+    if (mode == PPA_SRM_COLOR_MODE_RGB565) {
+        uint16_t value = (color >> 8 & 0xF800) | (color >> 5 & 0x07E0) | (color >> 3 & 0x001F);
+        pixel[0] = value;
+        pixel[1] = value >> 8;
+        return;
+    }
+    pixel[0] = color;
+    pixel[1] = color >> 8;
+    pixel[2] = color >> 16;
+    if (mode == PPA_SRM_COLOR_MODE_ARGB8888) {
+        pixel[3] = 0xFF;
+    }
+}
+
+esp_err_t ppa_do_scale_rotate_mirror(ppa_client_handle_t client, const ppa_srm_oper_config_t *config)
+{
+    if (!client || client->oper_type != PPA_OPERATION_SRM || !config || config->scale_x != 1.0f || config->scale_y != 1.0f) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const ppa_in_pic_blk_config_t *in = &config->in;
+    const ppa_out_pic_blk_config_t *out = &config->out;
+    bool swap = config->rotation_angle == PPA_SRM_ROTATION_ANGLE_90 || config->rotation_angle == PPA_SRM_ROTATION_ANGLE_270;
+    uint32_t out_w = swap ? in->block_h : in->block_w;
+    uint32_t out_h = swap ? in->block_w : in->block_h;
+    size_t in_bytes = mock_ppa_srm_bytes(in->srm_cm);
+    size_t out_bytes = mock_ppa_srm_bytes(out->srm_cm);
+    if (in->block_offset_x + in->block_w > in->pic_w || in->block_offset_y + in->block_h > in->pic_h ||
+            out->block_offset_x + out_w > out->pic_w || out->block_offset_y + out_h > out->pic_h ||
+            (size_t)out->pic_w * out->pic_h * out_bytes > out->buffer_size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // Whole result first, the input and output may be the same picture
+    uint32_t *block = malloc(sizeof(uint32_t) * out_w * out_h);
+    if (!block) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (uint32_t j = 0; j < in->block_h; j++) {
+        for (uint32_t i = 0; i < in->block_w; i++) {
+            const uint8_t *pixel = (const uint8_t *)in->buffer +
+                                   ((in->block_offset_y + j) * in->pic_w + in->block_offset_x + i) * in_bytes;
+            uint32_t x = i;
+            uint32_t y = j;
+            switch (config->rotation_angle) {
+            case PPA_SRM_ROTATION_ANGLE_90:
+                x = j;
+                y = in->block_w - 1 - i;
+                break;
+            case PPA_SRM_ROTATION_ANGLE_180:
+                x = in->block_w - 1 - i;
+                y = in->block_h - 1 - j;
+                break;
+            case PPA_SRM_ROTATION_ANGLE_270:
+                x = in->block_h - 1 - j;
+                y = i;
+                break;
+            default:
+                break;
+            }
+            x = config->mirror_x ? out_w - 1 - x : x;
+            y = config->mirror_y ? out_h - 1 - y : y;
+            block[y * out_w + x] = mock_ppa_get(in->srm_cm, pixel);
+        }
+    }
+    for (uint32_t y = 0; y < out_h; y++) {
+        for (uint32_t x = 0; x < out_w; x++) {
+            uint8_t *pixel = (uint8_t *)out->buffer + ((out->block_offset_y + y) * out->pic_w + out->block_offset_x + x) * out_bytes;
+            mock_ppa_put(out->srm_cm, block[y * out_w + x], pixel);
+        }
+    }
+    free(block);
+    s_srm_ops++;
+
+    return ESP_OK;
+}
+
+static st7701_color_format_t mock_ppa_fb_format(int mode_rgb565, int mode)
+{
+    return mode == mode_rgb565 ? ST7701_COLOR_FORMAT_RGB565 : ST7701_COLOR_FORMAT_RGB888;
+}
+
+esp_err_t ppa_do_fill(ppa_client_handle_t client, const ppa_fill_oper_config_t *config)
+{
+    if (!client || client->oper_type != PPA_OPERATION_FILL || !config) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const st7701_fb_t fb = {
+        .buffer = config->out.buffer,
+        .width = config->out.pic_w,
+        .height = config->out.pic_h,
+        .format = mock_ppa_fb_format(PPA_FILL_COLOR_MODE_RGB565, config->out.fill_cm),
+    };
+
+    return esp_lcd_st7701_fb_fill(&fb, config->out.block_offset_x, config->out.block_offset_y,
+                                  config->out.block_offset_x + config->fill_block_w,
+                                  config->out.block_offset_y + config->fill_block_h, config->fill_argb_color.val & 0xFFFFFF);
+}
+
+esp_err_t ppa_do_blend(ppa_client_handle_t client, const ppa_blend_oper_config_t *config)
+{
+    if (!client || client->oper_type != PPA_OPERATION_BLEND || !config || config->in_bg.buffer != config->out.buffer ||
+            config->in_fg.blend_cm != PPA_BLEND_COLOR_MODE_ARGB8888) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const st7701_fb_t fb = {
+        .buffer = config->out.buffer,
+        .width = config->out.pic_w,
+        .height = config->out.pic_h,
+        .format = mock_ppa_fb_format(PPA_BLEND_COLOR_MODE_RGB565, config->out.blend_cm),
+    };
+
+    return esp_lcd_st7701_fb_blend(&fb, config->out.block_offset_x, config->out.block_offset_y,
+                                   config->out.block_offset_x + config->in_fg.block_w,
+                                   config->out.block_offset_y + config->in_fg.block_h, config->in_fg.buffer);
+}
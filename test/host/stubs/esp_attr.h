@@ -0,0 +1,13 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for the ESP-IDF header of the same name
+
+#pragma once
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
@@ -0,0 +1,26 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for the ESP-IDF header of the same name
+
+#pragma once
+
+#define LCD_CMD_NOP         0x00
+#define LCD_CMD_SWRESET     0x01
+#define LCD_CMD_RDDID       0x04
+#define LCD_CMD_RDDST       0x09
+#define LCD_CMD_RDDPM       0x0A
+#define LCD_CMD_RDDMADCTL   0x0B
+#define LCD_CMD_RDDCOLMOD   0x0C
+#define LCD_CMD_SLPIN       0x10
+#define LCD_CMD_SLPOUT      0x11
+#define LCD_CMD_NORON       0x13
+#define LCD_CMD_INVOFF      0x20
+#define LCD_CMD_INVON       0x21
+#define LCD_CMD_DISPOFF     0x28
+#define LCD_CMD_DISPON      0x29
+#define LCD_CMD_MADCTL      0x36
+#define LCD_CMD_COLMOD      0x3A
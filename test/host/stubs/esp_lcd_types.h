@@ -0,0 +1,29 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for the ESP-IDF header of the same name
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef struct esp_lcd_panel_io_t *esp_lcd_panel_io_handle_t;
+typedef struct esp_lcd_panel_t esp_lcd_panel_t;
+typedef struct esp_lcd_panel_t *esp_lcd_panel_handle_t;
+
+typedef enum {
+    LCD_RGB_ELEMENT_ORDER_RGB,
+    LCD_RGB_ELEMENT_ORDER_BGR,
+} lcd_rgb_element_order_t;
+
+typedef enum {
+    LCD_COLOR_PIXEL_FORMAT_RGB565 = 1,
+    LCD_COLOR_PIXEL_FORMAT_RGB666 = 2,
+    LCD_COLOR_PIXEL_FORMAT_RGB888 = 3,
+} lcd_color_rgb_pixel_format_t;
@@ -0,0 +1,19 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for the ESP-IDF header of the same name: errors and warnings go to stderr, the rest is dropped
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define ESP_LOGE(tag, format, ...) fprintf(stderr, "E %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) fprintf(stderr, "W %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) do { if (0) printf(format, ##__VA_ARGS__); (void)(tag); } while (0)
+#define ESP_LOGD(tag, format, ...) do { if (0) printf(format, ##__VA_ARGS__); (void)(tag); } while (0)
+#define ESP_LOGV(tag, format, ...) do { if (0) printf(format, ##__VA_ARGS__); (void)(tag); } while (0)
+#define ESP_EARLY_LOGE(tag, format, ...) ESP_LOGE(tag, format, ##__VA_ARGS__)
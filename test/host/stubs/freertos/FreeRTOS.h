@@ -0,0 +1,36 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for the FreeRTOS header of the same name, ticks run on the virtual clock of the mocks
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_attr.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define configTICK_RATE_HZ          1000
+#define portTICK_PERIOD_MS          (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)           ((TickType_t)((uint64_t)(ms) * configTICK_RATE_HZ / 1000))
+#define pdTRUE                      1
+#define pdFALSE                     0
+#define pdPASS                      pdTRUE
+
+// Single threaded, the critical sections have nothing to exclude. Their nesting is counted, so the mocks can tell
+// whether a call that would block on the target is made inside one.
+extern int mock_critical_nesting;
+typedef int portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux)     ((void)(mux), mock_critical_nesting++)
+#define portEXIT_CRITICAL(mux)      ((void)(mux), mock_critical_nesting--)
+#define portENTER_CRITICAL_ISR(mux) ((void)(mux), mock_critical_nesting++)
+#define portEXIT_CRITICAL_ISR(mux)  ((void)(mux), mock_critical_nesting--)
@@ -0,0 +1,14 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for the FreeRTOS header of the same name
+
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+void vTaskDelay(const TickType_t ticks_to_delay);
+TickType_t xTaskGetTickCount(void);
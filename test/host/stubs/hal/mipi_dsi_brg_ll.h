@@ -0,0 +1,37 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for the ESP-IDF header of the same name, the registers are plain memory the tests can inspect
+
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t vtotal;
+    uint32_t vdisp;
+    uint32_t vbank;
+    uint32_t vsync;
+    uint32_t config_updates;        // number of times the new timing was latched
+} dsi_brg_dev_t;
+
+extern dsi_brg_dev_t MIPI_DSI_BRIDGE;
+
+#define MIPI_DSI_LL_GET_BRG(bus_id) ((bus_id) == 0 ? &MIPI_DSI_BRIDGE : NULL)
+
+static inline void mipi_dsi_brg_ll_set_vertical_timing(dsi_brg_dev_t *dev, uint32_t vsw, uint32_t vbp, uint32_t active_height,
+                                                       uint32_t vfp)
+{
+    dev->vtotal = vsw + vbp + active_height + vfp;
+    dev->vdisp = active_height;
+    dev->vbank = vbp + vsw;
+    dev->vsync = vsw;
+}
+
+static inline void mipi_dsi_brg_ll_update_dpi_config(dsi_brg_dev_t *dev)
+{
+    dev->config_updates++;
+}
@@ -0,0 +1,31 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for the ESP-IDF header of the same name, the registers are plain memory the tests can inspect
+
+#pragma once
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t vsa;
+    uint32_t vbp;
+    uint32_t v_active;
+    uint32_t vfp;
+} dsi_host_dev_t;
+
+extern dsi_host_dev_t MIPI_DSI_HOST;
+
+#define MIPI_DSI_LL_GET_HOST(bus_id) ((bus_id) == 0 ? &MIPI_DSI_HOST : NULL)
+
+static inline void mipi_dsi_host_ll_dpi_set_vertical_timing(dsi_host_dev_t *dev, uint32_t vsw, uint32_t vbp,
+                                                            uint32_t active_height, uint32_t vfp)
+{
+    dev->vsa = vsw;
+    dev->vbp = vbp;
+    dev->v_active = active_height;
+    dev->vfp = vfp;
+}
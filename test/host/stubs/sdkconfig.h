@@ -0,0 +1,14 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for the generated configuration, the optional features are enabled to have them built and tested
+
+#pragma once
+
+#define CONFIG_ST7701_INIT_TRACE 1
+#define CONFIG_ST7701_INIT_TRACE_DEPTH 64
+#define CONFIG_ST7701_FRAME_STATS 1
+#define CONFIG_ST7701_FRAME_STATS_INTERVAL 1
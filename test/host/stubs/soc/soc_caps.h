@@ -0,0 +1,14 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Host stand-in for the ESP32-P4 capabilities, the build selects whether the PPA is there
+
+#pragma once
+
+#define SOC_MIPI_DSI_SUPPORTED 1
+#ifndef SOC_PPA_SUPPORTED
+#define SOC_PPA_SUPPORTED 0
+#endif
@@ -0,0 +1,178 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Bytecode encoding: the default table survives the round trip, and the panel gets the same DCS stream either way
+
+#include <string.h>
+#include "esp_lcd_panel_commands.h"
+#include "test_common.h"
+#include "esp_lcd_st7701_emu.h"
+#include "esp_lcd_st7701_init_seq.h"
+
+static uint8_t *encode(const st7701_lcd_init_cmd_t *cmds, uint16_t num_cmds, size_t *ret_size)
+{
+    size_t size = 0;
+
+    TEST_ESP_OK(esp_lcd_st7701_bytecode_encode(cmds, num_cmds, NULL, 0, &size));
+    uint8_t *bytecode = malloc(size ? size : 1);
+    TEST_ASSERT(bytecode);
+    TEST_ESP_OK(esp_lcd_st7701_bytecode_encode(cmds, num_cmds, bytecode, size, ret_size));
+    TEST_ASSERT_EQUAL(size, *ret_size);
+    if (size) {
+        TEST_ESP_ERR(ESP_ERR_INVALID_SIZE, esp_lcd_st7701_bytecode_encode(cmds, num_cmds, bytecode, size - 1, &size));
+    }
+
+    return bytecode;
+}
+
+static void check_decodes_to(const uint8_t *bytecode, size_t size, const st7701_lcd_init_cmd_t *cmds, uint16_t num_cmds)
+{
+    st7701_bytecode_reader_t reader;
+    st7701_lcd_init_cmd_t cmd;
+
+    TEST_ESP_OK(esp_lcd_st7701_bytecode_reader_init(&reader, bytecode, size));
+    for (int i = 0; i < num_cmds; i++) {
+        TEST_ESP_OK(esp_lcd_st7701_bytecode_next(&reader, &cmd));
+        TEST_ASSERT_EQUAL(cmds[i].cmd, cmd.cmd);
+        TEST_ASSERT_EQUAL(cmds[i].data_bytes, cmd.data_bytes);
+        TEST_ASSERT(!cmd.data_bytes || !memcmp(cmds[i].data, cmd.data, cmd.data_bytes));
+        TEST_ASSERT_EQUAL(cmds[i].delay_ms, cmd.delay_ms);
+    }
+    TEST_ESP_ERR(ESP_ERR_NOT_FOUND, esp_lcd_st7701_bytecode_next(&reader, &cmd));
+}
+
+static void test_bytecode_default_round_trip(void)
+{
+    const st7701_lcd_init_cmd_t *init_cmds = NULL;
+    uint16_t init_cmds_size = 0;
+    uint16_t num_cmds = 0;
+    size_t size = 0;
+
+    TEST_ESP_OK(esp_lcd_st7701_get_default_init_cmds(&init_cmds, &init_cmds_size));
+    uint8_t *bytecode = encode(init_cmds, init_cmds_size, &size);
+    TEST_ESP_OK(esp_lcd_st7701_bytecode_validate(bytecode, size, &num_cmds));
+    TEST_ASSERT_EQUAL(init_cmds_size, num_cmds);
+    check_decodes_to(bytecode, size, init_cmds, init_cmds_size);
+
+    free(bytecode);
+}
+
+static void test_bytecode_sleep(void)
+{
+    const st7701_lcd_init_cmd_t cmds[] = {
+        {LCD_CMD_SLPOUT, NULL, 0, 127},
+        {LCD_CMD_COLMOD, (uint8_t []){0x77}, 1, 128},
+        {LCD_CMD_MADCTL, (uint8_t []){0x00}, 1, 300},
+        {LCD_CMD_DISPON, NULL, 0, 70000},
+        {LCD_CMD_NOP, NULL, 0, 0},
+    };
+    size_t size = 0;
+
+    uint8_t *bytecode = encode(cmds, sizeof(cmds) / sizeof(cmds[0]), &size);
+    // One byte up to 127, then 7 bits per byte, least significant group first
+    static const uint8_t expected[] = {
+        ST7701_INIT_OP_CMD, LCD_CMD_SLPOUT, 0, ST7701_INIT_OP_SLEEP, 0x7F,
+        ST7701_INIT_OP_CMD, LCD_CMD_COLMOD, 1, 0x77, ST7701_INIT_OP_SLEEP, 0x80, 0x01,
+        ST7701_INIT_OP_CMD, LCD_CMD_MADCTL, 1, 0x00, ST7701_INIT_OP_SLEEP, 0xAC, 0x02,
+        ST7701_INIT_OP_CMD, LCD_CMD_DISPON, 0, ST7701_INIT_OP_SLEEP, 0xF0, 0xA2, 0x04,
+        ST7701_INIT_OP_CMD, LCD_CMD_NOP, 0,
+    };
+    TEST_ASSERT_EQUAL(sizeof(expected), size);
+    TEST_ASSERT(!memcmp(expected, bytecode, size));
+    check_decodes_to(bytecode, size, cmds, sizeof(cmds) / sizeof(cmds[0]));
+    free(bytecode);
+
+    // Consecutive sleeps add up
+    static const uint8_t folded[] = {
+        ST7701_INIT_OP_CMD, LCD_CMD_SLPOUT, 0, ST7701_INIT_OP_SLEEP, 0x78, ST7701_INIT_OP_SLEEP, 0xAC, 0x02,
+    };
+    st7701_bytecode_reader_t reader;
+    st7701_lcd_init_cmd_t cmd;
+    TEST_ESP_OK(esp_lcd_st7701_bytecode_reader_init(&reader, folded, sizeof(folded)));
+    TEST_ESP_OK(esp_lcd_st7701_bytecode_next(&reader, &cmd));
+    TEST_ASSERT_EQUAL(120 + 300, cmd.delay_ms);
+
+    // A varint cut short by the end of the bytecode, and one longer than 32 bits
+    static const uint8_t truncated[] = {ST7701_INIT_OP_CMD, LCD_CMD_SLPOUT, 0, ST7701_INIT_OP_SLEEP, 0xAC};
+    TEST_ESP_ERR(ESP_ERR_INVALID_SIZE, esp_lcd_st7701_bytecode_validate(truncated, sizeof(truncated), NULL));
+    static const uint8_t overlong[] = {ST7701_INIT_OP_CMD, LCD_CMD_SLPOUT, 0, ST7701_INIT_OP_SLEEP, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01};
+    TEST_ESP_ERR(ESP_ERR_INVALID_RESPONSE, esp_lcd_st7701_bytecode_validate(overlong, sizeof(overlong), NULL));
+    // A sleep needs a command to attach to
+    static const uint8_t leading[] = {ST7701_INIT_OP_SLEEP, 0x05, ST7701_INIT_OP_CMD, LCD_CMD_SLPOUT, 0};
+    TEST_ESP_ERR(ESP_ERR_INVALID_RESPONSE, esp_lcd_st7701_bytecode_validate(leading, sizeof(leading), NULL));
+}
+
+static void emu_tx(void *ctx, int64_t time_us, int cmd, const void *param, size_t param_size)
+{
+    TEST_ESP_OK(esp_lcd_st7701_emu_tx_param(ctx, time_us, cmd, param, param_size));
+}
+
+// Initialize a panel on an emulator, return the DCS log
+static size_t init_on_emu(const test_panel_opts_t *opts, st7701_emu_t *emu, mock_tx_t *log)
+{
+    mock_reset();
+    TEST_ESP_OK(esp_lcd_st7701_emu_init(emu, NULL));
+    mock_set_tx_hook(emu_tx, emu);
+    esp_lcd_panel_handle_t panel = test_new_panel(opts);
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+
+    size_t num_tx = mock_num_tx();
+    TEST_ASSERT(num_tx <= MOCK_TX_MAX);
+    for (size_t i = 0; i < num_tx; i++) {
+        log[i] = *mock_get_tx(i);
+    }
+    TEST_ASSERT_EQUAL(0, emu->num_violations);
+
+    return num_tx;
+}
+
+static void test_bytecode_default_on_emu(void)
+{
+    static st7701_emu_t table_emu, bytecode_emu;
+    static mock_tx_t table_log[MOCK_TX_MAX], bytecode_log[MOCK_TX_MAX];
+    const st7701_lcd_init_cmd_t *init_cmds = NULL;
+    uint16_t init_cmds_size = 0;
+    size_t size = 0;
+
+    TEST_ESP_OK(esp_lcd_st7701_get_default_init_cmds(&init_cmds, &init_cmds_size));
+    uint8_t *bytecode = encode(init_cmds, init_cmds_size, &size);
+
+    const test_panel_opts_t table_opts = {
+        .init_cmds = init_cmds,
+        .init_cmds_size = init_cmds_size,
+    };
+    size_t num_tx = init_on_emu(&table_opts, &table_emu, table_log);
+    const test_panel_opts_t bytecode_opts = {
+        .init_bytecode = bytecode,
+        .init_bytecode_size = size,
+    };
+    TEST_ASSERT_EQUAL(num_tx, init_on_emu(&bytecode_opts, &bytecode_emu, bytecode_log));
+
+    // Same commands at the same times, so the delays came through too
+    for (size_t i = 0; i < num_tx; i++) {
+        TEST_ASSERT_EQUAL(table_log[i].cmd, bytecode_log[i].cmd);
+        TEST_ASSERT_EQUAL(table_log[i].time_us, bytecode_log[i].time_us);
+        TEST_ASSERT_EQUAL(table_log[i].param_size, bytecode_log[i].param_size);
+        TEST_ASSERT(!memcmp(table_log[i].param, bytecode_log[i].param, table_log[i].param_size));
+    }
+    TEST_ASSERT_EQUAL(table_emu.num_cmds, bytecode_emu.num_cmds);
+    TEST_ASSERT(!bytecode_emu.sleeping && bytecode_emu.display_on);
+    TEST_ASSERT(!memcmp(table_emu.reg_len, bytecode_emu.reg_len, sizeof(table_emu.reg_len)));
+    TEST_ASSERT(!memcmp(table_emu.reg_val, bytecode_emu.reg_val, sizeof(table_emu.reg_val)));
+
+    free(bytecode);
+}
+
+int main(void)
+{
+    RUN_TEST(test_bytecode_default_round_trip);
+    RUN_TEST(test_bytecode_sleep);
+    RUN_TEST(test_bytecode_default_on_emu);
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Color conversion kernels: known pixels, and throughput in Mpixels/s on the host for a full frame
+
+#include <string.h>
+#include <time.h>
+#include "test_common.h"
+
+#define REPEATS (5)
+
+static const char *format_name(st7701_color_format_t format)
+{
+    switch (format) {
+    case ST7701_COLOR_FORMAT_RGB565:
+        return "RGB565";
+    case ST7701_COLOR_FORMAT_RGB666:
+        return "RGB666";
+    case ST7701_COLOR_FORMAT_ARGB8888:
+        return "ARGB8888";
+    default:
+        return "RGB888";
+    }
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void test_color_pixels(void)
+{
+    // Blue, green, red (, alpha) in memory
+    const uint8_t orange[4] = {0x00, 0x80, 0xFF, 0x40};
+    uint8_t dst[4] = { 0 };
+    st7701_color_conv_config_t config = {
+        .src_format = ST7701_COLOR_FORMAT_ARGB8888,
+        .dst_format = ST7701_COLOR_FORMAT_RGB565,
+        .width = 1,
+        .height = 1,
+    };
+
+    TEST_ESP_OK(esp_lcd_st7701_convert_color(&config, orange, dst));
+    TEST_ASSERT_EQUAL(0xFC00, dst[0] | dst[1] << 8);
+
+    config.dst_format = ST7701_COLOR_FORMAT_RGB666;
+    TEST_ESP_OK(esp_lcd_st7701_convert_color(&config, orange, dst));
+    TEST_ASSERT(dst[0] == 0x00 && dst[1] == 0x80 && dst[2] == 0xFC);
+
+    // Alpha is dropped, the rest is copied
+    config.dst_format = ST7701_COLOR_FORMAT_RGB888;
+    config.dither = ST7701_DITHER_ORDERED;
+    TEST_ESP_OK(esp_lcd_st7701_convert_color(&config, orange, dst));
+    TEST_ASSERT(!memcmp(dst, orange, 3));
+}
+
+static void test_color_throughput(void)
+{
+    static const st7701_color_format_t src_formats[] = {ST7701_COLOR_FORMAT_RGB888, ST7701_COLOR_FORMAT_ARGB8888};
+    static const st7701_color_format_t dst_formats[] = {
+        ST7701_COLOR_FORMAT_RGB565, ST7701_COLOR_FORMAT_RGB666, ST7701_COLOR_FORMAT_RGB888,
+    };
+    const size_t pixels = TEST_H_RES * TEST_V_RES;
+    uint8_t *src = malloc(pixels * 4);
+    uint8_t *dst = malloc(pixels * 3);
+
+    TEST_ASSERT(src && dst);
+    for (size_t i = 0; i < pixels * 4; i++) {
+        src[i] = (uint8_t)(i * 37 + i / 4096);
+    }
+    printf("%-9s %-7s %-8s %10s\n", "from", "to", "dither", "Mpixels/s");
+
+    for (size_t s = 0; s < sizeof(src_formats) / sizeof(src_formats[0]); s++) {
+        for (size_t d = 0; d < sizeof(dst_formats) / sizeof(dst_formats[0]); d++) {
+            for (int dither = ST7701_DITHER_NONE; dither <= ST7701_DITHER_ORDERED; dither++) {
+                const st7701_color_conv_config_t config = {
+                    .src_format = src_formats[s],
+                    .dst_format = dst_formats[d],
+                    .dither = dither,
+                    .width = TEST_H_RES,
+                    .height = TEST_V_RES,
+                };
+                double start_s = now_s();
+
+                for (int i = 0; i < REPEATS; i++) {
+                    TEST_ESP_OK(esp_lcd_st7701_convert_color(&config, src, dst));
+                }
+                double elapsed_s = now_s() - start_s;
+                printf("%-9s %-7s %-8s %10.1f\n", format_name(src_formats[s]), format_name(dst_formats[d]),
+                       dither ? "ordered" : "none", pixels * REPEATS / 1e6 / (elapsed_s > 0 ? elapsed_s : 1e-9));
+            }
+        }
+    }
+
+    free(src);
+    free(dst);
+}
+
+int main(void)
+{
+    RUN_TEST(test_color_pixels);
+    RUN_TEST(test_color_throughput);
+
+    return 0;
+}
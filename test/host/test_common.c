@@ -0,0 +1,94 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "test_common.h"
+
+static const esp_lcd_dpi_panel_config_t s_dpi_config = {
+    .dpi_clk_src = MIPI_DSI_DPI_CLK_SRC_DEFAULT,
+    .dpi_clock_freq_mhz = 30,
+    .virtual_channel = 0,
+    .pixel_format = LCD_COLOR_PIXEL_FORMAT_RGB888,
+    .num_fbs = 1,
+    .video_timing = {
+        .h_size = TEST_H_RES,
+        .v_size = TEST_V_RES,
+        .hsync_back_porch = 50,
+        .hsync_pulse_width = 10,
+        .hsync_front_porch = 50,
+        .vsync_back_porch = 20,
+        .vsync_pulse_width = 2,
+        .vsync_front_porch = 20,
+    },
+};
+
+const esp_lcd_dpi_panel_config_t *test_dpi_config(void)
+{
+    return &s_dpi_config;
+}
+
+esp_lcd_panel_handle_t test_new_panel(const test_panel_opts_t *opts)
+{
+    static const test_panel_opts_t defaults = { 0 };
+    static esp_lcd_dpi_panel_config_t dpi_config;
+
+    if (!opts) {
+        opts = &defaults;
+    }
+    dpi_config = opts->dpi_config ? *opts->dpi_config : s_dpi_config;
+    if (opts->bits_per_pixel == 16) {
+        dpi_config.pixel_format = LCD_COLOR_PIXEL_FORMAT_RGB565;
+    } else if (opts->bits_per_pixel == 18) {
+        dpi_config.pixel_format = LCD_COLOR_PIXEL_FORMAT_RGB666;
+    }
+    st7701_vendor_config_t vendor_config = {
+        .init_cmds = opts->init_cmds,
+        .init_cmds_size = opts->init_cmds_size,
+        .init_bytecode = opts->init_bytecode,
+        .init_bytecode_size = opts->init_bytecode_size,
+        .timing = opts->timing,
+        .mipi_config = {
+            .dsi_bus = mock_dsi_bus(),
+            .dpi_config = &dpi_config,
+            .lane_num = 2,
+            .num_fbs = opts->num_fbs,
+        },
+        .flags = {
+            .poll_ready = opts->poll_ready,
+            .warm_start = opts->warm_start,
+        },
+    };
+    const esp_lcd_panel_dev_config_t panel_config = {
+        .reset_gpio_num = opts->reset_gpio_num ? opts->reset_gpio_num : TEST_RESET_GPIO,
+        .rgb_ele_order = opts->rgb_ele_order,
+        .bits_per_pixel = opts->bits_per_pixel ? opts->bits_per_pixel : 24,
+        .vendor_config = &vendor_config,
+    };
+    esp_lcd_panel_handle_t panel = NULL;
+
+    TEST_ESP_OK(esp_lcd_new_panel_st7701(mock_panel_io(), &panel_config, &panel));
+    TEST_ASSERT(panel);
+
+    return panel;
+}
+
+static void test_sim_tx(void *ctx, int64_t time_us, int cmd, const void *param, size_t param_size)
+{
+    TEST_ESP_OK(esp_lcd_st7701_sim_tx_param(ctx, cmd, param, param_size));
+}
+
+void test_attach_sim(st7701_sim_t *sim)
+{
+    TEST_ESP_OK(esp_lcd_st7701_sim_init(sim, TEST_H_RES, TEST_V_RES));
+    mock_set_tx_hook(test_sim_tx, sim);
+}
+
+void test_render(esp_lcd_panel_handle_t panel, const st7701_sim_t *sim, uint8_t *rgb)
+{
+    st7701_color_format_t format = mock_dpi_get_config(panel)->pixel_format == LCD_COLOR_PIXEL_FORMAT_RGB565 ?
+                                   ST7701_COLOR_FORMAT_RGB565 : ST7701_COLOR_FORMAT_RGB888;
+
+    TEST_ESP_OK(esp_lcd_st7701_sim_render(sim, mock_dpi_front_fb(panel), format, rgb));
+}
@@ -0,0 +1,86 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "esp_lcd_st7701.h"
+#include "esp_lcd_st7701_sim.h"
+#include "mock.h"
+
+#define TEST_H_RES          (480)
+#define TEST_V_RES          (800)
+#define TEST_RESET_GPIO     (5)
+
+#define TEST_ASSERT(cond)                                                                   \
+    do {                                                                                    \
+        if (!(cond)) {                                                                      \
+            fprintf(stderr, "%s:%d: assertion failed: %s\n", __FILE__, __LINE__, #cond);     \
+            exit(1);                                                                        \
+        }                                                                                   \
+    } while (0)
+
+#define TEST_ASSERT_EQUAL(expected, actual)                                                 \
+    do {                                                                                    \
+        long long _e = (long long)(expected);                                               \
+        long long _a = (long long)(actual);                                                 \
+        if (_e != _a) {                                                                     \
+            fprintf(stderr, "%s:%d: %s: expected %lld, got %lld\n", __FILE__, __LINE__,      \
+                    #actual, _e, _a);                                                       \
+            exit(1);                                                                        \
+        }                                                                                   \
+    } while (0)
+
+#define TEST_ESP_OK(expr)               TEST_ASSERT_EQUAL(ESP_OK, (expr))
+#define TEST_ESP_ERR(err, expr)         TEST_ASSERT_EQUAL((err), (expr))
+
+#define RUN_TEST(fn)                                                                        \
+    do {                                                                                    \
+        mock_reset();                                                                       \
+        printf("%s\n", #fn);                                                                \
+        fn();                                                                               \
+    } while (0)
+
+/**
+ * @brief Options of `test_new_panel()`, zero-initialized for the defaults
+ */
+typedef struct {
+    int reset_gpio_num;                 /*!< Reset GPIO, `TEST_RESET_GPIO` if 0, none if negative */
+    int bits_per_pixel;                 /*!< 24 if 0 */
+    lcd_rgb_element_order_t rgb_ele_order;
+    uint8_t num_fbs;
+    const st7701_lcd_init_cmd_t *init_cmds;
+    uint16_t init_cmds_size;
+    const uint8_t *init_bytecode;
+    size_t init_bytecode_size;
+    const st7701_timing_t *timing;
+    bool poll_ready;
+    bool warm_start;
+    const esp_lcd_dpi_panel_config_t *dpi_config;   /*!< `test_dpi_config()` if NULL */
+} test_panel_opts_t;
+
+/**
+ * @brief Get the 480x800 MIPI DPI configuration the test panels are created with
+ */
+const esp_lcd_dpi_panel_config_t *test_dpi_config(void);
+
+/**
+ * @brief Create a panel on the mocked panel IO and MIPI DSI bus
+ */
+esp_lcd_panel_handle_t test_new_panel(const test_panel_opts_t *opts);
+
+/**
+ * @brief Forward everything the driver sends to a simulated panel of the test resolution
+ */
+void test_attach_sim(st7701_sim_t *sim);
+
+/**
+ * @brief Render what the simulated panel shows for the frame buffer the MIPI DPI panel scans out
+ * @param[out] rgb Rendered image, `TEST_H_RES` x `TEST_V_RES` pixels of red, green and blue
+ */
+void test_render(esp_lcd_panel_handle_t panel, const st7701_sim_t *sim, uint8_t *rgb);
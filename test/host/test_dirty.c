@@ -0,0 +1,123 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Dirty-rectangle flushing: bytes copied per frame for typical UI updates, against a full-frame copy
+
+#include <string.h>
+#include "test_common.h"
+
+#define FRAMES          (60)
+#define BYTES_PER_PIXEL (3)
+#define FRAME_BYTES     (TEST_H_RES * TEST_V_RES * BYTES_PER_PIXEL)
+
+typedef struct {
+    const char *name;
+    int num_rects;
+    st7701_rect_t rects[8];
+} workload_t;
+
+static const workload_t s_workloads[] = {
+    {"blinking cursor", 1, {{100, 200, 102, 224}}},
+    {"clock and status icon", 2, {{340, 8, 460, 40}, {8, 8, 32, 32}}},
+    {"scattered widgets", 8, {
+            {20, 100, 60, 140}, {220, 100, 260, 140}, {420, 100, 460, 140}, {20, 400, 60, 440},
+            {420, 400, 460, 440}, {20, 700, 60, 740}, {220, 700, 260, 740}, {420, 700, 460, 740},
+        }
+    },
+    {"scrolling list", 1, {{0, 100, 480, 700}}},
+    {"progress bar, two halves", 2, {{40, 380, 240, 420}, {240, 380, 440, 420}}},
+    {"full redraw", 1, {{0, 0, 480, 800}}},
+};
+
+// Change the pixels of a rectangle of the draw buffer, differently every frame
+static void draw(uint8_t *src, const st7701_rect_t *rect, int frame)
+{
+    for (int y = rect->y_start; y < rect->y_end; y++) {
+        uint8_t *line = src + (y * TEST_H_RES + rect->x_start) * BYTES_PER_PIXEL;
+        for (int i = 0; i < (rect->x_end - rect->x_start) * BYTES_PER_PIXEL; i++) {
+            line[i] = (uint8_t)(frame * 31 + y * 7 + i);
+        }
+    }
+}
+
+static void test_dirty_bytes_per_frame(void)
+{
+    esp_lcd_panel_handle_t panel = test_new_panel(NULL);
+    const st7701_dirty_config_t config = {
+        .width = TEST_H_RES,
+        .height = TEST_V_RES,
+        .bbox_percent = 75,
+    };
+    uint8_t *src = calloc(1, FRAME_BYTES);
+    st7701_dirty_region_t region;
+
+    TEST_ASSERT(src);
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    printf("%-26s %12s %8s %6s\n", "workload", "bytes/frame", "of full", "rects");
+
+    for (size_t w = 0; w < sizeof(s_workloads) / sizeof(s_workloads[0]); w++) {
+        const workload_t *workload = &s_workloads[w];
+        uint64_t total = 0;
+        int num_rects = 0;
+
+        for (int frame = 0; frame < FRAMES; frame++) {
+            size_t copied = 0;
+
+            TEST_ESP_OK(esp_lcd_st7701_dirty_init(&region, &config));
+            for (int i = 0; i < workload->num_rects; i++) {
+                const st7701_rect_t *rect = &workload->rects[i];
+                draw(src, rect, frame);
+                TEST_ESP_OK(esp_lcd_st7701_dirty_add(&region, rect->x_start, rect->y_start, rect->x_end, rect->y_end));
+            }
+            TEST_ESP_OK(esp_lcd_st7701_flush_dirty(panel, src, &region, &copied));
+            TEST_ASSERT_EQUAL(esp_lcd_st7701_dirty_area(&region) * BYTES_PER_PIXEL, copied);
+            total += copied;
+            num_rects = region.num_rects;
+        }
+        // Whatever was drawn made it to the frame buffer, and only the dirty parts were copied
+        TEST_ASSERT(!memcmp(mock_dpi_front_fb(panel), src, FRAME_BYTES));
+        TEST_ASSERT(total <= (uint64_t)FRAME_BYTES * FRAMES);
+
+        printf("%-26s %12" PRIu64 " %7.2f%% %6d\n", workload->name, total / FRAMES,
+               100.0 * total / ((double)FRAME_BYTES * FRAMES), num_rects);
+    }
+    // Adjacent halves are merged into a single copy
+    TEST_ASSERT_EQUAL(1, region.num_rects);
+
+    free(src);
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_dirty_bounding_box(void)
+{
+    const st7701_dirty_config_t config = {
+        .width = TEST_H_RES,
+        .height = TEST_V_RES,
+        .bbox_percent = 75,
+    };
+    st7701_dirty_region_t region;
+
+    // Far apart, copying the bounding box would cost far more than two small copies
+    TEST_ESP_OK(esp_lcd_st7701_dirty_init(&region, &config));
+    TEST_ESP_OK(esp_lcd_st7701_dirty_add(&region, 0, 0, 16, 16));
+    TEST_ESP_OK(esp_lcd_st7701_dirty_add(&region, 464, 784, 480, 800));
+    TEST_ASSERT_EQUAL(2, region.num_rects);
+    TEST_ASSERT_EQUAL(2 * 16 * 16, esp_lcd_st7701_dirty_area(&region));
+
+    // Clipped to the frame buffer
+    TEST_ESP_OK(esp_lcd_st7701_dirty_init(&region, &config));
+    TEST_ESP_OK(esp_lcd_st7701_dirty_add(&region, -10, 790, 10, 810));
+    TEST_ASSERT_EQUAL(10 * 10, esp_lcd_st7701_dirty_area(&region));
+}
+
+int main(void)
+{
+    RUN_TEST(test_dirty_bytes_per_frame);
+    RUN_TEST(test_dirty_bounding_box);
+
+    return 0;
+}
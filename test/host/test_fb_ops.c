@@ -0,0 +1,178 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Frame buffer operations through the driver, with the PPA: overlapping copies and blending against the CPU references
+
+#include <string.h>
+#include "test_common.h"
+
+#define FB_BYTES(bpp)   ((size_t)TEST_H_RES * TEST_V_RES * (bpp))
+
+static esp_lcd_panel_handle_t new_fb_panel(int bits_per_pixel, uint8_t **ret_fb)
+{
+    esp_lcd_panel_handle_t panel = test_new_panel(&(test_panel_opts_t) {
+        .bits_per_pixel = bits_per_pixel,
+    });
+
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    TEST_ESP_OK(esp_lcd_dpi_panel_get_frame_buffer(panel, 1, (void **)ret_fb));
+
+    return panel;
+}
+
+// A different value in every byte of a line, so a line or a column copied from the wrong place shows
+static void fill_pattern(uint8_t *fb, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        fb[i] = (uint8_t)(i * 7 + i / (TEST_H_RES * 3) * 13);
+    }
+}
+
+// What the copy must produce: every destination pixel from the source as it was before the copy
+static void copy_expected(uint8_t *expected, const uint8_t *before, int bpp, int x_start, int y_start, int x_end,
+                          int y_end, int x_dst, int y_dst)
+{
+    size_t stride = (size_t)TEST_H_RES * bpp;
+
+    memcpy(expected, before, FB_BYTES(bpp));
+    for (int y = y_start; y < y_end; y++) {
+        memcpy(&expected[(y - y_start + y_dst) * stride + (size_t)x_dst * bpp], &before[y * stride + (size_t)x_start * bpp],
+               (size_t)(x_end - x_start) * bpp);
+    }
+}
+
+static void test_fb_ops_copy_overlap(void)
+{
+    uint8_t *fb = NULL;
+    esp_lcd_panel_handle_t panel = new_fb_panel(24, &fb);
+    uint8_t *before = malloc(FB_BYTES(3));
+    uint8_t *expected = malloc(FB_BYTES(3));
+    // Source rectangle and destination, each overlapping its source in another direction
+    static const int copies[][6] = {
+        {10, 100, 470, 700, 10, 140},   // down, scrolling the content towards the bottom
+        {10, 100, 470, 700, 10, 60},    // up
+        {40, 100, 400, 200, 60, 100},   // right, on the same lines
+        {40, 100, 400, 200, 20, 100},   // left
+        {40, 100, 400, 200, 45, 103},   // down and right by a few pixels
+        {40, 100, 400, 200, 35, 97},    // up and left
+    };
+
+    TEST_ASSERT(before && expected);
+    for (size_t i = 0; i < sizeof(copies) / sizeof(copies[0]); i++) {
+        const int *c = copies[i];
+
+        fill_pattern(fb, FB_BYTES(3));
+        memcpy(before, fb, FB_BYTES(3));
+        copy_expected(expected, before, 3, c[0], c[1], c[2], c[3], c[4], c[5]);
+        size_t srm_ops = mock_ppa_num_srm();
+        TEST_ESP_OK(esp_lcd_st7701_copy_rect(panel, c[0], c[1], c[2], c[3], c[4], c[5]));
+        // Overlapping rectangles stay on the CPU, whose copy is overlap safe
+        TEST_ASSERT_EQUAL(srm_ops, mock_ppa_num_srm());
+        TEST_ASSERT(!memcmp(expected, fb, FB_BYTES(3)));
+    }
+
+    // Apart, the PPA copies
+    fill_pattern(fb, FB_BYTES(3));
+    memcpy(before, fb, FB_BYTES(3));
+    copy_expected(expected, before, 3, 0, 0, 100, 100, 200, 300);
+    size_t srm_ops = mock_ppa_num_srm();
+    TEST_ESP_OK(esp_lcd_st7701_copy_rect(panel, 0, 0, 100, 100, 200, 300));
+    TEST_ASSERT_EQUAL(srm_ops + 1, mock_ppa_num_srm());
+    TEST_ASSERT(!memcmp(expected, fb, FB_BYTES(3)));
+
+    // Partly outside the frame buffer
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_st7701_copy_rect(panel, 0, 700, 100, 800, 0, 750));
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_st7701_copy_rect(panel, 0, 0, 100, 100, 400, 0));
+
+    free(before);
+    free(expected);
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+// Foreground over background for every alpha at the edges of the rounding, on gray so the byte order doesn't matter
+static void fill_blend_bitmap(uint8_t *argb, int width, int height)
+{
+    static const uint8_t alphas[] = {0, 1, 2, 127, 128, 129, 253, 254, 255};
+
+    for (int i = 0; i < width * height; i++) {
+        uint8_t fg = (uint8_t)(i * 37);
+        argb[i * 4 + 0] = fg;
+        argb[i * 4 + 1] = fg;
+        argb[i * 4 + 2] = fg;
+        argb[i * 4 + 3] = alphas[i % sizeof(alphas)];
+    }
+}
+
+static void test_fb_ops_blend_rounding(void)
+{
+    const int x_start = 13;
+    const int y_start = 21;
+    const int width = 64;
+    const int height = 9;
+    uint8_t argb[64 * 9 * 4];
+    const int bpps[] = {24, 16};
+
+    fill_blend_bitmap(argb, width, height);
+    for (size_t b = 0; b < sizeof(bpps) / sizeof(bpps[0]); b++) {
+        uint8_t *fb = NULL;
+        esp_lcd_panel_handle_t panel = new_fb_panel(bpps[b], &fb);
+        const int bpp = bpps[b] / 8;
+        uint8_t *expected = malloc(FB_BYTES(bpp));
+
+        TEST_ASSERT(expected);
+        fill_pattern(fb, FB_BYTES(bpp));
+        memcpy(expected, fb, FB_BYTES(bpp));
+        const st7701_fb_t reference = {
+            .buffer = expected,
+            .width = TEST_H_RES,
+            .height = TEST_V_RES,
+            .format = bpp == 2 ? ST7701_COLOR_FORMAT_RGB565 : ST7701_COLOR_FORMAT_RGB888,
+        };
+        TEST_ESP_OK(esp_lcd_st7701_fb_blend(&reference, x_start, y_start, x_start + width, y_start + height, argb));
+        TEST_ESP_OK(esp_lcd_st7701_blend_rect(panel, x_start, y_start, x_start + width, y_start + height, argb));
+        TEST_ASSERT(!memcmp(expected, fb, FB_BYTES(bpp)));
+
+        free(expected);
+        TEST_ESP_OK(esp_lcd_panel_del(panel));
+    }
+
+    // The reference itself: (fg * a + bg * (255 - a) + 127) / 255, per component
+    uint8_t *fb = NULL;
+    esp_lcd_panel_handle_t panel = new_fb_panel(24, &fb);
+    static const struct {
+        uint8_t fg, bg, a, out;
+    } cases[] = {
+        {255, 0, 0, 0},
+        {255, 0, 255, 255},
+        {255, 0, 1, 1},         // 255 / 255
+        {1, 0, 127, 0},         // 127 / 255 rounds down
+        {1, 0, 128, 1},         // 128 / 255 rounds up
+        {200, 100, 128, 150},   // (25600 + 12700 + 127) / 255 = 150.69
+        {0, 255, 254, 1},       // 255 / 255
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const uint8_t pixel[4] = {cases[i].fg, cases[i].fg, cases[i].fg, cases[i].a};
+
+        memset(fb, cases[i].bg, 3);
+        TEST_ESP_OK(esp_lcd_st7701_blend_rect(panel, 0, 0, 1, 1, pixel));
+        for (int c = 0; c < 3; c++) {
+            TEST_ASSERT_EQUAL(cases[i].out, fb[c]);
+        }
+    }
+
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_st7701_blend_rect(panel, 0, 0, 1, 1, NULL));
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_st7701_blend_rect(panel, 470, 0, 481, 1, argb));
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+int main(void)
+{
+    RUN_TEST(test_fb_ops_copy_overlap);
+    RUN_TEST(test_fb_ops_blend_rounding);
+
+    return 0;
+}
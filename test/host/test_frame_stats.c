@@ -0,0 +1,168 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Frame pacing statistics: frames, missed deadlines and the submit to scan out latency, on the virtual clock
+
+#include <string.h>
+#include "test_common.h"
+
+static const uint8_t s_pixel[3] = { 0 };
+
+static esp_lcd_panel_handle_t new_started_panel(uint8_t num_fbs)
+{
+    esp_lcd_panel_handle_t panel = test_new_panel(&(test_panel_opts_t) {
+        .num_fbs = num_fbs,
+    });
+
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    TEST_ESP_OK(esp_lcd_st7701_reset_frame_stats(panel));
+
+    return panel;
+}
+
+static void draw(esp_lcd_panel_handle_t panel)
+{
+    TEST_ESP_OK(esp_lcd_panel_draw_bitmap(panel, 0, 0, 1, 1, s_pixel));
+}
+
+static void test_frame_stats_latency(void)
+{
+    esp_lcd_panel_handle_t panel = new_started_panel(1);
+    st7701_frame_stats_t stats;
+
+    // Every draw until the refresh is one frame, its latency counts from the first one
+    draw(panel);
+    mock_advance_us(1000);
+    draw(panel);
+    mock_advance_us(2000);
+    mock_dpi_refresh(panel);
+    TEST_ESP_OK(esp_lcd_st7701_get_frame_stats(panel, &stats));
+    TEST_ASSERT_EQUAL(1, stats.refreshes);
+    TEST_ASSERT_EQUAL(1, stats.frames_submitted);
+    TEST_ASSERT_EQUAL(1, stats.frames_scanned_out);
+    TEST_ASSERT_EQUAL(0, stats.deadlines_missed);
+    TEST_ASSERT_EQUAL(3000, stats.latency_max_us);
+    TEST_ASSERT_EQUAL(3000, stats.latency_sum_us);
+    // 3000 us is in [2048, 4096)
+    TEST_ASSERT_EQUAL(1, stats.latency_hist[2]);
+
+    // Below 1024 us, and the last bucket for anything longer than the others
+    draw(panel);
+    mock_advance_us(500);
+    mock_dpi_refresh(panel);
+    draw(panel);
+    mock_advance_us(2000000);
+    mock_dpi_refresh(panel);
+    TEST_ESP_OK(esp_lcd_st7701_get_frame_stats(panel, &stats));
+    TEST_ASSERT_EQUAL(3, stats.frames_scanned_out);
+    TEST_ASSERT_EQUAL(1, stats.latency_hist[0]);
+    TEST_ASSERT_EQUAL(1, stats.latency_hist[ST7701_FRAME_LATENCY_BUCKETS - 1]);
+    TEST_ASSERT_EQUAL(2000000, stats.latency_max_us);
+    TEST_ASSERT_EQUAL(3000 + 500 + 2000000, stats.latency_sum_us);
+
+    // A refresh without a draw is no frame
+    mock_dpi_refresh(panel);
+    TEST_ESP_OK(esp_lcd_st7701_get_frame_stats(panel, &stats));
+    TEST_ASSERT_EQUAL(4, stats.refreshes);
+    TEST_ASSERT_EQUAL(3, stats.frames_submitted);
+    TEST_ASSERT_EQUAL(3, stats.frames_scanned_out);
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_frame_stats_deadlines(void)
+{
+    esp_lcd_panel_handle_t panel = new_started_panel(1);
+    st7701_frame_stats_t stats;
+
+    // The first frame has no deadline, however many refreshes went by before it
+    mock_dpi_refresh(panel);
+    mock_dpi_refresh(panel);
+    draw(panel);
+    mock_dpi_refresh(panel);
+
+    // On time with a frame every refresh (CONFIG_ST7701_FRAME_STATS_INTERVAL is 1 on the host)
+    for (int i = 0; i < 3; i++) {
+        draw(panel);
+        mock_dpi_refresh(panel);
+    }
+    TEST_ESP_OK(esp_lcd_st7701_get_frame_stats(panel, &stats));
+    TEST_ASSERT_EQUAL(0, stats.deadlines_missed);
+
+    // A refresh showed the previous frame again
+    mock_dpi_refresh(panel);
+    draw(panel);
+    mock_dpi_refresh(panel);
+    TEST_ESP_OK(esp_lcd_st7701_get_frame_stats(panel, &stats));
+    TEST_ASSERT_EQUAL(8, stats.refreshes);
+    TEST_ASSERT_EQUAL(5, stats.frames_scanned_out);
+    TEST_ASSERT_EQUAL(1, stats.deadlines_missed);
+
+    TEST_ESP_OK(esp_lcd_st7701_reset_frame_stats(panel));
+    TEST_ESP_OK(esp_lcd_st7701_get_frame_stats(panel, &stats));
+    TEST_ASSERT_EQUAL(0, stats.refreshes);
+    TEST_ASSERT_EQUAL(0, stats.frames_submitted);
+    TEST_ASSERT_EQUAL(0, stats.deadlines_missed);
+    TEST_ASSERT_EQUAL(0, stats.latency_sum_us);
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_frame_stats_present(void)
+{
+    esp_lcd_panel_handle_t panel = new_started_panel(2);
+    st7701_frame_stats_t stats;
+    void *fb = NULL;
+
+    // A presented frame buffer is a frame, scanned out on the refresh that swaps to it
+    TEST_ESP_OK(esp_lcd_st7701_get_back_buffer(panel, &fb));
+    TEST_ESP_OK(esp_lcd_st7701_present(panel, fb));
+    mock_advance_us(16000);
+    mock_dpi_refresh(panel);
+    TEST_ESP_OK(esp_lcd_st7701_get_frame_stats(panel, &stats));
+    TEST_ASSERT_EQUAL(1, stats.frames_submitted);
+    TEST_ASSERT_EQUAL(1, stats.frames_scanned_out);
+    TEST_ASSERT_EQUAL(16000, stats.latency_max_us);
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_frame_stats_dump(void)
+{
+    esp_lcd_panel_handle_t panel = new_started_panel(1);
+    char text[1024] = { 0 };
+    FILE *stream = tmpfile();
+
+    TEST_ASSERT(stream);
+    draw(panel);
+    mock_advance_us(3000);
+    mock_dpi_refresh(panel);
+    TEST_ESP_OK(esp_lcd_st7701_dump_frame_stats(panel, stream));
+    rewind(stream);
+    TEST_ASSERT(fread(text, 1, sizeof(text) - 1, stream) > 0);
+    fclose(stream);
+    printf("%s", text);
+    TEST_ASSERT(strstr(text, "refreshes 1, frames submitted 1, scanned out 1, deadlines missed 0"));
+    TEST_ASSERT(strstr(text, "avg 3000 us, max 3000 us"));
+    // The only frame makes the full bar
+    TEST_ASSERT(strstr(text, "<    4096 us          1 ########################################\n"));
+
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_st7701_dump_frame_stats(panel, NULL));
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_st7701_get_frame_stats(panel, NULL));
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_st7701_reset_frame_stats(NULL));
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+int main(void)
+{
+    RUN_TEST(test_frame_stats_latency);
+    RUN_TEST(test_frame_stats_deadlines);
+    RUN_TEST(test_frame_stats_present);
+    RUN_TEST(test_frame_stats_dump);
+
+    return 0;
+}
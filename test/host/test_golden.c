@@ -0,0 +1,163 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Golden images: what the simulated panel shows, byte for byte against the PPM files in `golden`, built with the PPA.
+// Every run writes the images it rendered to the working directory; set ST7701_UPDATE_GOLDEN=1 to copy them over
+// the golden ones after a deliberate change, and review the new images before committing them.
+
+#include <string.h>
+#include "test_common.h"
+
+// Small enough to keep the golden files in the repository
+#define W   (48)
+#define H   (64)
+
+static st7701_sim_t s_sim;
+
+static void golden_sim_tx(void *ctx, int64_t time_us, int cmd, const void *param, size_t param_size)
+{
+    TEST_ESP_OK(esp_lcd_st7701_sim_tx_param(ctx, cmd, param, param_size));
+}
+
+static esp_lcd_panel_handle_t new_panel_on_sim(int bits_per_pixel)
+{
+    esp_lcd_dpi_panel_config_t dpi_config = *test_dpi_config();
+    dpi_config.video_timing.h_size = W;
+    dpi_config.video_timing.v_size = H;
+    const test_panel_opts_t opts = {
+        .bits_per_pixel = bits_per_pixel,
+        .dpi_config = &dpi_config,
+    };
+
+    TEST_ESP_OK(esp_lcd_st7701_sim_init(&s_sim, W, H));
+    mock_set_tx_hook(golden_sim_tx, &s_sim);
+    esp_lcd_panel_handle_t panel = test_new_panel(&opts);
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+
+    return panel;
+}
+
+// Draw a whole logical frame: red rising to the right, green rising downwards, a white top-left corner
+static void draw_gradient(esp_lcd_panel_handle_t panel, int width, int height)
+{
+    uint8_t *bitmap = malloc(width * height * 3);
+    TEST_ASSERT(bitmap);
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            uint8_t *pixel = &bitmap[(y * width + x) * 3];
+            bool corner = x < 4 && y < 4;
+            pixel[0] = corner ? 0xFF : 0x40;
+            pixel[1] = corner ? 0xFF : y * 0xFF / (height - 1);
+            pixel[2] = corner ? 0xFF : x * 0xFF / (width - 1);
+        }
+    }
+    TEST_ESP_OK(esp_lcd_panel_draw_bitmap(panel, 0, 0, width, height, bitmap));
+    free(bitmap);
+}
+
+static uint8_t *read_file(const char *path, size_t *ret_size)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    uint8_t *data = malloc(size > 0 ? size : 1);
+    TEST_ASSERT(data);
+    *ret_size = fread(data, 1, size, file);
+    fclose(file);
+
+    return data;
+}
+
+static void write_file(const char *path, const uint8_t *data, size_t size)
+{
+    FILE *file = fopen(path, "wb");
+    TEST_ASSERT(file);
+    TEST_ASSERT_EQUAL(size, fwrite(data, 1, size, file));
+    TEST_ASSERT_EQUAL(0, fclose(file));
+}
+
+static void check_golden(esp_lcd_panel_handle_t panel, const char *name)
+{
+    st7701_color_format_t format = mock_dpi_get_config(panel)->pixel_format == LCD_COLOR_PIXEL_FORMAT_RGB565 ?
+                                   ST7701_COLOR_FORMAT_RGB565 : ST7701_COLOR_FORMAT_RGB888;
+    char path[512];
+    size_t size = 0;
+    size_t golden_size = 0;
+
+    snprintf(path, sizeof(path), "%s.ppm", name);
+    FILE *file = fopen(path, "wb");
+    TEST_ASSERT(file);
+    TEST_ESP_OK(esp_lcd_st7701_sim_write_ppm(&s_sim, mock_dpi_front_fb(panel), format, file));
+    TEST_ASSERT_EQUAL(0, fclose(file));
+    uint8_t *image = read_file(path, &size);
+    TEST_ASSERT(image);
+
+    snprintf(path, sizeof(path), "%s/%s.ppm", TEST_GOLDEN_DIR, name);
+    const char *update = getenv("ST7701_UPDATE_GOLDEN");
+    if (update && !strcmp(update, "1")) {
+        printf("  updating %s\n", path);
+        write_file(path, image, size);
+        free(image);
+        return;
+    }
+    uint8_t *golden = read_file(path, &golden_size);
+    if (!golden || golden_size != size || memcmp(golden, image, size)) {
+        fprintf(stderr, "%s.ppm doesn't match %s\n", name, path);
+        exit(1);
+    }
+    free(golden);
+    free(image);
+}
+
+static void test_golden_default_init(void)
+{
+    esp_lcd_panel_handle_t panel = new_panel_on_sim(24);
+
+    draw_gradient(panel, W, H);
+    check_golden(panel, "default_init");
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_golden_rotation_90(void)
+{
+    esp_lcd_panel_handle_t panel = new_panel_on_sim(24);
+
+    TEST_ESP_OK(esp_lcd_st7701_set_rotation(panel, ST7701_ROTATION_90));
+    draw_gradient(panel, H, W);
+    check_golden(panel, "rotation_90");
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_golden_fill(void)
+{
+    esp_lcd_panel_handle_t panel = new_panel_on_sim(16);
+
+    TEST_ESP_OK(esp_lcd_st7701_fill_rect(panel, 0, 0, W, H, 0x202020));
+    TEST_ESP_OK(esp_lcd_st7701_fill_rect(panel, 4, 4, W / 2, H / 2, 0xFF0000));
+    TEST_ESP_OK(esp_lcd_st7701_fill_rect(panel, W / 2, 8, W - 4, H / 2, 0x00FF00));
+    TEST_ESP_OK(esp_lcd_st7701_fill_rect(panel, 8, H / 2, W - 8, H - 4, 0x0000FF));
+    TEST_ESP_OK(esp_lcd_panel_invert_color(panel, true));
+    check_golden(panel, "fill_inverted");
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+int main(void)
+{
+    RUN_TEST(test_golden_default_init);
+    RUN_TEST(test_golden_rotation_90);
+    RUN_TEST(test_golden_fill);
+
+    return 0;
+}
@@ -0,0 +1,484 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Boot path: esp_lcd_new_panel_st7701() -> reset -> init against the mocked panel IO, on the virtual clock
+
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_lcd_panel_commands.h"
+#include "esp_lcd_st7701_emu.h"
+#include "test_common.h"
+
+// Hardware reset 10 + 20 ms, then the delays of `vendor_specific_init_default`: BK1 D0 100 ms, SLPOUT 120 ms, DISPON 50 ms
+static const uint32_t s_default_delays_ms[] = { 10, 20, 100, 120, 50 };
+#define DEFAULT_DISPON_US   (250 * 1000)
+#define DEFAULT_DONE_US     (300 * 1000)
+
+static void check_default_delays(void)
+{
+    size_t n = 0;
+
+    for (size_t i = 0; i < mock_num_delays(); i++) {
+        const mock_delay_t *delay = mock_get_delay(i);
+        if (!delay->ticks) {
+            continue;
+        }
+        TEST_ASSERT(n < sizeof(s_default_delays_ms) / sizeof(s_default_delays_ms[0]));
+        TEST_ASSERT_EQUAL(s_default_delays_ms[n], delay->ticks * portTICK_PERIOD_MS);
+        n++;
+    }
+    TEST_ASSERT_EQUAL(sizeof(s_default_delays_ms) / sizeof(s_default_delays_ms[0]), n);
+}
+
+static void test_init_default(void)
+{
+    esp_lcd_panel_handle_t panel = test_new_panel(NULL);
+
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+
+    // Reset pulse, active low
+    TEST_ASSERT_EQUAL(2, mock_num_gpio());
+    TEST_ASSERT_EQUAL(TEST_RESET_GPIO, mock_get_gpio(0)->gpio_num);
+    TEST_ASSERT_EQUAL(0, mock_get_gpio(0)->level);
+    TEST_ASSERT_EQUAL(1, mock_get_gpio(1)->level);
+    TEST_ASSERT_EQUAL(10 * 1000, mock_get_gpio(1)->time_us);
+
+    check_default_delays();
+
+    int slpout = mock_find_tx(LCD_CMD_SLPOUT, 0);
+    int dispon = mock_find_tx(LCD_CMD_DISPON, 0);
+    TEST_ASSERT(slpout >= 0 && dispon > slpout);
+    TEST_ASSERT_EQUAL(DEFAULT_DISPON_US, mock_get_tx(dispon)->time_us);
+    TEST_ASSERT_EQUAL(DEFAULT_DONE_US, mock_time_us());
+    printf("boot-to-DISPON %" PRId64 " us, %zu commands\n", mock_get_tx(dispon)->time_us, mock_num_tx());
+
+    // Registers managed by the driver, set before the display is turned on
+    int colmod = mock_find_tx(LCD_CMD_COLMOD, 0);
+    int madctl = mock_find_tx(LCD_CMD_MADCTL, 0);
+    TEST_ASSERT(colmod > slpout && colmod < dispon);
+    TEST_ASSERT(madctl > slpout && madctl < dispon);
+    TEST_ASSERT_EQUAL(0x70, mock_get_tx(colmod)->param[0]);
+    TEST_ASSERT_EQUAL(dispon + 1, mock_num_tx());
+
+    TEST_ASSERT(mock_dpi_started(panel));
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+    TEST_ASSERT_EQUAL(0, mock_dpi_num_panels());
+}
+
+static void test_init_software_reset(void)
+{
+    esp_lcd_panel_handle_t panel = test_new_panel(&(test_panel_opts_t) {
+        .reset_gpio_num = -1,
+    });
+
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+
+    TEST_ASSERT_EQUAL(0, mock_num_gpio());
+    TEST_ASSERT_EQUAL(LCD_CMD_SWRESET, mock_get_tx(0)->cmd);
+    // 20 ms after SWRESET instead of the 30 ms reset pulse
+    TEST_ASSERT_EQUAL(DEFAULT_DISPON_US - 10 * 1000, mock_get_tx(mock_find_tx(LCD_CMD_DISPON, 0))->time_us);
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_init_bus_time(void)
+{
+    esp_lcd_panel_handle_t panel = test_new_panel(NULL);
+
+    // Commands are not free on the bus, their time adds to the table delays
+    mock_set_tx_cost_us(100);
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+
+    int dispon = mock_find_tx(LCD_CMD_DISPON, 0);
+    TEST_ASSERT_EQUAL(DEFAULT_DISPON_US + dispon * 100, mock_get_tx(dispon)->time_us);
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+// What coalescing the init commands into fewer bus transactions could gain at most. Each command is its own DCS packet,
+// so batching can only save per-packet cost: the driver's own, measured here on the host, and the link's, as modeled
+// by esp_lcd_st7701_get_init_budget(). Even if all of it went away, the table delays remain.
+static void test_init_transfer_cost(void)
+{
+    const st7701_lcd_init_cmd_t *cmds = NULL;
+    uint16_t num_cmds = 0;
+    st7701_init_budget_t budget;
+    uint32_t runs = 0;
+    struct timespec start, end;
+    const int repeats = 200;
+    int64_t host_ns = 0;
+    size_t num_tx = 0;
+
+    TEST_ESP_OK(esp_lcd_st7701_get_default_init_cmds(&cmds, &num_cmds));
+    TEST_ESP_OK(esp_lcd_st7701_get_init_budget(cmds, num_cmds, 1000, &budget));
+    // Runs of commands without a delay in between, the most a batch could take
+    for (uint16_t i = 0; i < num_cmds; i++) {
+        runs += !i || cmds[i - 1].delay_ms;
+    }
+
+    for (int i = 0; i < repeats; i++) {
+        mock_reset();
+        esp_lcd_panel_handle_t panel = test_new_panel(NULL);
+        TEST_ESP_OK(esp_lcd_panel_reset(panel));
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        TEST_ESP_OK(esp_lcd_panel_init(panel));
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        host_ns += (end.tv_sec - start.tv_sec) * 1000000000LL + end.tv_nsec - start.tv_nsec;
+        num_tx = mock_num_tx();
+        TEST_ESP_OK(esp_lcd_panel_del(panel));
+    }
+
+    printf("  %"PRIu32" packets in %"PRIu32" zero-delay runs, %"PRIu32" wire bytes\n", budget.num_packets, runs,
+           budget.wire_bytes);
+    printf("  driver on the host: %.2f us per command, %zu commands sent\n", host_ns / 1000.0 / repeats / num_tx, num_tx);
+    printf("  link at 1000 Mbps: %"PRIu32" us LP transfer, %.2f us per packet\n", budget.transfer_us,
+           (double)budget.transfer_us / budget.num_packets);
+    printf("  init %"PRIu32" us, of which delays %"PRIu32" us: batching saves at most %.3f %%\n", budget.total_us,
+           budget.delay_ms * 1000, 100.0 * budget.transfer_us / budget.total_us);
+    TEST_ASSERT(budget.transfer_us * 100 < budget.total_us);
+}
+
+static void test_init_managed_regs_elided(void)
+{
+    const st7701_lcd_init_cmd_t *defaults = NULL;
+    uint16_t num_defaults = 0;
+    st7701_lcd_init_cmd_t cmds[64];
+    static const uint8_t colmod_rgb888[] = {0x70};
+
+    // The default table with COLMOD set by the vendor sequence itself, right before SLPOUT
+    TEST_ESP_OK(esp_lcd_st7701_get_default_init_cmds(&defaults, &num_defaults));
+    TEST_ASSERT(num_defaults < sizeof(cmds) / sizeof(cmds[0]));
+    memcpy(cmds, defaults, (num_defaults - 2) * sizeof(cmds[0]));
+    cmds[num_defaults - 2] = (st7701_lcd_init_cmd_t) {LCD_CMD_COLMOD, colmod_rgb888, 1, 0};
+    memcpy(&cmds[num_defaults - 1], &defaults[num_defaults - 2], 2 * sizeof(cmds[0]));
+    esp_lcd_panel_handle_t panel = test_new_panel(&(test_panel_opts_t) {
+        .init_cmds = cmds,
+        .init_cmds_size = num_defaults + 1,
+    });
+
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+
+    // Only written once, the driver doesn't repeat a value the sequence has set already
+    int colmod = mock_find_tx(LCD_CMD_COLMOD, 0);
+    TEST_ASSERT(colmod >= 0);
+    TEST_ASSERT_EQUAL(-1, mock_find_tx(LCD_CMD_COLMOD, colmod + 1));
+    TEST_ASSERT(mock_find_tx(LCD_CMD_MADCTL, 0) < mock_find_tx(LCD_CMD_DISPON, 0));
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_init_twice_resends_managed_regs(void)
+{
+    esp_lcd_panel_handle_t panel = test_new_panel(NULL);
+
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+
+    // Initializing again without a reset can't rely on what the first run left in the registers
+    size_t first = mock_num_tx();
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    TEST_ASSERT(mock_find_tx(LCD_CMD_MADCTL, first) >= 0);
+    TEST_ASSERT(mock_find_tx(LCD_CMD_COLMOD, first) >= 0);
+    TEST_ASSERT_EQUAL(2 * first, mock_num_tx());
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void emu_tx(void *ctx, int64_t time_us, int cmd, const void *param, size_t param_size)
+{
+    TEST_ESP_OK(esp_lcd_st7701_emu_tx_param(ctx, time_us, cmd, param, param_size));
+}
+
+// Read back the emulated panel's registers like the real one would
+static esp_err_t emu_rx(void *ctx, int cmd, void *param, size_t param_size)
+{
+    const st7701_emu_t *emu = ctx;
+    uint8_t *data = param;
+    uint8_t reg[ST7701_EMU_PARAM_MAX];
+    size_t reg_size = 0;
+
+    memset(param, 0, param_size);
+    switch (cmd) {
+    case LCD_CMD_RDDID:
+        data[0] = 0x88;
+        data[1] = 0x02;
+        data[2] = 0x00;
+        break;
+    case LCD_CMD_RDDMADCTL:
+    case LCD_CMD_RDDCOLMOD:
+        TEST_ESP_OK(esp_lcd_st7701_emu_get_reg(emu, 0x00, cmd == LCD_CMD_RDDMADCTL ? LCD_CMD_MADCTL : LCD_CMD_COLMOD, reg,
+                                               &reg_size));
+        data[0] = reg_size ? reg[0] : 0x00;
+        break;
+    case LCD_CMD_RDDPM:
+        data[0] = (emu->sleeping ? 0x00 : 0x90) | (emu->display_on ? 0x04 : 0x00);
+        break;
+    default:
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    return ESP_OK;
+}
+
+static void test_init_warm_start(void)
+{
+    static st7701_emu_t emu;
+    test_panel_opts_t opts = {
+        .warm_start = true,
+    };
+
+    TEST_ESP_OK(esp_lcd_st7701_emu_init(&emu, NULL));
+    mock_set_tx_hook(emu_tx, &emu);
+    mock_set_rx_hook(emu_rx, &emu);
+
+    // Cold boot: the panel is sleeping, full initialization
+    esp_lcd_panel_handle_t panel = test_new_panel(&opts);
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    TEST_ASSERT_EQUAL(2, mock_num_gpio());
+    TEST_ASSERT_EQUAL(1, mock_nvs_num_commits());
+    TEST_ASSERT_EQUAL(0, emu.num_violations);
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+
+    // Soft restart with the same configuration: no reset, DISPON only
+    size_t num_tx = mock_num_tx();
+    int64_t start_us = mock_time_us();
+    panel = test_new_panel(&opts);
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    TEST_ASSERT_EQUAL(2, mock_num_gpio());
+    TEST_ASSERT_EQUAL(num_tx + 1, mock_num_tx());
+    TEST_ASSERT_EQUAL(LCD_CMD_DISPON, mock_get_tx(num_tx)->cmd);
+    TEST_ASSERT_EQUAL(start_us, mock_time_us());
+    TEST_ASSERT_EQUAL(1, mock_nvs_num_commits());
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+
+    // Soft restart into a different timing, which the readable registers can't tell: full initialization
+    st7701_timing_t timing;
+    TEST_ESP_OK(esp_lcd_st7701_calc_timing(&(st7701_timing_config_t) {
+        .h_res = TEST_H_RES,
+        .v_res = TEST_V_RES,
+        .refresh_hz = 50,
+        .bits_per_pixel = 24,
+    }, &timing));
+    opts.timing = &timing;
+    num_tx = mock_num_tx();
+    panel = test_new_panel(&opts);
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    TEST_ASSERT_EQUAL(4, mock_num_gpio());
+    TEST_ASSERT(mock_find_tx(LCD_CMD_SLPOUT, num_tx) >= 0);
+    TEST_ASSERT_EQUAL(2, mock_nvs_num_commits());
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_init_warm_start_without_nvs(void)
+{
+    static st7701_emu_t emu;
+    test_panel_opts_t opts = {
+        .warm_start = true,
+    };
+
+    // Without NVS there is no checksum to compare with, every start is a cold one
+    mock_nvs_set_initialized(false);
+    TEST_ESP_OK(esp_lcd_st7701_emu_init(&emu, NULL));
+    mock_set_tx_hook(emu_tx, &emu);
+    mock_set_rx_hook(emu_rx, &emu);
+    for (int i = 0; i < 2; i++) {
+        esp_lcd_panel_handle_t panel = test_new_panel(&opts);
+        TEST_ESP_OK(esp_lcd_panel_reset(panel));
+        TEST_ESP_OK(esp_lcd_panel_init(panel));
+        TEST_ESP_OK(esp_lcd_panel_del(panel));
+    }
+    TEST_ASSERT_EQUAL(4, mock_num_gpio());
+}
+
+static void init_done(esp_lcd_panel_handle_t panel, esp_err_t status, void *user_ctx)
+{
+    *(esp_err_t *)user_ctx = status;
+}
+
+static void test_init_async(void)
+{
+    esp_lcd_panel_handle_t panel = test_new_panel(NULL);
+    esp_err_t status = ESP_ERR_NOT_FINISHED;
+
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_st7701_init_async(panel, init_done, &status));
+    // Nothing is sent from the caller's context
+    TEST_ASSERT_EQUAL(0, mock_num_tx());
+    TEST_ESP_ERR(ESP_ERR_INVALID_STATE, esp_lcd_panel_init(panel));
+    // Nor anything that would interleave its commands with the sequence
+    static const uint8_t gamma[ST7701_GAMMA_SIZE] = { 0 };
+    TEST_ESP_ERR(ESP_ERR_INVALID_STATE, esp_lcd_st7701_set_gamma(panel, gamma, gamma));
+    TEST_ESP_ERR(ESP_ERR_INVALID_STATE, esp_lcd_panel_mirror(panel, true, false));
+    TEST_ESP_ERR(ESP_ERR_INVALID_STATE, esp_lcd_panel_invert_color(panel, true));
+    TEST_ESP_ERR(ESP_ERR_INVALID_STATE, esp_lcd_st7701_set_rotation(panel, ST7701_ROTATION_180));
+    TEST_ESP_ERR(ESP_ERR_INVALID_STATE, esp_lcd_st7701_init_async(panel, init_done, &status));
+    TEST_ASSERT_EQUAL(0, mock_num_tx());
+
+    while (mock_run_timer()) {
+    }
+    TEST_ESP_OK(status);
+    TEST_ASSERT(mock_dpi_started(panel));
+    // Same timing as the blocking init, without any task delays
+    TEST_ASSERT_EQUAL(2, mock_num_delays());
+    TEST_ASSERT_EQUAL(DEFAULT_DISPON_US, mock_get_tx(mock_find_tx(LCD_CMD_DISPON, 0))->time_us);
+    TEST_ASSERT_EQUAL(DEFAULT_DONE_US, mock_time_us());
+    // Released once done
+    TEST_ESP_OK(esp_lcd_panel_mirror(panel, false, true));
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+// LNESET of the first command of that kind, in Command2 BK0 in the default sequence
+static int sent_lneset(void)
+{
+    int lneset = mock_find_tx(0xC0, 0);
+
+    TEST_ASSERT(lneset >= 0);
+    TEST_ASSERT_EQUAL(2, mock_get_tx(lneset)->param_size);
+    return mock_get_tx(lneset)->param[0] | (mock_get_tx(lneset)->param[1] << 8);
+}
+
+static void test_init_lneset(void)
+{
+    esp_lcd_dpi_panel_config_t dpi_config = *test_dpi_config();
+
+    // The default sequence is written for 800 lines
+    esp_lcd_panel_handle_t panel = test_new_panel(NULL);
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    TEST_ASSERT_EQUAL(800 / 8 - 1, sent_lneset());
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+
+    // 1024x600 is more than the sources of the ST7701, the lines are still set from the configuration
+    mock_reset();
+    dpi_config = (esp_lcd_dpi_panel_config_t)ST7701_1024_600_PANEL_60HZ_CONFIG(LCD_COLOR_PIXEL_FORMAT_RGB888);
+    panel = test_new_panel(&(test_panel_opts_t) {
+        .dpi_config = &dpi_config,
+    });
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    TEST_ASSERT_EQUAL(600 / 8 - 1, sent_lneset());
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+
+    // Not a multiple of 8, left to the sequence
+    mock_reset();
+    dpi_config = *test_dpi_config();
+    dpi_config.video_timing.v_size = 798;
+    panel = test_new_panel(&(test_panel_opts_t) {
+        .dpi_config = &dpi_config,
+    });
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    TEST_ASSERT_EQUAL(0x63, sent_lneset());
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+
+    // The default table passed in explicitly is still the default sequence
+    const st7701_lcd_init_cmd_t *defaults = NULL;
+    uint16_t num_defaults = 0;
+    TEST_ESP_OK(esp_lcd_st7701_get_default_init_cmds(&defaults, &num_defaults));
+    mock_reset();
+    dpi_config = (esp_lcd_dpi_panel_config_t)ST7701_1024_600_PANEL_60HZ_CONFIG(LCD_COLOR_PIXEL_FORMAT_RGB888);
+    test_panel_opts_t opts = {
+        .init_cmds = defaults,
+        .init_cmds_size = num_defaults,
+        .dpi_config = &dpi_config,
+    };
+    panel = test_new_panel(&opts);
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    TEST_ASSERT_EQUAL(600 / 8 - 1, sent_lneset());
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+
+    // A custom sequence is written for its panel: both parameters as in the table, even for another line count
+    const st7701_lcd_init_cmd_t custom[] = {
+        {0xFF, (uint8_t []){0x77, 0x01, 0x00, 0x00, 0x10}, 5, 0},
+        {0xC0, (uint8_t []){0x77, 0x02}, 2, 0},
+        {0xFF, (uint8_t []){0x77, 0x01, 0x00, 0x00, 0x00}, 5, 0},
+        {LCD_CMD_SLPOUT, NULL, 0, 120},
+        {LCD_CMD_DISPON, NULL, 0, 0},
+    };
+    mock_reset();
+    opts.init_cmds = custom;
+    opts.init_cmds_size = sizeof(custom) / sizeof(custom[0]);
+    panel = test_new_panel(&opts);
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    TEST_ASSERT_EQUAL(0x0277, sent_lneset());
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+
+    // ...unless a timing is given explicitly, which sets LNESET as a whole
+    st7701_timing_t timing;
+    TEST_ESP_OK(esp_lcd_st7701_calc_timing(&(st7701_timing_config_t) {
+        .h_res = TEST_H_RES,
+        .v_res = 480,
+        .refresh_hz = 60,
+        .bits_per_pixel = 24,
+    }, &timing));
+    mock_reset();
+    dpi_config = *test_dpi_config();
+    dpi_config.video_timing.v_size = 480;
+    opts.timing = &timing;
+    panel = test_new_panel(&opts);
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    TEST_ASSERT_EQUAL(timing.lneset[0] | (timing.lneset[1] << 8), sent_lneset());
+    TEST_ASSERT_EQUAL(480 / 8 - 1, timing.lneset[0]);
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_init_default_table_on_emu(void)
+{
+    static st7701_emu_t emu;
+    const st7701_lcd_init_cmd_t *init_cmds = NULL;
+    uint16_t init_cmds_size = 0;
+    uint8_t reg[ST7701_EMU_PARAM_MAX];
+    size_t reg_size = 0;
+
+    TEST_ESP_OK(esp_lcd_st7701_get_default_init_cmds(&init_cmds, &init_cmds_size));
+
+    // After the driver's hardware reset the table reaches SLPOUT at 130 ms, past the 120 ms the reset holds it off
+    TEST_ESP_OK(esp_lcd_st7701_emu_init(&emu, NULL));
+    emu.last_us = 30 * 1000;
+    TEST_ESP_OK(esp_lcd_st7701_emu_run_cmds(&emu, init_cmds, init_cmds_size));
+    TEST_ASSERT_EQUAL(0, emu.num_violations);
+    TEST_ASSERT_EQUAL(init_cmds_size, emu.num_cmds);
+    TEST_ASSERT(!emu.sleeping && emu.display_on);
+    TEST_ESP_OK(esp_lcd_st7701_emu_get_reg(&emu, 0x10, 0xC0, reg, &reg_size));
+    TEST_ASSERT_EQUAL(2, reg_size);
+    TEST_ASSERT(reg[0] == 0x63 && reg[1] == 0x00);
+
+    // Right after the reset edge SLPOUT comes 20 ms early
+    TEST_ESP_OK(esp_lcd_st7701_emu_init(&emu, NULL));
+    TEST_ESP_OK(esp_lcd_st7701_emu_run_cmds(&emu, init_cmds, init_cmds_size));
+    TEST_ASSERT_EQUAL(1, emu.num_violations);
+    TEST_ASSERT_EQUAL(ST7701_EMU_TOO_EARLY, emu.violations[0].type);
+    TEST_ASSERT_EQUAL(LCD_CMD_SLPOUT, emu.violations[0].cmd);
+    TEST_ASSERT_EQUAL(20 * 1000, emu.violations[0].wait_us);
+}
+
+int main(void)
+{
+    RUN_TEST(test_init_default);
+    RUN_TEST(test_init_software_reset);
+    RUN_TEST(test_init_bus_time);
+    RUN_TEST(test_init_transfer_cost);
+    RUN_TEST(test_init_async);
+    RUN_TEST(test_init_managed_regs_elided);
+    RUN_TEST(test_init_twice_resends_managed_regs);
+    RUN_TEST(test_init_warm_start);
+    RUN_TEST(test_init_warm_start_without_nvs);
+    RUN_TEST(test_init_lneset);
+    RUN_TEST(test_init_default_table_on_emu);
+
+    return 0;
+}
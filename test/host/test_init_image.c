@@ -0,0 +1,203 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Initialization images: the header and checksum checks, and the bytecode checks behind them
+
+#include <string.h>
+#include "esp_lcd_panel_commands.h"
+#include "test_common.h"
+#include "esp_lcd_st7701_init_seq.h"
+
+#define IMAGE_MAX   (1024)
+
+// Header and bytecode in one buffer, as they'd be in a partition or file
+static size_t make_image(const uint8_t *bytecode, size_t size, uint8_t *image)
+{
+    TEST_ASSERT(ST7701_INIT_IMAGE_HEADER_SIZE + size <= IMAGE_MAX);
+    TEST_ESP_OK(esp_lcd_st7701_init_image_make_header(bytecode, size, image));
+    memcpy(&image[ST7701_INIT_IMAGE_HEADER_SIZE], bytecode, size);
+
+    return ST7701_INIT_IMAGE_HEADER_SIZE + size;
+}
+
+static esp_err_t parse(const uint8_t *image, size_t size)
+{
+    const uint8_t *bytecode = NULL;
+    size_t bytecode_size = 0;
+
+    return esp_lcd_st7701_init_image_parse(image, size, &bytecode, &bytecode_size);
+}
+
+// Banks are numbered as in the 0xFF (Command2 BKx selection) command: 0x00 is the regular one, 0x10 to 0x13 BK0 to BK3
+static const uint8_t s_bytecode[] = {
+    ST7701_INIT_OP_BANK, 0x10,
+    ST7701_INIT_OP_CMD, 0xC0, 2, 0x63, 0x00,
+    ST7701_INIT_OP_BANK, 0x00,
+    ST7701_INIT_OP_CMD, LCD_CMD_SLPOUT, 0, ST7701_INIT_OP_SLEEP, 0x78,
+    ST7701_INIT_OP_CMD, LCD_CMD_DISPON, 0,
+};
+
+static void test_init_image_valid(void)
+{
+    uint8_t image[IMAGE_MAX];
+    const uint8_t *bytecode = NULL;
+    size_t bytecode_size = 0;
+
+    size_t size = make_image(s_bytecode, sizeof(s_bytecode), image);
+    TEST_ESP_OK(esp_lcd_st7701_init_image_parse(image, size, &bytecode, &bytecode_size));
+    TEST_ASSERT(bytecode == &image[ST7701_INIT_IMAGE_HEADER_SIZE]);
+    TEST_ASSERT_EQUAL(sizeof(s_bytecode), bytecode_size);
+
+    // Trailing bytes after the bytecode are ignored, e.g. the rest of a partition
+    memset(&image[size], 0xFF, 32);
+    TEST_ESP_OK(esp_lcd_st7701_init_image_parse(image, size + 32, &bytecode, &bytecode_size));
+    TEST_ASSERT_EQUAL(sizeof(s_bytecode), bytecode_size);
+
+    // The default table makes a valid image
+    const st7701_lcd_init_cmd_t *init_cmds = NULL;
+    uint16_t init_cmds_size = 0;
+    uint8_t default_bytecode[IMAGE_MAX];
+    TEST_ESP_OK(esp_lcd_st7701_get_default_init_cmds(&init_cmds, &init_cmds_size));
+    TEST_ESP_OK(esp_lcd_st7701_bytecode_encode(init_cmds, init_cmds_size, default_bytecode,
+                                               IMAGE_MAX - ST7701_INIT_IMAGE_HEADER_SIZE, &bytecode_size));
+    size = make_image(default_bytecode, bytecode_size, image);
+    TEST_ESP_OK(parse(image, size));
+
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_st7701_init_image_parse(NULL, size, &bytecode, &bytecode_size));
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_st7701_init_image_parse(image, size, NULL, &bytecode_size));
+}
+
+static void test_init_image_truncated(void)
+{
+    uint8_t image[IMAGE_MAX];
+
+    size_t size = make_image(s_bytecode, sizeof(s_bytecode), image);
+    for (size_t i = 0; i < size; i++) {
+        TEST_ESP_ERR(ESP_ERR_INVALID_SIZE, parse(image, i));
+    }
+
+    // A size field beyond the format's limit
+    image[8] = 0xF1;
+    image[9] = 0xFF;
+    TEST_ESP_ERR(ESP_ERR_INVALID_SIZE, parse(image, size));
+}
+
+static void test_init_image_bad_header(void)
+{
+    uint8_t image[IMAGE_MAX];
+
+    size_t size = make_image(s_bytecode, sizeof(s_bytecode), image);
+    image[0] = '8';
+    TEST_ESP_ERR(ESP_ERR_NOT_FOUND, parse(image, size));
+
+    size = make_image(s_bytecode, sizeof(s_bytecode), image);
+    image[4] = ST7701_INIT_IMAGE_VERSION + 1;
+    TEST_ESP_ERR(ESP_ERR_INVALID_VERSION, parse(image, size));
+}
+
+static void test_init_image_bad_crc(void)
+{
+    uint8_t image[IMAGE_MAX];
+
+    size_t size = make_image(s_bytecode, sizeof(s_bytecode), image);
+    // Any flipped bit in the bytecode or in the stored checksum
+    for (size_t i = ST7701_INIT_IMAGE_HEADER_SIZE - 4; i < size; i++) {
+        for (int bit = 0; bit < 8; bit++) {
+            image[i] ^= 1 << bit;
+            TEST_ESP_ERR(ESP_ERR_INVALID_CRC, parse(image, size));
+            image[i] ^= 1 << bit;
+        }
+    }
+    TEST_ESP_OK(parse(image, size));
+
+    // The standard CRC-32, so images can be made with any tool
+    TEST_ASSERT_EQUAL(0xCBF43926, esp_lcd_st7701_crc32(0, "123456789", 9));
+}
+
+static void test_init_image_bad_bank_select(void)
+{
+    uint8_t image[IMAGE_MAX];
+
+    // 0xFF sent as a plain command with the wrong signature
+    const uint8_t bad_signature[] = {
+        ST7701_INIT_OP_CMD, 0xFF, 5, 0x77, 0x01, 0x00, 0x01, 0x10,
+        ST7701_INIT_OP_BANK, 0x00,
+    };
+    TEST_ESP_ERR(ESP_ERR_INVALID_RESPONSE, parse(image, make_image(bad_signature, sizeof(bad_signature), image)));
+
+    // ...or too short
+    const uint8_t short_select[] = {
+        ST7701_INIT_OP_CMD, 0xFF, 4, 0x77, 0x01, 0x00, 0x00,
+    };
+    TEST_ESP_ERR(ESP_ERR_INVALID_RESPONSE, parse(image, make_image(short_select, sizeof(short_select), image)));
+
+    // A bank the panel doesn't have
+    const uint8_t bad_bank[] = {
+        ST7701_INIT_OP_BANK, 0x14,
+        ST7701_INIT_OP_BANK, 0x00,
+    };
+    TEST_ESP_ERR(ESP_ERR_INVALID_RESPONSE, parse(image, make_image(bad_bank, sizeof(bad_bank), image)));
+
+    // A well-formed 0xFF command is the same as a bank instruction
+    const uint8_t plain_select[] = {
+        ST7701_INIT_OP_CMD, 0xFF, 5, 0x77, 0x01, 0x00, 0x00, 0x11,
+        ST7701_INIT_OP_BANK, 0x00,
+    };
+    TEST_ESP_OK(parse(image, make_image(plain_select, sizeof(plain_select), image)));
+
+    // Left in a Command2 bank, where the driver's DCS commands would land on vendor registers
+    const uint8_t no_return[] = {
+        ST7701_INIT_OP_BANK, 0x10,
+        ST7701_INIT_OP_CMD, 0xC0, 2, 0x63, 0x00,
+    };
+    TEST_ESP_ERR(ESP_ERR_INVALID_STATE, parse(image, make_image(no_return, sizeof(no_return), image)));
+
+    // Unknown opcodes, and a command running past the end
+    const uint8_t bad_opcode[] = {0x04, 0x00};
+    TEST_ESP_ERR(ESP_ERR_INVALID_RESPONSE, parse(image, make_image(bad_opcode, sizeof(bad_opcode), image)));
+    const uint8_t bad_length[] = {ST7701_INIT_OP_CMD, 0xC0, 3, 0x63, 0x00};
+    TEST_ESP_ERR(ESP_ERR_INVALID_SIZE, parse(image, make_image(bad_length, sizeof(bad_length), image)));
+}
+
+static void test_init_image_load_file(void)
+{
+    uint8_t image[IMAGE_MAX];
+    st7701_init_image_t loaded;
+    const char *path = "test_init_image.bin";
+
+    size_t size = make_image(s_bytecode, sizeof(s_bytecode), image);
+    FILE *file = fopen(path, "wb");
+    TEST_ASSERT(file);
+    TEST_ASSERT_EQUAL(size, fwrite(image, 1, size, file));
+    TEST_ASSERT_EQUAL(0, fclose(file));
+    TEST_ESP_OK(esp_lcd_st7701_init_image_load_file(path, &loaded));
+    TEST_ASSERT_EQUAL(sizeof(s_bytecode), loaded.bytecode_size);
+    TEST_ASSERT(!memcmp(s_bytecode, loaded.bytecode, sizeof(s_bytecode)));
+    TEST_ESP_OK(esp_lcd_st7701_init_image_release(&loaded));
+
+    // Shorter than its header says
+    file = fopen(path, "wb");
+    TEST_ASSERT(file);
+    TEST_ASSERT_EQUAL(size - 1, fwrite(image, 1, size - 1, file));
+    TEST_ASSERT_EQUAL(0, fclose(file));
+    TEST_ESP_ERR(ESP_ERR_INVALID_SIZE, esp_lcd_st7701_init_image_load_file(path, &loaded));
+    TEST_ASSERT(!loaded.buffer);
+
+    remove(path);
+    TEST_ESP_ERR(ESP_ERR_NOT_FOUND, esp_lcd_st7701_init_image_load_file(path, &loaded));
+}
+
+int main(void)
+{
+    RUN_TEST(test_init_image_valid);
+    RUN_TEST(test_init_image_truncated);
+    RUN_TEST(test_init_image_bad_header);
+    RUN_TEST(test_init_image_bad_crc);
+    RUN_TEST(test_init_image_bad_bank_select);
+    RUN_TEST(test_init_image_load_file);
+
+    return 0;
+}
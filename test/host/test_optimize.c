@@ -0,0 +1,205 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Init sequence optimizer: redundant bank selections and overwritten register writes, alone and in the driver
+
+#include <string.h>
+#include "esp_lcd_panel_commands.h"
+#include "test_common.h"
+#include "esp_lcd_st7701_init_seq.h"
+
+#define BANK(bank)      {0xFF, (uint8_t []){0x77, 0x01, 0x00, 0x00, (bank)}, 5, 0}
+
+static void test_optimize_bank_selects(void)
+{
+    st7701_lcd_init_cmd_t cmds[] = {
+        BANK(0x10),                             // kept, the bank is unknown at first
+        {0xCC, (uint8_t []){0x38}, 1, 0},
+        BANK(0x10),                             // dropped
+        {0xCD, (uint8_t []){0x08}, 1, 0},
+        {0xFF, (uint8_t []){0x77, 0x01, 0x00, 0x00, 0x10}, 5, 10},     // dropped, its delay moves to 0xCD
+        BANK(0x00),
+        BANK(0x00),                             // dropped
+        {0xFF, (uint8_t []){0x77, 0x01, 0x00}, 3, 0},                  // malformed, kept
+        BANK(0x00),                             // kept, the malformed one left the bank unknown
+    };
+    st7701_init_optimize_stats_t stats;
+
+    TEST_ESP_OK(esp_lcd_st7701_optimize_init_cmds(cmds, 9, cmds, 9, &stats));
+    TEST_ASSERT_EQUAL(9, stats.num_cmds_in);
+    TEST_ASSERT_EQUAL(6, stats.num_cmds_out);
+    TEST_ASSERT_EQUAL(3, stats.bank_selects_dropped);
+    TEST_ASSERT_EQUAL(0, stats.writes_merged);
+    const int expected[] = {0xFF, 0xCC, 0xCD, 0xFF, 0xFF, 0xFF};
+    for (int i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL(expected[i], cmds[i].cmd);
+    }
+    TEST_ASSERT_EQUAL(10, cmds[2].delay_ms);
+    TEST_ASSERT_EQUAL(0x00, ((const uint8_t *)cmds[3].data)[4]);
+    TEST_ASSERT_EQUAL(3, cmds[4].data_bytes);
+
+    // The delay of a dropped selection isn't lost
+    st7701_lcd_init_cmd_t twice[] = {
+        BANK(0x00),
+        {0xFF, (uint8_t []){0x77, 0x01, 0x00, 0x00, 0x00}, 5, 5},
+    };
+    TEST_ESP_OK(esp_lcd_st7701_optimize_init_cmds(twice, 2, twice, 2, &stats));
+    TEST_ASSERT_EQUAL(1, stats.num_cmds_out);
+    TEST_ASSERT_EQUAL(5, twice[0].delay_ms);
+    TEST_ESP_ERR(ESP_ERR_INVALID_SIZE, esp_lcd_st7701_optimize_init_cmds(twice, 2, twice, 1, &stats));
+}
+
+static void test_optimize_last_write_wins(void)
+{
+    const st7701_lcd_init_cmd_t cmds[] = {
+        BANK(0x11),
+        {0xB0, (uint8_t []){0x4D}, 1, 0},       // replaced by the 0x5D below
+        {0xB1, (uint8_t []){0x2D}, 1, 0},
+        {0xB0, (uint8_t []){0x5D}, 1, 0},
+        {0xB2, (uint8_t []){0x07}, 1, 20},      // kept, the delay ends the run
+        {0xB2, (uint8_t []){0x87}, 1, 0},
+        BANK(0x10),
+        {0xB1, (uint8_t []){0x00}, 1, 0},       // BK0, not the BK1 register from before
+        BANK(0x00),
+        {0x2C, (uint8_t []){0x00}, 1, 0},
+        {0x2C, (uint8_t []){0x00}, 1, 0},       // RAMWR appends, both kept
+        {LCD_CMD_NOP, NULL, 0, 0},
+        {LCD_CMD_NOP, NULL, 0, 0},              // actions, both kept
+    };
+    st7701_lcd_init_cmd_t out[sizeof(cmds) / sizeof(cmds[0])];
+    st7701_init_optimize_stats_t stats;
+
+    TEST_ESP_OK(esp_lcd_st7701_optimize_init_cmds(cmds, 13, out, 13, &stats));
+    TEST_ASSERT_EQUAL(12, stats.num_cmds_out);
+    TEST_ASSERT_EQUAL(1, stats.writes_merged);
+    TEST_ASSERT_EQUAL(0xB1, out[1].cmd);
+    TEST_ASSERT_EQUAL(0xB0, out[2].cmd);
+    TEST_ASSERT_EQUAL(0x5D, ((const uint8_t *)out[2].data)[0]);
+    TEST_ASSERT_EQUAL(0x07, ((const uint8_t *)out[3].data)[0]);
+    TEST_ASSERT_EQUAL(20, out[3].delay_ms);
+    TEST_ASSERT_EQUAL(0x87, ((const uint8_t *)out[4].data)[0]);
+}
+
+// A vendor sequence with the redundancy the optimizer removes
+static const st7701_lcd_init_cmd_t s_redundant_cmds[] = {
+    BANK(0x00),
+    BANK(0x00),
+    {LCD_CMD_NORON, NULL, 0, 0},
+    BANK(0x11),
+    {0xB0, (uint8_t []){0x4D}, 1, 0},
+    {0xB0, (uint8_t []){0x5D}, 1, 0},
+    BANK(0x11),
+    {0xB1, (uint8_t []){0x2D}, 1, 0},
+    BANK(0x00),
+    {LCD_CMD_SLPOUT, NULL, 0, 120},
+    {LCD_CMD_DISPON, NULL, 0, 50},
+};
+
+static void check_sent_optimized(esp_lcd_panel_handle_t panel)
+{
+    st7701_init_optimize_stats_t stats;
+
+    TEST_ESP_OK(esp_lcd_st7701_get_init_optimize_stats(panel, &stats));
+    TEST_ASSERT_EQUAL(11, stats.num_cmds_in);
+    TEST_ASSERT_EQUAL(8, stats.num_cmds_out);
+    TEST_ASSERT_EQUAL(2, stats.bank_selects_dropped);
+    TEST_ASSERT_EQUAL(1, stats.writes_merged);
+
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    // The vendor sequence plus MADCTL and COLMOD before DISPON, minus the first selection of the regular bank the reset
+    // left selected
+    TEST_ASSERT_EQUAL(8 - 1 + 2, mock_num_tx());
+    const int expected[] = {LCD_CMD_NORON, 0xFF, 0xB0, 0xB1, 0xFF, LCD_CMD_SLPOUT, LCD_CMD_MADCTL, LCD_CMD_COLMOD,
+                            LCD_CMD_DISPON
+                           };
+    for (int i = 0; i < 9; i++) {
+        TEST_ASSERT_EQUAL(expected[i], mock_get_tx(i)->cmd);
+    }
+    TEST_ASSERT_EQUAL(0x5D, mock_get_tx(2)->param[0]);
+    // The delays are still waited for
+    TEST_ASSERT(mock_get_tx(6)->time_us - mock_get_tx(5)->time_us >= 120 * 1000);
+}
+
+static void test_optimize_in_driver(void)
+{
+    esp_lcd_panel_handle_t panel = test_new_panel(&(test_panel_opts_t) {
+        .init_cmds = s_redundant_cmds,
+        .init_cmds_size = sizeof(s_redundant_cmds) / sizeof(s_redundant_cmds[0]),
+    });
+
+    check_sent_optimized(panel);
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_optimize_bytecode_in_driver(void)
+{
+    uint8_t bytecode[128];
+    size_t size = 0;
+
+    TEST_ESP_OK(esp_lcd_st7701_bytecode_encode(s_redundant_cmds, sizeof(s_redundant_cmds) / sizeof(s_redundant_cmds[0]),
+                                               bytecode, sizeof(bytecode), &size));
+    esp_lcd_panel_handle_t panel = test_new_panel(&(test_panel_opts_t) {
+        .init_bytecode = bytecode,
+        .init_bytecode_size = size,
+    });
+
+    check_sent_optimized(panel);
+    // Bank selections decoded from bytecode carry the full parameters
+    const mock_tx_t *select = mock_get_tx(1);
+    TEST_ASSERT_EQUAL(5, select->param_size);
+    TEST_ASSERT(!memcmp(select->param, (uint8_t []) {
+        0x77, 0x01, 0x00, 0x00, 0x11
+    }, 5));
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+
+    // Invalid bytecode is rejected when the panel is created, not when it is initialized
+    const uint8_t bad_bank[] = {ST7701_INIT_OP_BANK, 0x14};
+    esp_lcd_panel_handle_t bad = NULL;
+    const st7701_vendor_config_t vendor_config = {
+        .init_bytecode = bad_bank,
+        .init_bytecode_size = sizeof(bad_bank),
+        .mipi_config = {
+            .dsi_bus = mock_dsi_bus(),
+            .dpi_config = test_dpi_config(),
+        },
+    };
+    const esp_lcd_panel_dev_config_t panel_config = {
+        .reset_gpio_num = -1,
+        .bits_per_pixel = 24,
+        .vendor_config = (void *) &vendor_config,
+    };
+    TEST_ESP_ERR(ESP_ERR_INVALID_RESPONSE, esp_lcd_new_panel_st7701(mock_panel_io(), &panel_config, &bad));
+    TEST_ASSERT(!bad);
+}
+
+static void test_optimize_default_table(void)
+{
+    const st7701_lcd_init_cmd_t *init_cmds = NULL;
+    uint16_t init_cmds_size = 0;
+    st7701_init_optimize_stats_t stats;
+    esp_lcd_panel_handle_t panel = test_new_panel(NULL);
+
+    // Nothing to remove from the default table
+    TEST_ESP_OK(esp_lcd_st7701_get_default_init_cmds(&init_cmds, &init_cmds_size));
+    TEST_ESP_OK(esp_lcd_st7701_get_init_optimize_stats(panel, &stats));
+    TEST_ASSERT_EQUAL(init_cmds_size, stats.num_cmds_in);
+    TEST_ASSERT_EQUAL(init_cmds_size, stats.num_cmds_out);
+    printf("  default table: %d packets\n", stats.num_cmds_out);
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+int main(void)
+{
+    RUN_TEST(test_optimize_bank_selects);
+    RUN_TEST(test_optimize_last_write_wins);
+    RUN_TEST(test_optimize_in_driver);
+    RUN_TEST(test_optimize_bytecode_in_driver);
+    RUN_TEST(test_optimize_default_table);
+
+    return 0;
+}
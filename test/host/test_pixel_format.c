@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Switching the pixel format at runtime, which creates the MIPI DPI panel again
+
+#include "esp_lcd_panel_commands.h"
+#include "test_common.h"
+
+static esp_lcd_panel_handle_t new_started_panel(void)
+{
+    esp_lcd_panel_handle_t panel = test_new_panel(NULL);
+
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+
+    return panel;
+}
+
+// COLMOD of the last command of that kind sent since `from`
+static int last_colmod(size_t from)
+{
+    int last = -1;
+
+    for (int i = mock_find_tx(LCD_CMD_COLMOD, from); i >= 0; i = mock_find_tx(LCD_CMD_COLMOD, i + 1)) {
+        last = i;
+    }
+    return last < 0 ? -1 : mock_get_tx(last)->param[0];
+}
+
+static void test_pixel_format_switch(void)
+{
+    esp_lcd_panel_handle_t panel = new_started_panel();
+    esp_lcd_panel_handle_t old_panel = panel;
+    size_t num_tx = mock_num_tx();
+
+    TEST_ESP_OK(esp_lcd_st7701_set_pixel_format(&panel, 16));
+    TEST_ASSERT(panel && panel != old_panel);
+    TEST_ASSERT_EQUAL(1, mock_dpi_num_panels());
+    TEST_ASSERT_EQUAL(LCD_COLOR_PIXEL_FORMAT_RGB565, mock_dpi_get_config(panel)->pixel_format);
+    TEST_ASSERT(mock_dpi_started(panel));
+    TEST_ASSERT_EQUAL(0x50, last_colmod(num_tx));
+
+    // Already in that format
+    num_tx = mock_num_tx();
+    old_panel = panel;
+    TEST_ESP_OK(esp_lcd_st7701_set_pixel_format(&panel, 16));
+    TEST_ASSERT(panel == old_panel);
+    TEST_ASSERT_EQUAL(num_tx, mock_num_tx());
+
+    TEST_ESP_ERR(ESP_ERR_NOT_SUPPORTED, esp_lcd_st7701_set_pixel_format(&panel, 12));
+    TEST_ASSERT(panel == old_panel);
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+    TEST_ASSERT_EQUAL(0, mock_dpi_num_panels());
+}
+
+static void test_pixel_format_rollback(void)
+{
+    esp_lcd_panel_handle_t panel = new_started_panel();
+    size_t num_tx = mock_num_tx();
+
+    // The new MIPI DPI panel can't be created, the previous format is restored on both sides
+    mock_dpi_fail_create(1);
+    TEST_ESP_ERR(ESP_ERR_NO_MEM, esp_lcd_st7701_set_pixel_format(&panel, 16));
+    TEST_ASSERT(panel);
+    TEST_ASSERT_EQUAL(1, mock_dpi_num_panels());
+    TEST_ASSERT_EQUAL(LCD_COLOR_PIXEL_FORMAT_RGB888, mock_dpi_get_config(panel)->pixel_format);
+    TEST_ASSERT(mock_dpi_started(panel));
+    TEST_ASSERT_EQUAL(0x70, last_colmod(num_tx));
+
+    // The driver's state is untouched, so switching again works as the first time
+    num_tx = mock_num_tx();
+    TEST_ESP_OK(esp_lcd_st7701_set_pixel_format(&panel, 16));
+    TEST_ASSERT_EQUAL(LCD_COLOR_PIXEL_FORMAT_RGB565, mock_dpi_get_config(panel)->pixel_format);
+    TEST_ASSERT_EQUAL(0x50, last_colmod(num_tx));
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+    TEST_ASSERT_EQUAL(0, mock_dpi_num_panels());
+}
+
+static void test_pixel_format_rollback_fails(void)
+{
+    esp_lcd_panel_handle_t panel = new_started_panel();
+
+    mock_dpi_fail_create(2);
+    TEST_ESP_ERR(ESP_ERR_NO_MEM, esp_lcd_st7701_set_pixel_format(&panel, 16));
+    TEST_ASSERT(!panel);
+    TEST_ASSERT_EQUAL(0, mock_dpi_num_panels());
+}
+
+int main(void)
+{
+    RUN_TEST(test_pixel_format_switch);
+    RUN_TEST(test_pixel_format_rollback);
+    RUN_TEST(test_pixel_format_rollback_fails);
+
+    return 0;
+}
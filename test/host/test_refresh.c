@@ -0,0 +1,178 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Refresh rate scaling through the vertical front porch, with the MIPI DPI panel left in place
+
+#include "hal/mipi_dsi_host_ll.h"
+#include "hal/mipi_dsi_brg_ll.h"
+#include "test_common.h"
+
+#define TEST_VFP        (20)    // vertical front porch of `test_dpi_config()`
+#define TEST_V_LINES    (TEST_V_RES + 2 + 20)
+#define TEST_H_TOTAL    (TEST_H_RES + 10 + 50 + 50)
+
+static esp_lcd_panel_handle_t new_started_panel(void)
+{
+    esp_lcd_panel_handle_t panel = test_new_panel(NULL);
+
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    TEST_ASSERT_EQUAL(TEST_VFP, MIPI_DSI_HOST.vfp);
+
+    return panel;
+}
+
+// The porch sent since `from`, which must be in Command2 BK0 and followed by a return to the regular bank
+static const mock_tx_t *sent_porctrl(size_t from)
+{
+    int porctrl = mock_find_tx(0xC1, from);
+
+    TEST_ASSERT(porctrl > 0);
+    TEST_ASSERT_EQUAL(0xFF, mock_get_tx(porctrl - 1)->cmd);
+    TEST_ASSERT_EQUAL(0x10, mock_get_tx(porctrl - 1)->param[4]);
+    TEST_ASSERT_EQUAL(0xFF, mock_get_tx(porctrl + 1)->cmd);
+    TEST_ASSERT_EQUAL(0x00, mock_get_tx(porctrl + 1)->param[4]);
+    TEST_ASSERT_EQUAL(2, mock_get_tx(porctrl)->param_size);
+    // The transfers block, none may run under the swap lock
+    for (int i = porctrl - 1; i <= porctrl + 1; i++) {
+        TEST_ASSERT(!mock_get_tx(i)->in_critical);
+    }
+    return mock_get_tx(porctrl);
+}
+
+static void check_vfp(uint32_t vfp)
+{
+    TEST_ASSERT_EQUAL(vfp, MIPI_DSI_HOST.vfp);
+    TEST_ASSERT_EQUAL(TEST_V_RES, MIPI_DSI_HOST.v_active);
+    TEST_ASSERT_EQUAL(TEST_V_LINES + vfp, MIPI_DSI_BRIDGE.vtotal);
+}
+
+static void test_refresh_scaling_in_place(void)
+{
+    esp_lcd_panel_handle_t panel = new_started_panel();
+    const st7701_refresh_scaling_config_t config = {
+        .idle_ms = 100,
+        .low_refresh_hz = 30,
+    };
+    // 30 MHz / (590 * 30 Hz) = 1694 lines
+    const uint32_t low_vfp = 30000000 / (TEST_H_TOTAL * 30) - TEST_V_LINES;
+    uint8_t bitmap[3] = { 0 };
+    st7701_refresh_stats_t stats;
+
+    TEST_ESP_OK(esp_lcd_st7701_set_refresh_scaling(panel, &config));
+    TEST_ESP_OK(esp_lcd_st7701_refresh_scaling_update(panel));
+    check_vfp(TEST_VFP);
+
+    // Idle: the front porch grows on the host and, as far as it goes, on the panel
+    size_t num_tx = mock_num_tx();
+    uint32_t updates = MIPI_DSI_BRIDGE.config_updates;
+    mock_advance_us(100 * 1000);
+    TEST_ESP_OK(esp_lcd_st7701_refresh_scaling_update(panel));
+    check_vfp(low_vfp);
+    TEST_ASSERT_EQUAL(updates + 1, MIPI_DSI_BRIDGE.config_updates);
+    const mock_tx_t *porctrl = sent_porctrl(num_tx);
+    TEST_ASSERT_EQUAL(0x10, porctrl->param[0]);
+    TEST_ASSERT_EQUAL(0xFF, porctrl->param[1]);
+    TEST_ASSERT_EQUAL(num_tx + 3, mock_num_tx());
+    TEST_ASSERT_EQUAL(1, mock_dpi_num_panels());
+    TEST_ASSERT(mock_dpi_started(panel));
+
+    // Drawing brings back the configured rate and the porch of the initialization sequence
+    num_tx = mock_num_tx();
+    TEST_ESP_OK(esp_lcd_panel_draw_bitmap(panel, 0, 0, 1, 1, bitmap));
+    TEST_ESP_OK(esp_lcd_st7701_refresh_scaling_update(panel));
+    check_vfp(TEST_VFP);
+    porctrl = sent_porctrl(num_tx);
+    TEST_ASSERT_EQUAL(0x10, porctrl->param[0]);
+    TEST_ASSERT_EQUAL(0x02, porctrl->param[1]);
+
+    TEST_ESP_OK(esp_lcd_st7701_get_refresh_stats(panel, &stats));
+    TEST_ASSERT(!stats.low);
+    TEST_ASSERT_EQUAL(2, stats.switches);
+    TEST_ASSERT_EQUAL(100 * 1000, stats.high_us);
+
+    TEST_ESP_OK(esp_lcd_st7701_set_refresh_scaling(panel, NULL));
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_refresh_scaling_limits(void)
+{
+    esp_lcd_panel_handle_t panel = new_started_panel();
+
+    // Not below the configured 60 Hz
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_st7701_set_refresh_scaling(panel, &(st7701_refresh_scaling_config_t) {
+        .idle_ms = 100,
+        .low_refresh_hz = 61,
+    }));
+
+    // As low as the front porch of the host goes
+    TEST_ESP_OK(esp_lcd_st7701_set_refresh_scaling(panel, &(st7701_refresh_scaling_config_t) {
+        .idle_ms = 100,
+        .low_refresh_hz = 10,
+    }));
+    mock_advance_us(100 * 1000);
+    TEST_ESP_OK(esp_lcd_st7701_refresh_scaling_update(panel));
+    check_vfp(1023);
+
+    TEST_ESP_OK(esp_lcd_st7701_set_refresh_scaling(panel, NULL));
+    check_vfp(TEST_VFP);
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_refresh_scaling_pixel_format(void)
+{
+    esp_lcd_panel_handle_t panel = new_started_panel();
+
+    TEST_ESP_OK(esp_lcd_st7701_set_refresh_scaling(panel, &(st7701_refresh_scaling_config_t) {
+        .idle_ms = 100,
+        .low_refresh_hz = 30,
+    }));
+    mock_advance_us(100 * 1000);
+    TEST_ESP_OK(esp_lcd_st7701_refresh_scaling_update(panel));
+    TEST_ASSERT(MIPI_DSI_HOST.vfp > TEST_VFP);
+
+    // The new MIPI DPI panel starts at the configured rate, so does the panel
+    size_t num_tx = mock_num_tx();
+    TEST_ESP_OK(esp_lcd_st7701_set_pixel_format(&panel, 16));
+    check_vfp(TEST_VFP);
+    TEST_ASSERT_EQUAL(0x02, sent_porctrl(num_tx)->param[1]);
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_refresh_scaling_bus_id(void)
+{
+    st7701_vendor_config_t vendor_config = {
+        .mipi_config = {
+            .dsi_bus = mock_dsi_bus(),
+            .dsi_bus_id = 1,
+            .dpi_config = test_dpi_config(),
+        },
+    };
+    const esp_lcd_panel_dev_config_t panel_config = {
+        .reset_gpio_num = -1,
+        .bits_per_pixel = 24,
+        .vendor_config = &vendor_config,
+    };
+    esp_lcd_panel_handle_t panel = NULL;
+
+    // The host has a single MIPI DSI bus, whose registers the refresh rate scaling changes
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_new_panel_st7701(mock_panel_io(), &panel_config, &panel));
+    TEST_ASSERT(!panel);
+    vendor_config.mipi_config.dsi_bus_id = -1;
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_new_panel_st7701(mock_panel_io(), &panel_config, &panel));
+    TEST_ASSERT(!panel);
+}
+
+int main(void)
+{
+    RUN_TEST(test_refresh_scaling_in_place);
+    RUN_TEST(test_refresh_scaling_limits);
+    RUN_TEST(test_refresh_scaling_pixel_format);
+    RUN_TEST(test_refresh_scaling_bus_id);
+
+    return 0;
+}
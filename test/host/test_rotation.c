@@ -0,0 +1,144 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Mirroring and rotation as they show up on the glass of the simulated panel, built with the PPA
+
+#include "esp_lcd_panel_commands.h"
+#include "test_common.h"
+
+#define W   TEST_H_RES
+#define H   TEST_V_RES
+
+static st7701_sim_t s_sim;
+static uint8_t s_glass[W * H * 3];
+
+static esp_lcd_panel_handle_t new_panel_on_sim(void)
+{
+    test_attach_sim(&s_sim);
+    esp_lcd_panel_handle_t panel = test_new_panel(NULL);
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+
+    return panel;
+}
+
+// Draw a whole logical frame, black with a red top-left and a green top-right corner
+static void draw_corners(esp_lcd_panel_handle_t panel, int width, int height)
+{
+    uint8_t *bitmap = calloc(width * height, 3);
+    TEST_ASSERT(bitmap);
+
+    bitmap[2] = 0xFF;
+    bitmap[(width - 1) * 3 + 1] = 0xFF;
+    TEST_ESP_OK(esp_lcd_panel_draw_bitmap(panel, 0, 0, width, height, bitmap));
+    free(bitmap);
+}
+
+static void check_glass(int x, int y, uint8_t r, uint8_t g, uint8_t b)
+{
+    const uint8_t *pixel = &s_glass[(y * W + x) * 3];
+
+    if (pixel[0] != r || pixel[1] != g || pixel[2] != b) {
+        fprintf(stderr, "glass (%d, %d): expected %02X%02X%02X, got %02X%02X%02X\n", x, y, r, g, b, pixel[0], pixel[1],
+                pixel[2]);
+        exit(1);
+    }
+}
+
+static void test_mirror_x_reverses_sources(void)
+{
+    esp_lcd_panel_handle_t panel = new_panel_on_sim();
+    size_t num_tx = mock_num_tx();
+
+    TEST_ESP_OK(esp_lcd_panel_mirror(panel, true, false));
+    int sdir = mock_find_tx(0xC7, num_tx);
+    TEST_ASSERT(sdir >= 0);
+    TEST_ASSERT_EQUAL(0x04, mock_get_tx(sdir)->param[0] & 0x04);
+    TEST_ASSERT_EQUAL(0x00, s_sim.madctl & 0x10);
+
+    draw_corners(panel, W, H);
+    test_render(panel, &s_sim, s_glass);
+    check_glass(W - 1, 0, 0xFF, 0x00, 0x00);
+    check_glass(0, 0, 0x00, 0xFF, 0x00);
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_mirror_y_reverses_lines(void)
+{
+    esp_lcd_panel_handle_t panel = new_panel_on_sim();
+
+    TEST_ESP_OK(esp_lcd_panel_mirror(panel, false, true));
+    TEST_ASSERT_EQUAL(0x10, s_sim.madctl & 0x10);
+    TEST_ASSERT_EQUAL(0x00, s_sim.sdir & 0x04);
+
+    draw_corners(panel, W, H);
+    test_render(panel, &s_sim, s_glass);
+    check_glass(0, H - 1, 0xFF, 0x00, 0x00);
+    check_glass(W - 1, H - 1, 0x00, 0xFF, 0x00);
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_mirror_failed_keeps_config(void)
+{
+    esp_lcd_panel_handle_t panel = new_panel_on_sim();
+
+    // MADCTL goes through, SDIR doesn't: neither is taken as the configuration to restore
+    mock_fail_tx(0xC7, 1);
+    TEST_ESP_ERR(ESP_ERR_TIMEOUT, esp_lcd_panel_mirror(panel, true, true));
+    TEST_ASSERT_EQUAL(0x10, s_sim.madctl & 0x10);
+
+    size_t num_tx = mock_num_tx();
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    int madctl = mock_find_tx(LCD_CMD_MADCTL, num_tx);
+    TEST_ASSERT(madctl >= 0);
+    TEST_ASSERT_EQUAL(0x00, mock_get_tx(madctl)->param[0] & 0x10);
+    TEST_ASSERT_EQUAL(-1, mock_find_tx(0xC7, num_tx));
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_rotation_clockwise(void)
+{
+    // Where the logical top-left and top-right corners land on the glass when rotating clockwise
+    static const struct {
+        st7701_rotation_t rotation;
+        int red_x, red_y;
+        int green_x, green_y;
+    } cases[] = {
+        {ST7701_ROTATION_0, 0, 0, W - 1, 0},
+        {ST7701_ROTATION_90, W - 1, 0, W - 1, H - 1},
+        {ST7701_ROTATION_180, W - 1, H - 1, 0, H - 1},
+        {ST7701_ROTATION_270, 0, H - 1, 0, 0},
+    };
+    esp_lcd_panel_handle_t panel = new_panel_on_sim();
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        bool swapped = cases[i].rotation == ST7701_ROTATION_90 || cases[i].rotation == ST7701_ROTATION_270;
+        size_t num_srm = mock_ppa_num_srm();
+
+        printf("  %d degrees\n", cases[i].rotation * 90);
+        TEST_ESP_OK(esp_lcd_st7701_set_rotation(panel, cases[i].rotation));
+        draw_corners(panel, swapped ? H : W, swapped ? W : H);
+        TEST_ASSERT_EQUAL(swapped, mock_ppa_num_srm() - num_srm);
+        test_render(panel, &s_sim, s_glass);
+        check_glass(cases[i].red_x, cases[i].red_y, 0xFF, 0x00, 0x00);
+        check_glass(cases[i].green_x, cases[i].green_y, 0x00, 0xFF, 0x00);
+    }
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+int main(void)
+{
+    RUN_TEST(test_mirror_x_reverses_sources);
+    RUN_TEST(test_mirror_y_reverses_lines);
+    RUN_TEST(test_mirror_failed_keeps_config);
+    RUN_TEST(test_rotation_clockwise);
+
+    return 0;
+}
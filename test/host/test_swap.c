@@ -0,0 +1,154 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Frame buffer swapping: which buffer is scanned out, which one is pending, and the dropped and late frames
+
+#include "test_common.h"
+
+static esp_lcd_panel_handle_t new_swap_panel(uint8_t num_fbs, void **fbs)
+{
+    esp_lcd_panel_handle_t panel = test_new_panel(&(test_panel_opts_t) {
+        .num_fbs = num_fbs,
+    });
+
+    TEST_ESP_OK(esp_lcd_panel_reset(panel));
+    TEST_ESP_OK(esp_lcd_panel_init(panel));
+    TEST_ESP_OK(esp_lcd_dpi_panel_get_frame_buffer(panel, num_fbs, &fbs[0], &fbs[1], &fbs[2]));
+
+    return panel;
+}
+
+static void check_swap_stats(esp_lcd_panel_handle_t panel, uint32_t presented, uint32_t shown, uint32_t dropped,
+                             uint32_t late)
+{
+    st7701_swap_stats_t stats;
+
+    TEST_ESP_OK(esp_lcd_st7701_get_swap_stats(panel, &stats));
+    TEST_ASSERT_EQUAL(presented, stats.frames_presented);
+    TEST_ASSERT_EQUAL(shown, stats.frames_shown);
+    TEST_ASSERT_EQUAL(dropped, stats.frames_dropped);
+    TEST_ASSERT_EQUAL(late, stats.frames_late);
+}
+
+static void test_swap_double(void)
+{
+    void *fbs[3] = { 0 };
+    esp_lcd_panel_handle_t panel = new_swap_panel(2, fbs);
+    void *fb = NULL;
+
+    // The first frame buffer is scanned out from the start
+    TEST_ASSERT(mock_dpi_front_fb(panel) == fbs[0]);
+    TEST_ESP_OK(esp_lcd_st7701_get_back_buffer(panel, &fb));
+    TEST_ASSERT(fb == fbs[1]);
+    TEST_ESP_ERR(ESP_ERR_INVALID_STATE, esp_lcd_st7701_present(panel, fbs[0]));
+
+    // Until the next refresh the presented buffer is pending and the other one is still scanned out: none is free
+    TEST_ESP_OK(esp_lcd_st7701_present(panel, fb));
+    TEST_ASSERT(mock_dpi_front_fb(panel) == fbs[0]);
+    TEST_ESP_ERR(ESP_ERR_NOT_FINISHED, esp_lcd_st7701_get_back_buffer(panel, &fb));
+    check_swap_stats(panel, 1, 0, 0, 0);
+
+    mock_dpi_refresh(panel);
+    TEST_ASSERT(mock_dpi_front_fb(panel) == fbs[1]);
+    TEST_ESP_ERR(ESP_ERR_INVALID_STATE, esp_lcd_st7701_present(panel, fbs[1]));
+    TEST_ESP_OK(esp_lcd_st7701_get_back_buffer(panel, &fb));
+    TEST_ASSERT(fb == fbs[0]);
+    check_swap_stats(panel, 1, 1, 0, 0);
+
+    // A frame every refresh is on time
+    for (int i = 0; i < 4; i++) {
+        TEST_ESP_OK(esp_lcd_st7701_get_back_buffer(panel, &fb));
+        TEST_ESP_OK(esp_lcd_st7701_present(panel, fb));
+        mock_dpi_refresh(panel);
+        TEST_ASSERT(mock_dpi_front_fb(panel) == fb);
+    }
+    check_swap_stats(panel, 5, 5, 0, 0);
+
+    // Not a frame buffer of the panel
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_st7701_present(panel, &fb));
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_swap_triple_dropped(void)
+{
+    void *fbs[3] = { 0 };
+    esp_lcd_panel_handle_t panel = new_swap_panel(3, fbs);
+    void *first = NULL;
+    void *second = NULL;
+    void *fb = NULL;
+
+    // A back buffer is always free, presenting twice before a refresh replaces the pending frame
+    TEST_ESP_OK(esp_lcd_st7701_get_back_buffer(panel, &first));
+    TEST_ESP_OK(esp_lcd_st7701_present(panel, first));
+    TEST_ESP_OK(esp_lcd_st7701_get_back_buffer(panel, &second));
+    TEST_ASSERT(second != first && second != fbs[0]);
+    TEST_ESP_OK(esp_lcd_st7701_present(panel, second));
+    check_swap_stats(panel, 2, 0, 1, 0);
+
+    // The dropped buffer is free again
+    TEST_ESP_OK(esp_lcd_st7701_get_back_buffer(panel, &fb));
+    TEST_ASSERT(fb == first);
+
+    mock_dpi_refresh(panel);
+    TEST_ASSERT(mock_dpi_front_fb(panel) == second);
+    check_swap_stats(panel, 2, 1, 1, 0);
+
+    // Presenting the pending buffer again isn't a drop
+    TEST_ESP_OK(esp_lcd_st7701_present(panel, first));
+    TEST_ESP_OK(esp_lcd_st7701_present(panel, first));
+    check_swap_stats(panel, 4, 1, 1, 0);
+
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_swap_late(void)
+{
+    void *fbs[3] = { 0 };
+    esp_lcd_panel_handle_t panel = new_swap_panel(2, fbs);
+    void *fb = NULL;
+    st7701_swap_stats_t stats;
+
+    // The first frame isn't late however long it took
+    mock_dpi_refresh(panel);
+    mock_dpi_refresh(panel);
+    TEST_ESP_OK(esp_lcd_st7701_get_back_buffer(panel, &fb));
+    TEST_ESP_OK(esp_lcd_st7701_present(panel, fb));
+    mock_dpi_refresh(panel);
+    check_swap_stats(panel, 1, 1, 0, 0);
+
+    // A refresh went by showing the previous frame again
+    mock_dpi_refresh(panel);
+    TEST_ESP_OK(esp_lcd_st7701_get_back_buffer(panel, &fb));
+    TEST_ESP_OK(esp_lcd_st7701_present(panel, fb));
+    mock_dpi_refresh(panel);
+    check_swap_stats(panel, 2, 2, 0, 1);
+
+    TEST_ESP_OK(esp_lcd_st7701_get_swap_stats(panel, &stats));
+    TEST_ASSERT_EQUAL(5, stats.refreshes);
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+static void test_swap_single_buffer(void)
+{
+    esp_lcd_panel_handle_t panel = test_new_panel(NULL);
+    void *fb = NULL;
+
+    TEST_ESP_ERR(ESP_ERR_INVALID_STATE, esp_lcd_st7701_get_back_buffer(panel, &fb));
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_st7701_get_back_buffer(panel, NULL));
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_st7701_get_swap_stats(panel, NULL));
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+int main(void)
+{
+    RUN_TEST(test_swap_double);
+    RUN_TEST(test_swap_triple_dropped);
+    RUN_TEST(test_swap_late);
+    RUN_TEST(test_swap_single_buffer);
+
+    return 0;
+}
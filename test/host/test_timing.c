@@ -0,0 +1,89 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Nicolai Electronics
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// MIPI-DSI lane bit rate: filled in from the video stream or checked against it
+
+#include "test_common.h"
+
+static void test_lane_bit_rate_filled_in(void)
+{
+    esp_lcd_dsi_bus_config_t bus_config = ST7701_PANEL_BUS_DSI_2CH_CONFIG();
+    uint32_t min_mbps = 0;
+    uint32_t headroom_mbps = 0;
+
+    TEST_ESP_OK(esp_lcd_st7701_get_lane_bit_rate(test_dpi_config(), 2, 0, &min_mbps));
+    TEST_ESP_OK(esp_lcd_st7701_get_lane_bit_rate(test_dpi_config(), 2, 20, &headroom_mbps));
+    TEST_ASSERT(min_mbps < headroom_mbps && headroom_mbps < 1000);
+
+    // The default rate is kept, the computed one is opt-in
+    TEST_ASSERT_EQUAL(1000, bus_config.lane_bit_rate_mbps);
+    TEST_ESP_OK(esp_lcd_st7701_set_lane_bit_rate(&bus_config, test_dpi_config(), 20));
+    TEST_ASSERT_EQUAL(1000, bus_config.lane_bit_rate_mbps);
+    bus_config.lane_bit_rate_mbps = 0;
+    TEST_ESP_OK(esp_lcd_st7701_set_lane_bit_rate(&bus_config, test_dpi_config(), 20));
+    TEST_ASSERT_EQUAL(headroom_mbps, bus_config.lane_bit_rate_mbps);
+    printf("480x800 RGB888 over 2 lanes: %" PRIu32 " Mbps, %" PRIu32 " Mbps with 20%% headroom\n", min_mbps,
+           headroom_mbps);
+
+    // One lane carries the whole stream
+    bus_config = (esp_lcd_dsi_bus_config_t)ST7701_PANEL_BUS_DSI_2CH_CONFIG();
+    bus_config.num_data_lanes = 1;
+    bus_config.lane_bit_rate_mbps = 0;
+    TEST_ESP_OK(esp_lcd_st7701_set_lane_bit_rate(&bus_config, test_dpi_config(), 0));
+    TEST_ASSERT(bus_config.lane_bit_rate_mbps > min_mbps);
+}
+
+static void test_lane_bit_rate_checked(void)
+{
+    esp_lcd_dsi_bus_config_t bus_config = ST7701_PANEL_BUS_DSI_2CH_CONFIG();
+    uint32_t min_mbps = 0;
+
+    TEST_ESP_OK(esp_lcd_st7701_get_lane_bit_rate(test_dpi_config(), 2, 0, &min_mbps));
+
+    // A fixed rate is kept as long as it carries the video stream
+    bus_config.lane_bit_rate_mbps = min_mbps;
+    TEST_ESP_OK(esp_lcd_st7701_set_lane_bit_rate(&bus_config, test_dpi_config(), 20));
+    TEST_ASSERT_EQUAL(min_mbps, bus_config.lane_bit_rate_mbps);
+
+    bus_config.lane_bit_rate_mbps = min_mbps - 1;
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_st7701_set_lane_bit_rate(&bus_config, test_dpi_config(), 0));
+}
+
+static void test_lane_bit_rate_panel(void)
+{
+    uint32_t min_mbps = 0;
+    st7701_vendor_config_t vendor_config = {
+        .mipi_config = {
+            .dsi_bus = mock_dsi_bus(),
+            .dpi_config = test_dpi_config(),
+        },
+    };
+    const esp_lcd_panel_dev_config_t panel_config = {
+        .reset_gpio_num = -1,
+        .bits_per_pixel = 24,
+        .vendor_config = &vendor_config,
+    };
+    esp_lcd_panel_handle_t panel = NULL;
+
+    TEST_ESP_OK(esp_lcd_st7701_get_lane_bit_rate(test_dpi_config(), 2, 0, &min_mbps));
+
+    vendor_config.mipi_config.lane_bit_rate_mbps = min_mbps - 1;
+    TEST_ESP_ERR(ESP_ERR_INVALID_ARG, esp_lcd_new_panel_st7701(mock_panel_io(), &panel_config, &panel));
+    TEST_ASSERT_EQUAL(0, mock_dpi_num_panels());
+
+    vendor_config.mipi_config.lane_bit_rate_mbps = min_mbps;
+    TEST_ESP_OK(esp_lcd_new_panel_st7701(mock_panel_io(), &panel_config, &panel));
+    TEST_ESP_OK(esp_lcd_panel_del(panel));
+}
+
+int main(void)
+{
+    RUN_TEST(test_lane_bit_rate_filled_in);
+    RUN_TEST(test_lane_bit_rate_checked);
+    RUN_TEST(test_lane_bit_rate_panel);
+
+    return 0;
+}